@@ -0,0 +1,165 @@
+#include "asyncio.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "trace.h"
+
+namespace luteconv
+{
+
+AsyncIO::AsyncIO(int threads, size_t window, uint64_t maxBytes)
+: m_window{std::max<size_t>(window, 1)}, m_maxBytes{maxBytes}
+{
+    for (int i = 0; i < std::max(threads, 1); ++i)
+        m_threads.emplace_back(&AsyncIO::Run, this);
+}
+
+AsyncIO::~AsyncIO()
+{
+    Finish();
+}
+
+void AsyncIO::Prefetch(const std::vector<std::string>& filenames)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto & filename : filenames)
+        {
+            // a file given twice is read ahead once
+            if (m_reads.emplace(filename, ReadAhead()).second)
+                m_toRead.push_back(filename);
+        }
+    }
+    m_wake.notify_all();
+}
+
+bool AsyncIO::Take(const std::string& filename, std::vector<char>& image)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto it = m_reads.find(filename);
+    if (it == m_reads.end())
+        return false;
+
+    if (!it->second.m_started)
+    {
+        m_toRead.erase(std::find(m_toRead.begin(), m_toRead.end(), filename));
+        m_reads.erase(it);
+        return false;
+    }
+
+    ReadAhead& read = it->second;
+    m_readDone.wait(lock, [&read]() { return read.m_done; });
+    const bool ok{read.m_ok};
+    image = std::move(read.m_image);
+    m_reads.erase(filename);
+    --m_ahead;
+    lock.unlock();
+    m_wake.notify_one();
+    return ok;
+}
+
+void AsyncIO::Write(const std::string& filename, std::string&& image, const Done& done)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_writeTaken.wait(lock, [this]() { return m_writes.size() < m_window; });
+        m_writes.push_back(WriteBehind{filename, std::move(image), done});
+    }
+    m_wake.notify_one();
+}
+
+void AsyncIO::Finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto & thread : m_threads)
+        thread.join();
+    m_threads.clear();
+}
+
+void AsyncIO::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [this]()
+            {
+                return m_stop || !m_writes.empty() || (!m_toRead.empty() && m_ahead < m_window);
+            });
+
+        if (!m_writes.empty())
+        {
+            WriteBehind write{std::move(m_writes.front())};
+            m_writes.pop_front();
+            lock.unlock();
+            m_writeTaken.notify_one();
+            bool ok{false};
+            {
+                TRACE_SPAN("AsyncIO write", write.m_filename);
+                ok = WriteFile(write.m_filename, write.m_image);
+            }
+            write.m_done(ok ? "" : "Error: Can't write " + write.m_filename);
+            lock.lock();
+            continue;
+        }
+
+        // writes are complete, reads not taken are abandoned
+        if (m_stop)
+            return;
+
+        const std::string filename{m_toRead.front()};
+        m_toRead.pop_front();
+        ReadAhead& read = m_reads[filename];
+        read.m_started = true;
+        ++m_ahead;
+        lock.unlock();
+        std::vector<char> image;
+        bool ok{false};
+        {
+            TRACE_SPAN("AsyncIO read", filename);
+            ok = ReadFile(filename, m_maxBytes, image);
+        }
+        lock.lock();
+        read.m_image = std::move(image);
+        read.m_ok = ok;
+        read.m_done = true;
+        m_readDone.notify_all();
+    }
+}
+
+bool AsyncIO::ReadFile(const std::string& filename, uint64_t maxBytes, std::vector<char>& image)
+{
+    // a file over the limit is left for the conversion to reject
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0 || (maxBytes > 0 && static_cast<uint64_t>(st.st_size) > maxBytes))
+        return false;
+
+    std::ifstream src(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!src.is_open())
+        return false;
+
+    image.resize(static_cast<size_t>(st.st_size));
+    src.read(image.data(), static_cast<std::streamsize>(image.size()));
+    if (static_cast<size_t>(src.gcount()) != image.size() || src.peek() != std::ifstream::traits_type::eof())
+        return false;
+    return true;
+}
+
+bool AsyncIO::WriteFile(const std::string& filename, const std::string& image)
+{
+    std::ofstream dst(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!dst.is_open())
+        return false;
+
+    dst.write(image.data(), static_cast<std::streamsize>(image.size()));
+    dst.close();
+    return !dst.fail();
+}
+
+} // namespace luteconv
@@ -0,0 +1,123 @@
+#ifndef _ASYNCIO_H_
+#define _ASYNCIO_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace luteconv
+{
+
+/**
+ * Read files ahead of, and write files behind, the conversions of a batch on
+ * I/O threads, so that conversion threads do not wait on a slow filesystem.
+ *
+ * Reads are in the order given to Prefetch, at most a window of files ahead of
+ * those taken.  Queued writes go before reads as they free memory, and Write
+ * waits while a window of writes is queued.
+ */
+class AsyncIO
+{
+public:
+
+    /**
+     * Called on an I/O thread when a write completes
+     *
+     * @param[in] error "" => written, otherwise the error message
+     */
+    using Done = std::function<void(const std::string& error)>;
+
+    /**
+     * Constructor, starts the I/O threads
+     *
+     * @param[in] threads number of I/O threads, >= 1
+     * @param[in] window maximum number of files read and not yet taken, and of writes queued
+     * @param[in] maxBytes larger files are not read ahead, 0 => no limit
+     */
+    AsyncIO(int threads, size_t window, uint64_t maxBytes);
+
+    /**
+     * Destructor, see Finish()
+     */
+    ~AsyncIO();
+
+    AsyncIO(const AsyncIO&) = delete;
+    AsyncIO& operator=(const AsyncIO&) = delete;
+
+    /**
+     * Read files ahead, in this order
+     *
+     * @param[in] filenames
+     */
+    void Prefetch(const std::vector<std::string>& filenames);
+
+    /**
+     * Take a file read ahead, waiting for its read if in progress.  A file not
+     * yet started is no longer read ahead.
+     *
+     * @param[in] filename
+     * @param[out] image file contents
+     * @return true <=> read, false <=> not read ahead or the read failed, the
+     *         caller reads the file
+     */
+    bool Take(const std::string& filename, std::vector<char>& image);
+
+    /**
+     * Write a file behind, waiting while a window of writes is queued
+     *
+     * @param[in] filename
+     * @param[in] image file contents
+     * @param[in] done called when written
+     */
+    void Write(const std::string& filename, std::string&& image, const Done& done);
+
+    /**
+     * Complete all queued writes, abandon reads not taken, and stop the I/O threads
+     */
+    void Finish();
+
+private:
+    // A file read ahead
+    struct ReadAhead
+    {
+        bool m_started{false};
+        bool m_done{false};
+        bool m_ok{false};
+        std::vector<char> m_image;
+    };
+
+    // A file to write
+    struct WriteBehind
+    {
+        std::string m_filename;
+        std::string m_image;
+        Done m_done;
+    };
+
+    void Run();
+    static bool ReadFile(const std::string& filename, uint64_t maxBytes, std::vector<char>& image);
+    static bool WriteFile(const std::string& filename, const std::string& image);
+
+    const size_t m_window;
+    const uint64_t m_maxBytes;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;         // I/O threads
+    std::condition_variable m_readDone;     // Take
+    std::condition_variable m_writeTaken;   // Write
+    std::deque<std::string> m_toRead;
+    std::unordered_map<std::string, ReadAhead> m_reads;
+    size_t m_ahead{0};                      // reads started and not taken
+    std::deque<WriteBehind> m_writes;
+    bool m_stop{false};
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace luteconv
+
+#endif // _ASYNCIO_H_
@@ -0,0 +1,64 @@
+#include "cancel.h"
+
+namespace luteconv
+{
+
+Cancelled::Cancelled(bool timedOut)
+: std::runtime_error{timedOut ? "Error: Timed out" : "Error: Cancelled"}, m_timedOut{timedOut}
+{
+}
+
+thread_local Cancel* Cancel::m_current{nullptr};
+
+void Cancel::SetTimeout(double seconds)
+{
+    m_hasDeadline = seconds > 0.0;
+    if (m_hasDeadline)
+        m_deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void Cancel::Request()
+{
+    m_requested.store(true, std::memory_order_relaxed);
+}
+
+bool Cancel::Requested() const
+{
+    return m_requested.load(std::memory_order_relaxed);
+}
+
+bool Cancel::Expired() const
+{
+    return m_hasDeadline && std::chrono::steady_clock::now() >= m_deadline;
+}
+
+void Cancel::Check()
+{
+    const Cancel* const cancel = m_current;
+    if (cancel == nullptr)
+        return;
+
+    if (cancel->Requested())
+        throw Cancelled(false);
+    if (cancel->Expired())
+        throw Cancelled(true);
+}
+
+Cancel* Cancel::Current()
+{
+    return m_current;
+}
+
+CancelScope::CancelScope(Cancel* cancel)
+: m_previous{Cancel::m_current}
+{
+    Cancel::m_current = cancel;
+}
+
+CancelScope::~CancelScope()
+{
+    Cancel::m_current = m_previous;
+}
+
+} // namespace luteconv
@@ -0,0 +1,132 @@
+#ifndef _CANCEL_H_
+#define _CANCEL_H_
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+namespace luteconv
+{
+
+/**
+ * Thrown by Cancel::Check when a conversion is cancelled or passes its deadline
+ */
+class Cancelled: public std::runtime_error
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] timedOut true => deadline passed, false => cancelled
+     */
+    explicit Cancelled(bool timedOut);
+
+    /**
+     * Destructor
+     */
+    ~Cancelled() override = default;
+
+    const bool m_timedOut;
+};
+
+/**
+ * Cancellation of a conversion, on request or at a deadline.
+ * Parsers and generators call Check() once per bar, so a conversion stops
+ * within a bar of being cancelled.
+ */
+class Cancel
+{
+public:
+
+    /**
+     * Constructor, no deadline
+     */
+    Cancel() = default;
+
+    /**
+     * Destructor
+     */
+    ~Cancel() = default;
+
+    Cancel(const Cancel&) = delete;
+    Cancel& operator=(const Cancel&) = delete;
+
+    /**
+     * Set the deadline, before the conversion starts
+     *
+     * @param[in] seconds from now, 0 => no deadline
+     */
+    void SetTimeout(double seconds);
+
+    /**
+     * Request cancellation, from any thread
+     */
+    void Request();
+
+    /**
+     * Has cancellation been requested
+     *
+     * @return true <=> requested
+     */
+    bool Requested() const;
+
+    /**
+     * Has the deadline passed
+     *
+     * @return true <=> passed
+     */
+    bool Expired() const;
+
+    /**
+     * Throw if the calling thread's conversion is cancelled or has passed its deadline.
+     * Does nothing if the thread has no Cancel, see CancelScope.
+     *
+     * @throws Cancelled
+     */
+    static void Check();
+
+    /**
+     * Cancel of the calling thread
+     *
+     * @return cancel, nullptr => none
+     */
+    static Cancel* Current();
+
+private:
+    friend class CancelScope;
+
+    std::atomic<bool> m_requested{false};
+    bool m_hasDeadline{false};
+    std::chrono::steady_clock::time_point m_deadline;
+    static thread_local Cancel* m_current;
+};
+
+/**
+ * Make a Cancel the calling thread's for the lifetime of this object
+ */
+class CancelScope
+{
+public:
+
+    /**
+     * Constructor
+     *
+     * @param[in] cancel nullptr => none
+     */
+    explicit CancelScope(Cancel* cancel);
+
+    /**
+     * Destructor, restores the thread's previous Cancel
+     */
+    ~CancelScope();
+
+    CancelScope(const CancelScope&) = delete;
+    CancelScope& operator=(const CancelScope&) = delete;
+
+private:
+    Cancel* const m_previous;
+};
+
+} // namespace luteconv
+
+#endif // _CANCEL_H_
@@ -0,0 +1,68 @@
+#include "chordcache.h"
+
+#include <sstream>
+
+#include "logger.h"
+#include "parallel.h"
+
+namespace luteconv
+{
+
+size_t ChordCache::Hits() const
+{
+    return m_hits;
+}
+
+size_t ChordCache::Misses() const
+{
+    return m_misses;
+}
+
+void ChordCache::LogStats(const char* generator, const std::vector<ChordCache>& caches)
+{
+    size_t hits{0};
+    size_t misses{0};
+    for (const auto & cache : caches)
+    {
+        hits += cache.m_hits;
+        misses += cache.m_misses;
+    }
+    
+    if (hits + misses > 0)
+    {
+        LOGGER_DEBUG << generator << " chord cache: " << hits << " hits, " << misses << " misses, "
+               << (100 * hits) / (hits + misses) << "% hit rate";
+    }
+}
+
+std::vector<std::string> ChordCache::RenderRanges(const char* generator, size_t count, int jobs,
+        const std::function<void(size_t, size_t, ChordCache&, std::ostream&)>& render)
+{
+    const size_t ranges = Parallel::Ranges(count, jobs);
+    std::vector<std::string> rendered(ranges);
+    std::vector<ChordCache> caches(ranges);
+    Parallel::ForRanges(count, jobs, [&](size_t range, size_t begin, size_t end)
+        {
+            std::ostringstream ss;
+            render(begin, end, caches[range], ss);
+            rendered[range] = ss.str();
+        });
+    LogStats(generator, caches);
+    return rendered;
+}
+
+void ChordCache::MakeKey(const Chord& chord, std::string_view context)
+{
+    // Notes are interned, so the shape id identifies them.  The context
+    // is last as it has a variable length.
+    m_key.clear();
+    m_key.append(reinterpret_cast<const char*>(&chord.m_shape), sizeof(chord.m_shape));
+    m_key += static_cast<char>(chord.m_noteType);
+    m_key += static_cast<char>(chord.m_grid);
+    m_key += static_cast<char>(chord.m_dotted);
+    m_key += static_cast<char>(chord.m_fermata);
+    m_key += static_cast<char>(chord.m_noFlag);
+    m_key += context;
+}
+
+} // namespace luteconv
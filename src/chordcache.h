@@ -0,0 +1,103 @@
+#ifndef _CHORDCACHE_H_
+#define _CHORDCACHE_H_
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "piece.h"
+
+namespace luteconv
+{
+
+/**
+ * Rendered chords, keyed on everything that affects their rendering.
+ * 
+ * Lute music repeats the same chord shapes and rhythms constantly, a
+ * generator renders each distinct chord once and replays the text thereafter.
+ * Not thread safe, use one cache per thread.  Shapes are those of one piece.
+ */
+class ChordCache
+{
+public:
+
+    /**
+     * Constructor
+     */
+    ChordCache() = default;
+
+    /**
+     * Destructor
+     */
+    ~ChordCache() = default;
+    
+    /**
+     * Get the rendering of a chord, rendering it on a miss
+     * 
+     * @param[in] chord
+     * @param[in] context anything else that affects the rendering, e.g. flags
+     *                    that depend on the neighbouring chords
+     * @param[in] render called as render() on a miss, returns the rendering
+     * @return rendering
+     */
+    template <typename Render>
+    const std::string& Get(const Chord& chord, std::string_view context, Render render)
+    {
+        MakeKey(chord, context);
+        const auto it = m_cache.find(m_key);
+        if (it != m_cache.end())
+        {
+            ++m_hits;
+            return it->second;
+        }
+        
+        ++m_misses;
+        return m_cache.emplace(m_key, render()).first->second;
+    }
+    
+    /**
+     * @return number of chords found in the cache
+     */
+    size_t Hits() const;
+    
+    /**
+     * @return number of chords rendered
+     */
+    size_t Misses() const;
+    
+    /**
+     * Log the combined hit rate of caches
+     * 
+     * @param[in] generator name of the generator
+     * @param[in] caches
+     */
+    static void LogStats(const char* generator, const std::vector<ChordCache>& caches);
+    
+    /**
+     * Render bars in contiguous ranges, concurrently, see Parallel::ForRanges.
+     * Each range has its own cache, their combined hit rate is logged.
+     * 
+     * @param[in] generator name of the generator
+     * @param[in] count number of bars
+     * @param[in] jobs number of threads, 0 => one per hardware thread
+     * @param[in] render called as render(begin, end, cache, dst) to render bars [begin, end)
+     * @return rendering of each range, in order
+     */
+    static std::vector<std::string> RenderRanges(const char* generator, size_t count, int jobs,
+            const std::function<void(size_t, size_t, ChordCache&, std::ostream&)>& render);
+    
+private:
+    void MakeKey(const Chord& chord, std::string_view context);
+    
+    std::unordered_map<std::string, std::string> m_cache;
+    std::string m_key; // reused to avoid an allocation per lookup
+    size_t m_hits{0};
+    size_t m_misses{0};
+};
+
+} // namespace luteconv
+
+#endif // _CHORDCACHE_H_
@@ -13,17 +13,177 @@
 #include "genmxl.h"
 #include "gentab.h"
 #include "gentabcode.h"
+#include "logger.h"
 #include "piece.h"
+#include "pieceinfo.h"
+#include "trace.h"
+#include "unzipper.h"
 
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
 
+#include <sys/stat.h>
+
 namespace luteconv
 {
 
 void Converter::Convert(const Options& options)
 {
+    Convert(options, nullptr, nullptr, nullptr);
+}
+
+void Converter::Convert(const Options& options, Stats& stats)
+{
+    stats.Start(options.m_srcFilename, options.m_dstFilename);
+    try
+    {
+        Convert(options, nullptr, nullptr, &stats);
+    }
+    catch (...)
+    {
+        stats.Stop();
+        throw;
+    }
+    stats.Stop();
+}
+
+bool Converter::Convert(const Options& options, std::vector<char>& srcImage, std::string& dstImage, Stats* stats)
+{
+    // a zip archive is written by libzip, to the destination file
+    const bool toImage{options.m_dstFormat != FormatMxl};
+    std::ostringstream dst;
+    if (stats == nullptr)
+    {
+        Convert(options, &srcImage, toImage ? &dst : nullptr, nullptr);
+    }
+    else
+    {
+        stats->Start(options.m_srcFilename, options.m_dstFilename);
+        try
+        {
+            Convert(options, &srcImage, toImage ? &dst : nullptr, stats);
+        }
+        catch (...)
+        {
+            stats->Stop();
+            throw;
+        }
+        stats->Stop();
+    }
+    
+    if (!toImage)
+        return false;
+    
+    dstImage = dst.str();
+    if (stats != nullptr)
+        stats->m_bytesOut = dstImage.size();
+    return true;
+}
+
+void Converter::Convert(const Options& options, std::vector<char>* srcImage, std::ostream* dst, Stats* stats)
+{
+    TRACE_SPAN("Converter::Convert", options.m_srcFilename);
+    // conversions may run concurrently, logging is set per conversion
+    LoggerScope loggerScope(options.m_logLevel, options.m_logFilter);
     Piece piece;
     
+    struct stat st;
+    if (srcImage != nullptr)
+        options.m_limits.CheckInput(options.m_srcFilename, srcImage->size());
+    else if (stat(options.m_srcFilename.c_str(), &st) == 0)
+        options.m_limits.CheckInput(options.m_srcFilename, static_cast<uint64_t>(st.st_size));
+    
+    if (options.Passthrough())
+    {
+        Passthrough(options, srcImage, dst);
+        return;
+    }
+    
+    {
+        StatsScope statsScope("parse");
+        if (srcImage != nullptr)
+            Parse(options, *srcImage, piece);
+        else
+            Parse(options, piece);
+    }
+    options.m_limits.CheckPiece(piece);
+    
+    if (stats != nullptr)
+        stats->Count(piece);
+    
+    StatsScope statsScope("generate");
+    if (dst != nullptr)
+        Generate(options, piece, *dst);
+    else
+        Generate(options, piece);
+}
+
+void Converter::Info(const Options& options, PieceInfo& info)
+{
+    TRACE_SPAN("Converter::Info", options.m_srcFilename);
+    LoggerScope loggerScope(options.m_logLevel, options.m_logFilter);
+    info.m_srcFilename = options.m_srcFilename;
+    
+    struct stat st;
+    if (stat(options.m_srcFilename.c_str(), &st) == 0)
+        options.m_limits.CheckInput(options.m_srcFilename, static_cast<uint64_t>(st.st_size));
+    
+    // interning the chords is most of the work of a parser, skip it
+    Piece piece;
+    piece.m_chords = ChordTable(true);
+    {
+        StatsScope statsScope("parse");
+        Parse(options, piece);
+    }
+    info.Set(piece);
+}
+
+void Converter::Passthrough(const Options& options, const std::vector<char>* srcImage, std::ostream* dst)
+{
+    TRACE_SPAN("Converter::Passthrough");
+    StatsScope statsScope("passthrough");
+    
+    if (options.m_dstFormat == FormatMxl)
+    {
+        std::string musicxml;
+        if (srcImage != nullptr)
+        {
+            musicxml.assign(srcImage->cbegin(), srcImage->cend());
+        }
+        else
+        {
+            std::ifstream src(options.m_srcFilename.c_str(), std::ios::in | std::ios::binary);
+            struct stat st;
+            if (!src.is_open() || stat(options.m_srcFilename.c_str(), &st) != 0)
+                throw std::runtime_error(std::string("Error: Can't open ") + options.m_srcFilename);
+            musicxml.resize(static_cast<size_t>(st.st_size));
+            src.read(&musicxml[0], static_cast<std::streamsize>(musicxml.size()));
+            musicxml.resize(static_cast<size_t>(src.gcount()));
+        }
+        GenMxl::Zip(options, musicxml);
+        return;
+    }
+    
+    // the archive's file, as is
+    std::ofstream file;
+    if (dst == nullptr)
+    {
+        file.open(options.m_dstFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error(std::string("Error: Can't open ") + options.m_dstFilename);
+        dst = &file;
+    }
+    
+    std::string zipFilename;
+    if (srcImage != nullptr)
+        Unzipper::Unzip(options.m_srcFilename, *srcImage, *dst, zipFilename, options.m_limits);
+    else
+        Unzipper::Unzip(options.m_srcFilename, *dst, zipFilename, options.m_limits);
+}
+
+void Converter::Parse(const Options& options, Piece& piece)
+{
     switch (options.m_srcFormat)
     {
     case FormatUnknown:
@@ -32,48 +192,56 @@ void Converter::Convert(const Options& options)
     }
     case FormatFt3:
     {
+        TRACE_SPAN("ParserFt3::Parse");
         ParserFt3 parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatJtxml:
     {
+        TRACE_SPAN("ParserJtxml::Parse");
         ParserJtxml parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatJtz:
     {
+        TRACE_SPAN("ParserJtz::Parse");
         ParserJtz parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatMei:
     {
+        TRACE_SPAN("ParserMei::Parse");
         ParserMei parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatMusicxml:
     {
+        TRACE_SPAN("ParserMusicXml::Parse");
         ParserMusicXml parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatMxl:
     {
+        TRACE_SPAN("ParserMxl::Parse");
         ParserMxl parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatTab:
     {
+        TRACE_SPAN("ParserTab::Parse");
         ParserTab parser;
         parser.Parse(options, piece);
         break;
     }
     case FormatTabCode:
     {
+        TRACE_SPAN("ParserTabCode::Parse");
         ParserTabCode parser;
         parser.Parse(options, piece);
         break;
@@ -83,7 +251,80 @@ void Converter::Convert(const Options& options)
         throw std::runtime_error(std::string("Error: source file format not supported: ") + options.m_srcFilename);
     }
     }
-    
+}
+
+void Converter::Parse(const Options& options, std::vector<char>& image, Piece& piece)
+{
+    switch (options.m_srcFormat)
+    {
+    case FormatFt3:
+    {
+        TRACE_SPAN("ParserFt3::Parse");
+        std::vector<uint8_t> ft3Image;
+        ParserFt3::Gunzip(options.m_srcFilename, image, ft3Image, options.m_limits);
+        ParserFt3 parser;
+        parser.Parse(ft3Image, options, piece);
+        break;
+    }
+    case FormatJtxml:
+    {
+        TRACE_SPAN("ParserJtxml::Parse");
+        ParserJtxml parser;
+        parser.Parse(options.m_srcFilename, image.data(), image.size(), options, piece);
+        break;
+    }
+    case FormatMei:
+    {
+        TRACE_SPAN("ParserMei::Parse");
+        ParserMei parser;
+        parser.Parse(options.m_srcFilename, image.data(), image.size(), options, piece);
+        break;
+    }
+    case FormatMusicxml:
+    {
+        TRACE_SPAN("ParserMusicXml::Parse");
+        ParserMusicXml parser;
+        parser.Parse(options.m_srcFilename, image.data(), image.size(), options, piece);
+        break;
+    }
+    case FormatTab:
+    {
+        TRACE_SPAN("ParserTab::Parse");
+        ParserTab parser;
+        parser.Parse(std::string_view(image.data(), image.size()), options, piece);
+        break;
+    }
+    case FormatTabCode:
+    {
+        TRACE_SPAN("ParserTabCode::Parse");
+        ParserTabCode parser;
+        parser.Parse(std::string_view(image.data(), image.size()), options, piece);
+        break;
+    }
+    case FormatJtz:
+    {
+        TRACE_SPAN("ParserJtz::Parse");
+        ParserJtz parser;
+        parser.Parse(options, image, piece);
+        break;
+    }
+    case FormatMxl:
+    {
+        TRACE_SPAN("ParserMxl::Parse");
+        ParserMxl parser;
+        parser.Parse(options, image, piece);
+        break;
+    }
+    default:
+    {
+        Parse(options, piece);
+        break;
+    }
+    }
+}
+
+void Converter::Generate(const Options& options, const Piece& piece)
+{
     switch (options.m_dstFormat)
     {
     case FormatUnknown:
@@ -92,30 +333,35 @@ void Converter::Convert(const Options& options)
     }
     case FormatMei:
     {
+        TRACE_SPAN("GenMei::Generate");
         GenMei generator;
         generator.Generate(options, piece);
         break;
     }
     case FormatMusicxml:
     {
+        TRACE_SPAN("GenMusicXml::Generate");
         GenMusicXml generator;
         generator.Generate(options, piece);
         break;
     }
     case FormatMxl:
     {
+        TRACE_SPAN("GenMxl::Generate");
         GenMxl generator;
         generator.Generate(options, piece);
         break;
     }
     case FormatTab:
     {
+        TRACE_SPAN("GenTab::Generate");
         GenTab generator;
         generator.Generate(options, piece);
         break;
     }
     case FormatTabCode:
     {
+        TRACE_SPAN("GenTabCode::Generate");
         GenTabCode generator;
         generator.Generate(options, piece);
         break;
@@ -127,4 +373,44 @@ void Converter::Convert(const Options& options)
     }
 }
 
+void Converter::Generate(const Options& options, const Piece& piece, std::ostream& dst)
+{
+    switch (options.m_dstFormat)
+    {
+    case FormatMei:
+    {
+        TRACE_SPAN("GenMei::Generate");
+        GenMei generator;
+        generator.Generate(options, piece, dst);
+        break;
+    }
+    case FormatMusicxml:
+    {
+        TRACE_SPAN("GenMusicXml::Generate");
+        GenMusicXml generator;
+        generator.Generate(options, piece, dst);
+        break;
+    }
+    case FormatTab:
+    {
+        TRACE_SPAN("GenTab::Generate");
+        GenTab generator;
+        generator.Generate(options, piece, dst);
+        break;
+    }
+    case FormatTabCode:
+    {
+        TRACE_SPAN("GenTabCode::Generate");
+        GenTabCode generator;
+        generator.Generate(options, piece, dst);
+        break;
+    }
+    default:
+    {
+        Generate(options, piece);
+        break;
+    }
+    }
+}
+
 } // namespace luteconv
@@ -2,10 +2,18 @@
 #define _CONVERTER_H_
 
 #include "options.h"
+#include "stats.h"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
 
 namespace luteconv
 {
 
+class Piece;
+class PieceInfo;
+
 /**
  * Convert lute tablature formats
  */
@@ -23,11 +31,52 @@ public:
     ~Converter() = default;
     
     /**
-     * Covert lute tablature from src to destination format
+     * Covert lute tablature from src to destination format.
+     * Conversions on separate threads may run concurrently.
      * 
      * @param[in] options
      */
     void Convert(const Options& options);
+    
+    /**
+     * Covert lute tablature from src to destination format, and collect
+     * timing and resource statistics.
+     * 
+     * @param[in] options
+     * @param[out] stats
+     */
+    void Convert(const Options& options, Stats& stats);
+    
+    /**
+     * Covert a source file already read into memory, to a destination image
+     * for the caller to write.  mxl, a zip archive, is written to the destination
+     * file and dstImage left empty.
+     * 
+     * @param[in] options
+     * @param[in,out] srcImage source file contents, xml is parsed in place
+     * @param[out] dstImage destination file contents
+     * @param[out] stats nullptr => none
+     * @return true <=> dstImage to be written, false <=> destination file written
+     */
+    bool Convert(const Options& options, std::vector<char>& srcImage, std::string& dstImage, Stats* stats);
+    
+    /**
+     * Read the metadata of the source file, without converting it, see option
+     * --info.  The body is skimmed: the bars are counted and the highest course
+     * found for the tuning, but the chords are not kept.
+     * 
+     * @param[in] options
+     * @param[out] info
+     */
+    void Info(const Options& options, PieceInfo& info);
+    
+private:
+    void Convert(const Options& options, std::vector<char>* srcImage, std::ostream* dst, Stats* stats);
+    static void Passthrough(const Options& options, const std::vector<char>* srcImage, std::ostream* dst);
+    static void Parse(const Options& options, Piece& piece);
+    static void Parse(const Options& options, std::vector<char>& image, Piece& piece);
+    static void Generate(const Options& options, const Piece& piece);
+    static void Generate(const Options& options, const Piece& piece, std::ostream& dst);
 };
 
 
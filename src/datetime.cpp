@@ -0,0 +1,29 @@
+#include "datetime.h"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+namespace luteconv
+{
+
+std::string DateTime::Now(const char* format)
+{
+    const std::tm tm = GmTime(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+    std::ostringstream ss;
+    ss << std::put_time(&tm, format);
+    return ss.str();
+}
+
+std::tm DateTime::GmTime(std::time_t tt)
+{
+    std::tm tm{};
+#if defined(_WIN32) || defined(_WIN64)
+    gmtime_s(&tm, &tt);
+#else
+    gmtime_r(&tt, &tm);
+#endif
+    return tm;
+}
+
+} // namespace luteconv
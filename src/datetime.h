@@ -0,0 +1,47 @@
+#ifndef _DATETIME_H_
+#define _DATETIME_H_
+
+#include <ctime>
+#include <string>
+
+namespace luteconv
+{
+
+/**
+ * Thread safe date and time formatting
+ */
+class DateTime
+{
+public:
+    
+    /**
+     * Constructor
+     */
+    DateTime() = default;
+    
+    /**
+     * Destructor
+     */
+    ~DateTime() = default;
+    
+    /**
+     * Format the current UTC time
+     * 
+     * @param[in] format as std::put_time, e.g. "%F"
+     * @return formatted time
+     */
+    static std::string Now(const char* format);
+    
+    /**
+     * Convert to UTC broken down time.  Unlike std::gmtime the
+     * result is not shared between threads.
+     * 
+     * @param[in] tt
+     * @return broken down time
+     */
+    static std::tm GmTime(std::time_t tt);
+};
+
+} // namespace luteconv
+
+#endif // _DATETIME_H_
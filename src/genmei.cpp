@@ -1,15 +1,19 @@
 #include "genmei.h"
 
 #include <string>
-#include <ctime>
-#include <chrono>
-#include <iomanip>
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "cancel.h"
+#include "datetime.h"
 #include "mei.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -59,6 +63,8 @@ void GenMei::Generate(const Options& options, const Piece& piece, std::ostream&
     xmlmusic->Add(xmlBody);
     Body(xmlBody, options, piece);
     
+    StatsScope statsScope("write");
+    TRACE_SPAN("GenMei write");
     dst << xmlwriter;
 }
 
@@ -82,12 +88,7 @@ void GenMei::EncodingDesc(XMLElement* xmlEncodingDesc, const Options& options)
     XMLElement* xmlapplication = new XMLElement("application");
     xmlappInfo->Add(xmlapplication);
     
-    std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    struct std::tm * ptm = std::gmtime(&tt);
-    std::ostringstream ss;
-    ss << std::put_time(ptm,"%F");
-    
-    xmlapplication->AddAttrib("isodate", ss.str().c_str());
+    xmlapplication->AddAttrib("isodate", DateTime::Now("%F").c_str());
     xmlapplication->AddAttrib("version", options.m_version.c_str());
     xmlapplication->Add(new XMLElement("name", "luteconv"));
 }
@@ -205,79 +206,150 @@ void GenMei::Body(XMLElement* xmlbody, const Options& options, const Piece& piec
     
 void GenMei::Section(XMLElement* xmlsection, const Options& options, const Piece& piece)
 {
-    for (const auto & bar : piece.m_bars)
+    // xml:ids are numbered in bar order, the first id of each bar is
+    // a prefix sum of the number of fingered notes in the preceding bars
+    const size_t count = piece.m_bars.size();
+    std::vector<int> firstId(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        firstId[i] = m_nextId;
+        for (const auto & chord : piece.m_bars[i].m_chords)
+        {
+            const std::vector<Note>& notes = piece.Notes(chord);
+            m_nextId += std::count_if(notes.begin(), notes.end(), [](const Note& note)
+                {
+                    return note.m_leftFingering != FingerNone || note.m_rightFingering != FingerNone;
+                });
+        }
+    }
+    
+    // Measures are rendered in contiguous ranges, concurrently, then added in order.
+    // Bars are rendered concurrently in contiguous ranges, one string per range.
+    std::vector<std::string> rendered;
     {
-        const int barNo = std::distance(&piece.m_bars.front(), &bar) + 1;
-        XMLElement* xmlmeasure = new XMLElement("measure");
-        xmlsection->Add(xmlmeasure);
-        xmlmeasure->AddAttrib("n", barNo);
+        StatsScope statsScope("render");
+        TRACE_SPAN("GenMei render");
+        rendered = ChordCache::RenderRanges("GenMei", count, options.m_jobs,
+            [&](size_t begin, size_t end, ChordCache& cache, std::ostream& ss)
+            {
+                int nextId{firstId[begin]};
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Cancel::Check();
+                    const std::unique_ptr<XMLElement> xmlmeasure{Measure(options, piece, piece.m_bars[i], i + 1, nextId, cache)};
+                    if (i > begin)
+                        ss << "\n";
+                    xmlmeasure->Print(ss, measureLevel);
+                }
+            });
+    }
+    
+    for (auto & range : rendered)
+    {
+        if (!range.empty())
+            xmlsection->Add(new XMLFragment(std::move(range)));
+    }
+}
+
+XMLElement* GenMei::Measure(const Options& options, const Piece& piece, const Bar& bar, int barNo, int& nextId,
+                            ChordCache& cache)
+{
+    XMLElement* xmlmeasure = new XMLElement("measure");
+    xmlmeasure->AddAttrib("n", barNo);
+    
+    XMLElement* xmlstaff = new XMLElement("staff");
+    xmlmeasure->Add(xmlstaff);
+    xmlstaff->AddAttrib("n", 1);
+    
+    XMLElement* xmllayer = new XMLElement("layer");
+    xmlstaff->Add(xmllayer);
+    xmllayer->AddAttrib("n", 1);
+    
+    for (auto & chord : bar.m_chords)
+    {
+        const std::vector<Note>& notes = piece.Notes(chord);
+        const bool fingered = std::any_of(notes.begin(), notes.end(), [](const Note& note)
+            {
+                return note.m_leftFingering != FingerNone || note.m_rightFingering != FingerNone;
+            });
         
-        XMLElement* xmlstaff = new XMLElement("staff");
-        xmlmeasure->Add(xmlstaff);
-        xmlstaff->AddAttrib("n", 1);
+        if (fingered)
+        {
+            // unique xml:ids, and <fing> elements in the measure, can't be cached
+            xmllayer->Add(TabGrp(options, piece, chord, xmlmeasure, nextId));
+        }
+        else
+        {
+            xmllayer->Add(new XMLFragment(cache.Get(chord, "", [&]()
+                {
+                    const std::unique_ptr<XMLElement> xmltabGrp{TabGrp(options, piece, chord, xmlmeasure, nextId)};
+                    std::ostringstream ss;
+                    xmltabGrp->Print(ss, tabGrpLevel);
+                    return ss.str();
+                })));
+        }
+    }
+    
+    return xmlmeasure;
+}
+
+XMLElement* GenMei::TabGrp(const Options& options, const Piece& piece, const Chord& chord, XMLElement* xmlmeasure, int& nextId)
+{
+    XMLElement* xmltabGrp = new XMLElement("tabGrp");
+    
+    // mei has quater note = 1 flag
+    NoteType adjusted{static_cast<NoteType>(chord.m_noteType - 1 + options.m_flags)};
+    adjusted = std::max(NoteTypeWhole, adjusted);
+    adjusted = std::min(NoteType256th, adjusted);
+    const int durGes = (1 << (adjusted - NoteTypeWhole));
+    xmltabGrp->AddAttrib("dur.ges", durGes);
+    
+    if (chord.m_dotted)
+        xmltabGrp->AddAttrib("dots", 1);
+    
+    XMLElement* xmltabRhythm = new XMLElement("tabRhythm");
+    xmltabGrp->Add(xmltabRhythm);
+    
+    for (const auto & note : piece.Notes(chord))
+    {
+        XMLElement* xmlnote = new XMLElement("note");
+        xmltabGrp->Add(xmlnote);
         
-        XMLElement* xmllayer = new XMLElement("layer");
-        xmlstaff->Add(xmllayer);
-        xmllayer->AddAttrib("n", 1);
+        xmlnote->AddAttrib("tab.course", note.m_string);
+        xmlnote->AddAttrib("tab.fret", note.m_fret);
         
-        for (auto & chord : bar.m_chords)
+        // fingering
+        // <fing playingHand='right' playingFinger='1' startid='m3.n6'/>
+        if (note.m_leftFingering != FingerNone || note.m_rightFingering != FingerNone)
         {
-            XMLElement* xmltabGrp = new XMLElement("tabGrp");
-            xmllayer->Add(xmltabGrp);
-            
-            // mei has quater note = 1 flag
-            NoteType adjusted{static_cast<NoteType>(chord.m_noteType - 1 + options.m_flags)};
-            adjusted = std::max(NoteTypeWhole, adjusted);
-            adjusted = std::min(NoteType256th, adjusted);
-            const int durGes = (1 << (adjusted - NoteTypeWhole));
-            xmltabGrp->AddAttrib("dur.ges", durGes);
-            
-            if (chord.m_dotted)
-                xmltabGrp->AddAttrib("dots", 1);
-            
-            XMLElement* xmltabRhythm = new XMLElement("tabRhythm");
-            xmltabGrp->Add(xmltabRhythm);
+            const std::string id = MakeId(nextId);
+            xmlnote->AddAttrib("xml:id", id.c_str());
             
-            for (const auto & note : chord.m_notes)
+            if (note.m_leftFingering != FingerNone)
             {
-                XMLElement* xmlnote = new XMLElement("note");
-                xmltabGrp->Add(xmlnote);
-                
-                xmlnote->AddAttrib("tab.course", note.m_string);
-                xmlnote->AddAttrib("tab.fret", note.m_fret);
-                
-                // fingering
-                // <fing playingHand='right' playingFinger='1' startid='m3.n6'/>
-                if (note.m_leftFingering != FingerNone || note.m_rightFingering != FingerNone)
-                {
-                    const std::string id = MakeId();
-                    xmlnote->AddAttrib("xml:id", id.c_str());
-                    
-                    if (note.m_leftFingering != FingerNone)
-                    {
-                        XMLElement* xmlfing = new XMLElement("fing");
-                        xmlmeasure->Add(xmlfing);
-                        xmlfing->AddAttrib("playingHand", "left");
-                        xmlfing->AddAttrib("playingFinger", Mei::fingering[note.m_leftFingering]);
-                        xmlfing->AddAttrib("startid", ("#" + id).c_str());
-                    }
-                    if (note.m_rightFingering != FingerNone)
-                    {
-                        XMLElement* xmlfing = new XMLElement("fing");
-                        xmlmeasure->Add(xmlfing);
-                        xmlfing->AddAttrib("playingHand", "right");
-                        xmlfing->AddAttrib("playingFinger", Mei::fingering[note.m_rightFingering]);
-                        xmlfing->AddAttrib("startid", ("#" + id).c_str());
-                    }
-                }
+                XMLElement* xmlfing = new XMLElement("fing");
+                xmlmeasure->Add(xmlfing);
+                xmlfing->AddAttrib("playingHand", "left");
+                xmlfing->AddAttrib("playingFinger", Mei::fingering[note.m_leftFingering]);
+                xmlfing->AddAttrib("startid", ("#" + id).c_str());
+            }
+            if (note.m_rightFingering != FingerNone)
+            {
+                XMLElement* xmlfing = new XMLElement("fing");
+                xmlmeasure->Add(xmlfing);
+                xmlfing->AddAttrib("playingHand", "right");
+                xmlfing->AddAttrib("playingFinger", Mei::fingering[note.m_rightFingering]);
+                xmlfing->AddAttrib("startid", ("#" + id).c_str());
             }
         }
     }
+    
+    return xmltabGrp;
 }
 
-std::string GenMei::MakeId()
+std::string GenMei::MakeId(int& nextId)
 {
-    return "id" + std::to_string(m_nextId++); 
+    return "id" + std::to_string(nextId++); 
 }
 
 void GenMei::AddTimeSignature(XMLElement* xmlmensur, const TimeSig& timeSig)
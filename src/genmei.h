@@ -3,6 +3,7 @@
 
 #include <iostream>
 
+#include "chordcache.h"
 #include "xmlwriter.h"
 #include "piece.h"
 #include "options.h"
@@ -44,12 +45,18 @@ public:
     void Generate(const Options& options, const Piece& piece, std::ostream& dst);
     
 private:
+    static const int measureLevel = 6; // mei/music/body/mdiv/score/section/measure
+    static const int tabGrpLevel = measureLevel + 3; // measure/staff/layer/tabGrp
+    
     void FileDesc(XMLElement* xmlfileDesc, const Piece& piece);
     void EncodingDesc(XMLElement* xmlEncodingDesc, const Options& options);
     void Work(XMLElement* xmlwork, const Piece& piece);
     void Body(XMLElement* xmlbody, const Options& options, const Piece& piece);
     void Section(XMLElement* xmlsection, const Options& options, const Piece& piece);
-    std::string MakeId();
+    XMLElement* Measure(const Options& options, const Piece& piece, const Bar& bar, int barNo, int& nextId,
+                        ChordCache& cache);
+    static XMLElement* TabGrp(const Options& options, const Piece& piece, const Chord& chord, XMLElement* xmlmeasure, int& nextId);
+    static std::string MakeId(int& nextId);
     void AddTimeSignature(XMLElement* xmlmensur, const TimeSig& timeSig);
     
     int m_nextId{0};
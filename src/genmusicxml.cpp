@@ -1,15 +1,19 @@
 #include "genmusicxml.h"
 
 #include <string>
-#include <ctime>
-#include <chrono>
-#include <iomanip>
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "cancel.h"
+#include "datetime.h"
 #include "musicxml.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -34,9 +38,6 @@ void GenMusicXml::Generate(const Options& options, const Piece& piece, std::ostr
         throw std::runtime_error("Error: MusicXML does not support german tablature");
     }
     
-    std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    struct std::tm * ptm = std::gmtime(&tt);
-
     XMLWriter xmlwriter;
     xmlwriter.AddDoctype(doctype);
     xmlwriter.SetRoot(new XMLElement("score-partwise"));
@@ -74,11 +75,7 @@ void GenMusicXml::Generate(const Options& options, const Piece& piece, std::ostr
     encoding->Add(new XMLElement("software", ("luteconv " + options.m_version).c_str()));
     
     // encoding-date
-    {
-        std::ostringstream ss;
-        ss << std::put_time(ptm,"%F");
-        encoding->Add(new XMLElement("encoding-date", ss.str().c_str()));
-    }
+    encoding->Add(new XMLElement("encoding-date", DateTime::Now("%F").c_str()));
     identification->Add(encoding);
     xmlwriter.Root()->Add(identification);
     
@@ -146,15 +143,40 @@ void GenMusicXml::Generate(const Options& options, const Piece& piece, std::ostr
     XMLElement* part = new XMLElement("part");
 
     part->AddAttrib("id", "P1");
-        
-    const int count = piece.m_bars.size();
-    bool repForward{false};
-    for (int i = 0; i < count; i++)
+    
+    // Bars are rendered concurrently in contiguous ranges, one string per range.
+    const size_t count = piece.m_bars.size();
+    std::vector<std::string> rendered;
     {
-        part->Add(Measure(piece, piece.m_bars[i], i + 1, repForward, options));
+        StatsScope statsScope("render");
+        TRACE_SPAN("GenMusicXml render");
+        rendered = ChordCache::RenderRanges("GenMusicXml", count, options.m_jobs,
+            [&](size_t begin, size_t end, ChordCache& cache, std::ostream& ss)
+            {
+                // forward repeat carried over from the bar before the range
+                bool repForward{begin > 0 &&
+                    (piece.m_bars[begin - 1].m_repeat == RepForward || piece.m_bars[begin - 1].m_repeat == RepJanus)};
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Cancel::Check();
+                    const std::unique_ptr<XMLElement> measure{Measure(piece, piece.m_bars[i], i + 1, repForward, options,
+                                                                            cache)};
+                    if (i > begin)
+                        ss << "\n";
+                    measure->Print(ss, measureLevel);
+                }
+            });
+    }
+    
+    for (auto & range : rendered)
+    {
+        if (!range.empty())
+            part->Add(new XMLFragment(std::move(range)));
     }
     xmlwriter.Root()->Add(part);
     
+    StatsScope statsScope("write");
+    TRACE_SPAN("GenMusicXml write");
     dst << xmlwriter;
 }
 
@@ -164,7 +186,8 @@ int GenMusicXml::Duration(NoteType noteType)
     return (1 << (NoteType256th - noteType)) * 3;
 }
 
-XMLElement* GenMusicXml::Measure(const Piece& piece, const Bar& bar, int n, bool& repForward, const Options& options)
+XMLElement* GenMusicXml::Measure(const Piece& piece, const Bar& bar, int n, bool& repForward, const Options& options,
+                                 ChordCache& cache)
 {
     XMLElement* measure = new XMLElement("measure");
     measure->AddAttrib("number", n);
@@ -195,84 +218,7 @@ XMLElement* GenMusicXml::Measure(const Piece& piece, const Bar& bar, int n, bool
     
     for (const auto & luteChord : bar.m_chords)
     {
-        // TODO Musecore has crotchet == 0 flags
-        NoteType adjusted{static_cast<NoteType>(luteChord.m_noteType + options.m_flags)};
-        adjusted = std::max(NoteTypeLong, adjusted);
-        adjusted = std::min(NoteType256th, adjusted);
-        const int duration = luteChord.m_dotted ? (3 * Duration(adjusted)) / 2 : Duration(adjusted);
-
-        if (luteChord.m_notes.empty())
-        {
-            XMLElement* note = new XMLElement("note");
-            
-            note->Add(new XMLElement("rest"));
-            note->Add(new XMLElement("duration", duration));
-            note->Add(new XMLElement("type", MusicXml::noteType[adjusted]));
-            
-            if (luteChord.m_dotted)
-                note->Add(new XMLElement("dot"));
-            
-            measure->Add(note);
-        }
-        else
-        {
-            bool fermata{luteChord.m_fermata};
-            bool firstNote{true};
-            for (const auto & luteNote : luteChord.m_notes)
-            {
-                const Pitch pitch{piece.m_tuning[luteNote.m_string - 1] + luteNote.m_fret};
-                const char step[] = {pitch.m_step, '\0'};
-                // TODO adjust for triplets
-                // TODO rests
-                // TODO ornaments
-                
-                XMLElement* note = new XMLElement("note");
-                
-                if (firstNote)
-                {
-                    firstNote = false;
-                }
-                else
-                {
-                    note->Add(new XMLElement("chord"));
-                }
-                
-                XMLElement* xmlpitch = new XMLElement("pitch");
-                xmlpitch->Add(new XMLElement("step", step));
-                if (pitch.m_alter != 0)
-                    xmlpitch->Add(new XMLElement("alter", pitch.m_alter));
-                xmlpitch->Add(new XMLElement("octave", pitch.m_octave));
-                note->Add(xmlpitch);
-                
-                note->Add(new XMLElement("duration", duration));
-                note->Add(new XMLElement("type", MusicXml::noteType[adjusted]));
-
-                if (luteChord.m_dotted)
-                    note->Add(new XMLElement("dot"));
-    
-                XMLElement* notations = new XMLElement("notations");
-
-                if (fermata)
-                {
-                    notations->Add(new XMLElement("fermata"));
-                    fermata = false; // only on first note of chord
-                }
-
-                XMLElement* technical = new XMLElement("technical");
-                technical->Add(new XMLElement("string", luteNote.m_string));
-                technical->Add(new XMLElement("fret", luteNote.m_fret));
-          
-                if (luteNote.m_leftFingering != FingerNone)
-                    technical->Add(new XMLElement("fingering", luteNote.m_leftFingering));
-                
-                if (luteNote.m_rightFingering != FingerNone)
-                    technical->Add(new XMLElement("pluck", MusicXml::pluck[luteNote.m_rightFingering]));
-                
-                notations->Add(technical);
-                note->Add(notations);
-                measure->Add(note);
-            }
-        }
+        measure->Add(new XMLFragment(cache.Get(luteChord, "", [&](){ return ChordNotes(piece, luteChord, options); })));
     }
     
     if (bar.m_barStyle != BarStyleRegular || bar.m_repeat != RepNone)
@@ -306,6 +252,100 @@ XMLElement* GenMusicXml::Measure(const Piece& piece, const Bar& bar, int n, bool
     return measure;
 }
 
+std::string GenMusicXml::ChordNotes(const Piece& piece, const Chord& luteChord, const Options& options)
+{
+    // a <note> for each note of the chord, or a rest
+    std::vector<std::unique_ptr<XMLElement>> notes;
+    
+    // TODO Musecore has crotchet == 0 flags
+    NoteType adjusted{static_cast<NoteType>(luteChord.m_noteType + options.m_flags)};
+    adjusted = std::max(NoteTypeLong, adjusted);
+    adjusted = std::min(NoteType256th, adjusted);
+    const int duration = luteChord.m_dotted ? (3 * Duration(adjusted)) / 2 : Duration(adjusted);
+
+    if (piece.Notes(luteChord).empty())
+    {
+        XMLElement* note = new XMLElement("note");
+        
+        note->Add(new XMLElement("rest"));
+        note->Add(new XMLElement("duration", duration));
+        note->Add(new XMLElement("type", MusicXml::noteType[adjusted]));
+        
+        if (luteChord.m_dotted)
+            note->Add(new XMLElement("dot"));
+        
+        notes.emplace_back(note);
+    }
+    else
+    {
+        bool fermata{luteChord.m_fermata};
+        bool firstNote{true};
+        for (const auto & luteNote : piece.Notes(luteChord))
+        {
+            const Pitch pitch{piece.m_tuning[luteNote.m_string - 1] + luteNote.m_fret};
+            const char step[] = {pitch.m_step, '\0'};
+            // TODO adjust for triplets
+            // TODO rests
+            // TODO ornaments
+            
+            XMLElement* note = new XMLElement("note");
+            
+            if (firstNote)
+            {
+                firstNote = false;
+            }
+            else
+            {
+                note->Add(new XMLElement("chord"));
+            }
+            
+            XMLElement* xmlpitch = new XMLElement("pitch");
+            xmlpitch->Add(new XMLElement("step", step));
+            if (pitch.m_alter != 0)
+                xmlpitch->Add(new XMLElement("alter", pitch.m_alter));
+            xmlpitch->Add(new XMLElement("octave", pitch.m_octave));
+            note->Add(xmlpitch);
+            
+            note->Add(new XMLElement("duration", duration));
+            note->Add(new XMLElement("type", MusicXml::noteType[adjusted]));
+
+            if (luteChord.m_dotted)
+                note->Add(new XMLElement("dot"));
+
+            XMLElement* notations = new XMLElement("notations");
+
+            if (fermata)
+            {
+                notations->Add(new XMLElement("fermata"));
+                fermata = false; // only on first note of chord
+            }
+
+            XMLElement* technical = new XMLElement("technical");
+            technical->Add(new XMLElement("string", luteNote.m_string));
+            technical->Add(new XMLElement("fret", luteNote.m_fret));
+      
+            if (luteNote.m_leftFingering != FingerNone)
+                technical->Add(new XMLElement("fingering", luteNote.m_leftFingering));
+            
+            if (luteNote.m_rightFingering != FingerNone)
+                technical->Add(new XMLElement("pluck", MusicXml::pluck[luteNote.m_rightFingering]));
+            
+            notations->Add(technical);
+            note->Add(notations);
+            notes.emplace_back(note);
+        }
+    }
+    
+    std::ostringstream ss;
+    for (size_t i = 0; i < notes.size(); ++i)
+    {
+        if (i > 0)
+            ss << "\n";
+        notes[i]->Print(ss, measureLevel + 1);
+    }
+    return ss.str();
+}
+
 XMLElement* GenMusicXml::FirstMeasureAttributes(const Piece& piece, const Bar& bar, const Options& options)
 {
     XMLElement* attributes = new XMLElement("attributes");
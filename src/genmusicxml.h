@@ -3,6 +3,7 @@
 
 #include <iostream>
 
+#include "chordcache.h"
 #include "xmlwriter.h"
 #include "piece.h"
 #include "options.h"
@@ -44,7 +45,10 @@ public:
     void Generate(const Options& options, const Piece& piece, std::ostream& dst);
     
 private:
-    XMLElement* Measure(const Piece& src, const Bar& bar, int n, bool& repForward, const Options& options);
+    static const int measureLevel = 2; // score-partwise/part/measure
+    
+    XMLElement* Measure(const Piece& src, const Bar& bar, int n, bool& repForward, const Options& options, ChordCache& cache);
+    std::string ChordNotes(const Piece& src, const Chord& luteChord, const Options& options);
     XMLElement* FirstMeasureAttributes(const Piece& src, const Bar& bar, const Options& options);
     void AddTimeSignature(XMLElement* attributes, const Bar& bar);
     int Duration(NoteType noteType);
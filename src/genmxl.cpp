@@ -6,28 +6,28 @@
 
 #include "genmusicxml.h"
 #include "platform.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
 
 void GenMxl::Generate(const Options& options, const Piece& piece)
+{
+    // generate MusicXML image
+    std::ostringstream ss;
+    GenMusicXml genMusicXml;
+    genMusicXml.Generate(options, piece, ss);
+    Zip(options, ss.str());
+}
+
+void GenMxl::Zip(const Options& options, const std::string& musicxml)
 {
     // The archive's contents must exist until after the archive is closed
     std::string mimetype;
     std::string musicxmlFilename;
     std::string container;
-    std::string musicxml;
 
-    // generate MusicXML image
-    {
-        std::ostringstream ss;
-        GenMusicXml genMusicXml;
-        genMusicXml.Generate(options, piece, ss);
-        musicxml = ss.str();
-    }
-    
-    // create zip archive
-    
     int errorp{0};
     zip_t* zipper = zip_open(options.m_dstFilename.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &errorp);
     if (zipper == nullptr)
@@ -103,6 +103,9 @@ void GenMxl::Generate(const Options& options, const Piece& piece)
         throw;
     }
     
+    // the archive is compressed and written on closing
+    StatsScope statsScope("zip");
+    TRACE_SPAN("GenMxl zip");
     zip_close(zipper);
 }
 
@@ -2,6 +2,7 @@
 #define _GENMXL_H_
 
 #include <iostream>
+#include <string>
 
 #include "options.h"
 #include "piece.h"
@@ -32,6 +33,14 @@ public:
      * @param[in] piece
      */
     void Generate(const Options& options, const Piece& piece);
+    
+    /**
+     * Write .mxl archive of a MusicXML image
+     * 
+     * @param[in] options
+     * @param[in] musicxml MusicXML file contents
+     */
+    static void Zip(const Options& options, const std::string& musicxml);
 };
 
 } // namespace luteconv
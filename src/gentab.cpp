@@ -2,10 +2,12 @@
 
 #include <algorithm>
 #include <fstream>
-#include <chrono>
-#include <iomanip>
 
+#include "cancel.h"
+#include "datetime.h"
 #include "logger.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -27,12 +29,9 @@ void GenTab::Generate(const Options& options, const Piece& piece, std::ostream&
         throw std::runtime_error("Error: Tab does not support german tablature");
     }
 
-    std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    struct std::tm * ptm = std::gmtime(&tt);
-    
     // header
     dst << "% Converted to .tab by luteconv " << options.m_version << std::endl
-        << "% encoding-date " << std::put_time(ptm,"%F") << std::endl
+        << "% encoding-date " << DateTime::Now("%F") << std::endl
         << "-C" << std::endl
         << "-highlightparen" << std::endl
         << "-tuning " << Pitch::GetTuningTab(piece.m_tuning) << std::endl;
@@ -116,170 +115,215 @@ void GenTab::Generate(const Options& options, const Piece& piece, std::ostream&
     dst << std::endl;
      
     // body
-    int staveNum{1};
-    int barNum{1};
-    int chordCount{0};
-    std::string repForward;
-    
-    dst << "% Stave " << staveNum << std::endl;
-    
-    for (const auto & bar : piece.m_bars)
+    // First pass decides the stave breaks, then the bars are rendered independently.
+    // Bars are rendered concurrently in contiguous ranges, one string per range.
+    const std::vector<BarLayout> layout{Layout(options, piece)};
+    const size_t count = piece.m_bars.size();
+    std::vector<std::string> rendered;
     {
-        if (chordCount == 0)
-        {
-            // first bar on line
-            dst <<  "% Bar " << barNum << std::endl;
-            if (!repForward.empty())
-            {
-                dst << repForward << std::endl;
-                repForward.clear();
-            }
-            else
+        StatsScope statsScope("render");
+        TRACE_SPAN("GenTab render");
+        rendered = ChordCache::RenderRanges("GenTab", count, options.m_jobs,
+            [&](size_t begin, size_t end, ChordCache& cache, std::ostream& ss)
             {
-                dst << "b" << std::endl;
-            }
-        }
-        
-        // time signature
-        const std::string timeSignature = GetTimeSignature(bar);
-        if (!timeSignature.empty())
-            dst << timeSignature << std::endl;
-        
-        // chords
-        for (const auto & chord : bar.m_chords)
-        {
-            ++chordCount;
-            
-            // flags
-            std::string line{GetFlagInfo(options, bar.m_chords, chord)};
-            
-            // notes
-            std::vector<std::string> vert;
-            vert.reserve(20);
-            
-            int vertOffset = 0;
-
-            for (const auto & note : chord.m_notes)
-            {
-                int vertIndex{0};
-                if (options.m_dstTabType == TabItalian)
-                {
-                    if (note.m_string >= 7)
-                    {
-                        vertIndex = 0;
-                    }
-                    else
-                    {
-                        // upside down
-                        vertIndex = 7 - std::min(note.m_string, 6) - 1 - vertOffset;
-                    
-                        if (piece.m_tuning.size() > 6)
-                            ++vertIndex; // extra space after flags for 7+ course italian
-                    }
-                }
-                else
-                {
-                    vertIndex = std::min(note.m_string, 7) - 1 - vertOffset;
-                }
-                
-                while (vertIndex >= static_cast<int>(vert.size()))
-                    vert.emplace_back(" "); // reserve unused strings
-                
-                const std::string rightFingering = GetRightFingering(note);
-                const std::string leftOrnament = GetLeftOrnament(note);
-                
-                // Ornaments #*- on first course may clash with flags, put default - as 2nd character
-                if (!leftOrnament.empty() && note.m_string == 1 && line.size() == 1)
+                for (size_t i = begin; i < end; ++i)
                 {
-                    line += "-";
+                    Cancel::Check();
+                    RenderBar(options, piece, layout, i, cache, ss);
                 }
-                vert[vertIndex] =     leftOrnament // before the letter
-                                    + GetLeftFingering(note) // before the letter
-                                    + GetFret(note, options) // fret letter
-                                    + GetRightOrnament(note) // after the letter
-                                    + rightFingering;  // after the letter
-                
-                // right fingering pushes the vertical position out of place, compensate
-                vertOffset += rightFingering.size();
-            }
-            
-            for (const auto & s : vert)
-            {
-                line += s;
-            }
-            
-            // remove trailing spaces
-            line.erase(std::find_if_not(line.rbegin(), line.rend(), [](int c){return isspace(c);}).base(), line.end());
-            
-            dst << line << std::endl;
-        }
-        
-        // end of current bar
-        ++barNum;
-        dst <<  "% Bar " << barNum << std::endl;
+            });
+    }
+    
+    StatsScope statsScope("write");
+    TRACE_SPAN("GenTab write");
+    dst << "% Stave 1" << std::endl;
+    for (const auto & range : rendered)
+        dst << range;
+    
+    dst << "e" << std::endl; // end of piece
+}
+    
+std::vector<GenTab::BarLayout> GenTab::Layout(const Options& options, const Piece& piece)
+{
+    std::vector<BarLayout> layout(piece.m_bars.size());
+    int staveNum{1};
+    int chordCount{0};
+    
+    for (size_t i = 0; i < piece.m_bars.size(); ++i)
+    {
+        layout[i].m_staveStart = chordCount == 0;
+        layout[i].m_staveNum = staveNum;
+        chordCount += piece.m_bars[i].m_chords.size();
         
         // Tab doesn't automatically add stave endings.  Use herustic:
         // count chords, when the threshold is reached end the stave at the end of
         // the current bar.  Except for last bar.
-        const bool lineBreak = barNum < static_cast<int>(piece.m_bars.size()) && chordCount > options.m_wrapThreshold;
-        
-        std::string barStyle;
-        switch (bar.m_barStyle)
+        layout[i].m_lineBreak = i + 2 < piece.m_bars.size() && chordCount > options.m_wrapThreshold;
+        if (layout[i].m_lineBreak)
         {
-        case BarStyleHeavy:
-            barStyle = "B";
-            break;
-        case BarStyleLightLight:
-            barStyle = "bb";
-            break;
-        default:
-            barStyle = "b";
+            ++staveNum;
+            chordCount = 0;
         }
-        
-        switch (bar.m_repeat)
+    }
+    
+    return layout;
+}
+
+void GenTab::RenderBar(const Options& options, const Piece& piece, const std::vector<BarLayout>& layout,
+                       size_t barIndex, ChordCache& cache, std::ostream& dst)
+{
+    const Bar& bar = piece.m_bars[barIndex];
+    const int barNum = barIndex + 1;
+    
+    if (layout[barIndex].m_staveStart)
+    {
+        // first bar on line
+        dst <<  "% Bar " << barNum << std::endl;
+        if (barIndex > 0 && layout[barIndex - 1].m_lineBreak && piece.m_bars[barIndex - 1].m_repeat == RepJanus)
         {
-        case RepNone:
-            break;
-        case RepForward:
-            barStyle += ".";
-            break;
-        case RepBackward:
+            // forward half of the janus repeat that ended the previous line
+            dst << GetBarStyle(piece.m_bars[barIndex - 1]) << "." << std::endl;
+        }
+        else
+        {
+            dst << "b" << std::endl;
+        }
+    }
+    
+    // time signature
+    const std::string timeSignature = GetTimeSignature(bar);
+    if (!timeSignature.empty())
+        dst << timeSignature << std::endl;
+    
+    // chords
+    for (const auto & chord : bar.m_chords)
+    {
+        // flags depend on the neighbouring chords, so are part of the key
+        const std::string flags{GetFlagInfo(options, bar.m_chords, chord)};
+        dst << cache.Get(chord, flags, [&](){ return GetChord(options, piece, chord, flags); }) << std::endl;
+    }
+    
+    // end of current bar
+    dst <<  "% Bar " << barNum + 1 << std::endl;
+    
+    const bool lineBreak = layout[barIndex].m_lineBreak;
+    std::string barStyle{GetBarStyle(bar)};
+    switch (bar.m_repeat)
+    {
+    case RepNone:
+        break;
+    case RepForward:
+        barStyle += ".";
+        break;
+    case RepBackward:
+        barStyle = "." + barStyle;
+        break;
+    case RepJanus:
+        if (lineBreak)
+        {
+            // backward repeat here, forward repeat in next bar, next line
             barStyle = "." + barStyle;
-            break;
-        case RepJanus:
-            if (lineBreak)
+        }
+        else
+        {
+            barStyle = "." + barStyle + ".";
+        }
+    }
+    
+    if (bar.m_fermata)
+    {
+        dst << "Y" << barStyle << std::endl;
+    }
+    else
+    {
+        dst << barStyle << std::endl;
+    }
+    
+    if (lineBreak)
+    {
+        dst << std::endl;
+        dst << "% Stave " << layout[barIndex].m_staveNum + 1 << std::endl;
+    }
+}
+
+std::string GenTab::GetChord(const Options& options, const Piece& piece, const Chord& chord, const std::string& flags)
+{
+    std::string line{flags};
+    
+    // notes
+    std::vector<std::string> vert;
+    vert.reserve(20);
+    
+    int vertOffset = 0;
+
+    for (const auto & note : piece.Notes(chord))
+    {
+        int vertIndex{0};
+        if (options.m_dstTabType == TabItalian)
+        {
+            if (note.m_string >= 7)
             {
-                // backward repeat here, forward repeat in next bar, next line
-                repForward = barStyle + ".";
-                barStyle = "." + barStyle;
+                vertIndex = 0;
             }
             else
             {
-                barStyle = "." + barStyle + ".";
+                // upside down
+                vertIndex = 7 - std::min(note.m_string, 6) - 1 - vertOffset;
+            
+                if (piece.m_tuning.size() > 6)
+                    ++vertIndex; // extra space after flags for 7+ course italian
             }
         }
-        
-        if (bar.m_fermata)
-        {
-            dst << "Y" << barStyle << std::endl;
-        }
         else
         {
-            dst << barStyle << std::endl;
+            vertIndex = std::min(note.m_string, 7) - 1 - vertOffset;
         }
         
-        if (lineBreak)
+        while (vertIndex >= static_cast<int>(vert.size()))
+            vert.emplace_back(" "); // reserve unused strings
+        
+        const std::string rightFingering = GetRightFingering(note);
+        const std::string leftOrnament = GetLeftOrnament(note);
+        
+        // Ornaments #*- on first course may clash with flags, put default - as 2nd character
+        if (!leftOrnament.empty() && note.m_string == 1 && line.size() == 1)
         {
-            dst << std::endl;
-            ++staveNum;
-            chordCount = 0;
-            dst << "% Stave " << staveNum << std::endl;
+            line += "-";
         }
+        vert[vertIndex] =     leftOrnament // before the letter
+                            + GetLeftFingering(note) // before the letter
+                            + GetFret(note, options) // fret letter
+                            + GetRightOrnament(note) // after the letter
+                            + rightFingering;  // after the letter
+        
+        // right fingering pushes the vertical position out of place, compensate
+        vertOffset += rightFingering.size();
     }
     
-    dst << "e" << std::endl; // end of piece
-}
+    for (const auto & s : vert)
+    {
+        line += s;
+    }
     
+    // remove trailing spaces
+    line.erase(std::find_if_not(line.rbegin(), line.rend(), [](int c){return isspace(c);}).base(), line.end());
+    
+    return line;
+}
+
+std::string GenTab::GetBarStyle(const Bar & bar)
+{
+    switch (bar.m_barStyle)
+    {
+    case BarStyleHeavy:
+        return "B";
+    case BarStyleLightLight:
+        return "bb";
+    default:
+        return "b";
+    }
+}
+
 std::string GenTab::GetTimeSignature(const Bar & bar)
 {
     switch (bar.m_timeSig.m_timeSymbol)
@@ -3,7 +3,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
+#include "chordcache.h"
 #include "piece.h"
 #include "options.h"
 
@@ -44,6 +46,19 @@ public:
     void Generate(const Options& options, const Piece& piece, std::ostream& dst);
     
 private:
+    // Stave layout of a bar, decided before any bar is rendered
+    struct BarLayout
+    {
+        bool m_staveStart{false}; // first bar on its stave
+        bool m_lineBreak{false}; // stave ends after this bar
+        int m_staveNum{1};
+    };
+    
+    static std::vector<BarLayout> Layout(const Options& options, const Piece& piece);
+    static void RenderBar(const Options& options, const Piece& piece, const std::vector<BarLayout>& layout,
+                          size_t barIndex, ChordCache& cache, std::ostream& dst);
+    static std::string GetChord(const Options& options, const Piece& piece, const Chord& chord, const std::string& flags);
+    static std::string GetBarStyle(const Bar & bar);
     static std::string GetTimeSignature(const Bar & bar);
     static std::string GetFlagInfo(const Options& options, const std::vector<Chord> & chords, const Chord & our);
     static std::string GetRightFingering(const Note & note);
@@ -2,9 +2,11 @@
 
 #include <algorithm>
 #include <fstream>
-#include <chrono>
-#include <iomanip>
 
+#include "cancel.h"
+#include "datetime.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -21,12 +23,9 @@ void GenTabCode::Generate(const Options& options, const Piece& piece)
 
 void GenTabCode::Generate(const Options& options, const Piece& piece, std::ostream& dst)
 {
-    std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    struct std::tm * ptm = std::gmtime(&tt);
-    
     // TabCode has no syntax for title, composer etc.  Just put everything in comments.
     dst << "{ Converted to TabCode .tc by luteconv " << options.m_version << " }" << std::endl
-        << "{ encoding-date " << std::put_time(ptm,"%F") << " }" << std::endl;
+        << "{ encoding-date " << DateTime::Now("%F") << " }" << std::endl;
 
     if (!piece.m_copyright.empty())
         dst << "{ " << piece.m_copyright << " }" << std::endl;
@@ -48,125 +47,171 @@ void GenTabCode::Generate(const Options& options, const Piece& piece, std::ostre
     dst << std::endl;
      
     // body
-    int staveNum{1};
-    int barNum{1};
-    int chordCount{0};
-    std::string repForward;
-    
-    dst << "{ Stave " << staveNum << " }" << std::endl;
-    
-    for (const auto & bar : piece.m_bars)
+    // First pass decides the stave breaks, then the bars are rendered independently.
+    // Bars are rendered concurrently in contiguous ranges, one string per range.
+    const std::vector<BarLayout> layout{Layout(options, piece)};
+    const size_t count = piece.m_bars.size();
+    std::vector<std::string> rendered;
     {
-        if (chordCount == 0)
-        {
-            // first bar on line
-            dst <<  "{ Bar " << barNum << " }" << std::endl;
-            if (!repForward.empty())
+        StatsScope statsScope("render");
+        TRACE_SPAN("GenTabCode render");
+        rendered = ChordCache::RenderRanges("GenTabCode", count, options.m_jobs,
+            [&](size_t begin, size_t end, ChordCache& cache, std::ostream& ss)
             {
-                dst << repForward << std::endl;
-                repForward.clear();
-            }
-            else
-            {
-                dst << "|" << std::endl;
-            }
-        }
-        
-        // time signature
-        const std::string timeSignature = GetTimeSignature(bar);
-        if (!timeSignature.empty())
-            dst << timeSignature << std::endl;
-        
-        // chords
-        for (const auto & chord : bar.m_chords)
-        {
-            ++chordCount;
-            
-            // flags
-            std::string tabWord{GetFlagInfo(options, bar.m_chords, chord)};
-            
-            // notes. TabCode uses fret/string pairs so ordering in a tabword shouldn't matter,
-            // but assume that it does.
-            std::vector<std::string> vert(7);
-            
-            for (const auto & note : chord.m_notes)
-            {
-                if (note.m_string < 7)
-                {
-                    vert[note.m_string - 1] = GetFret(note)
-                            + std::to_string(note.m_string)
-                            + GetLeftOrnament(note)
-                            + GetRightOrnament(note)
-                            + GetLeftFingering(note)
-                            + GetRightFingering(note);
-                }
-                else
+                for (size_t i = begin; i < end; ++i)
                 {
-                    // diapasons don't have fingering or ornaments - is that right?
-                    vert[6] = "X" + GetFret(note);
+                    Cancel::Check();
+                    RenderBar(options, piece, layout, i, cache, ss);
                 }
-            }
-            
-            for (const auto & s : vert)
-            {
-                tabWord += s;
-            }
-            
-            dst << tabWord << std::endl;
-        }
-        
-        // end of current bar
-        ++barNum;
-        dst <<  "{ Bar " << barNum << " }" << std::endl;
+            });
+    }
+    
+    StatsScope statsScope("write");
+    TRACE_SPAN("GenTabCode write");
+    dst << "{ Stave 1 }" << std::endl;
+    for (const auto & range : rendered)
+        dst << range;
+}
+
+std::vector<GenTabCode::BarLayout> GenTabCode::Layout(const Options& options, const Piece& piece)
+{
+    std::vector<BarLayout> layout(piece.m_bars.size());
+    int staveNum{1};
+    int chordCount{0};
+    
+    for (size_t i = 0; i < piece.m_bars.size(); ++i)
+    {
+        layout[i].m_staveStart = chordCount == 0;
+        layout[i].m_staveNum = staveNum;
+        chordCount += piece.m_bars[i].m_chords.size();
         
         // Stave ending Use herustic:
         // count chords, when the threshold is reached end the stave at the end of
         // the current bar.  Except for last bar.
-        const bool lineBreak = barNum < static_cast<int>(piece.m_bars.size()) && chordCount > options.m_wrapThreshold;
-        
-        std::string barStyle;
-        switch (bar.m_barStyle)
+        layout[i].m_lineBreak = i + 2 < piece.m_bars.size() && chordCount > options.m_wrapThreshold;
+        if (layout[i].m_lineBreak)
         {
-        case BarStyleLightLight:
-            barStyle = "||";
-            break;
-        default:
-            barStyle = "|";
+            ++staveNum;
+            chordCount = 0;
         }
-        
-        switch (bar.m_repeat)
+    }
+    
+    return layout;
+}
+
+void GenTabCode::RenderBar(const Options& options, const Piece& piece, const std::vector<BarLayout>& layout,
+                           size_t barIndex, ChordCache& cache, std::ostream& dst)
+{
+    const Bar& bar = piece.m_bars[barIndex];
+    const int barNum = barIndex + 1;
+    
+    if (layout[barIndex].m_staveStart)
+    {
+        // first bar on line
+        dst <<  "{ Bar " << barNum << " }" << std::endl;
+        if (barIndex > 0 && layout[barIndex - 1].m_lineBreak && piece.m_bars[barIndex - 1].m_repeat == RepJanus)
         {
-        case RepNone:
-            break;
-        case RepForward:
-            barStyle += ":";
-            break;
-        case RepBackward:
-            barStyle = ":" + barStyle;
-            break;
-        case RepJanus:
-            if (lineBreak)
-            {
-                // backward repeat here, forward repeat in next bar, next line
-                repForward = barStyle + ":";
-                barStyle = ":" + barStyle;
-            }
-            else
-            {
-                barStyle = ":" + barStyle + ":";
-            }
+            // forward half of the janus repeat that ended the previous line
+            dst << GetBarStyle(piece.m_bars[barIndex - 1]) << ":" << std::endl;
         }
-        
-        dst << barStyle << std::endl;
-        
+        else
+        {
+            dst << "|" << std::endl;
+        }
+    }
+    
+    // time signature
+    const std::string timeSignature = GetTimeSignature(bar);
+    if (!timeSignature.empty())
+        dst << timeSignature << std::endl;
+    
+    // chords
+    for (const auto & chord : bar.m_chords)
+    {
+        // flags are part of the key
+        const std::string flags{GetFlagInfo(options, bar.m_chords, chord)};
+        dst << cache.Get(chord, flags, [&](){ return GetChord(piece, chord, flags); }) << std::endl;
+    }
+    
+    // end of current bar
+    dst <<  "{ Bar " << barNum + 1 << " }" << std::endl;
+    
+    const bool lineBreak = layout[barIndex].m_lineBreak;
+    std::string barStyle{GetBarStyle(bar)};
+    switch (bar.m_repeat)
+    {
+    case RepNone:
+        break;
+    case RepForward:
+        barStyle += ":";
+        break;
+    case RepBackward:
+        barStyle = ":" + barStyle;
+        break;
+    case RepJanus:
         if (lineBreak)
         {
-            dst << "{^}" << std::endl;
-            ++staveNum;
-            chordCount = 0;
-            dst << "{ Stave " << staveNum << " }" << std::endl;
+            // backward repeat here, forward repeat in next bar, next line
+            barStyle = ":" + barStyle;
+        }
+        else
+        {
+            barStyle = ":" + barStyle + ":";
         }
     }
+    
+    dst << barStyle << std::endl;
+    
+    if (lineBreak)
+    {
+        dst << "{^}" << std::endl;
+        dst << "{ Stave " << layout[barIndex].m_staveNum + 1 << " }" << std::endl;
+    }
+}
+
+std::string GenTabCode::GetChord(const Piece& piece, const Chord& chord, const std::string& flags)
+{
+    std::string tabWord{flags};
+    
+    // notes. TabCode uses fret/string pairs so ordering in a tabword shouldn't matter,
+    // but assume that it does.
+    std::vector<std::string> vert(7);
+    
+    for (const auto & note : piece.Notes(chord))
+    {
+        if (note.m_string < 7)
+        {
+            vert[note.m_string - 1] = GetFret(note)
+                    + std::to_string(note.m_string)
+                    + GetLeftOrnament(note)
+                    + GetRightOrnament(note)
+                    + GetLeftFingering(note)
+                    + GetRightFingering(note);
+        }
+        else
+        {
+            // diapasons don't have fingering or ornaments - is that right?
+            vert[6] = "X" + GetFret(note);
+        }
+    }
+    
+    for (const auto & s : vert)
+    {
+        tabWord += s;
+    }
+    
+    return tabWord;
+}
+
+std::string GenTabCode::GetBarStyle(const Bar & bar)
+{
+    switch (bar.m_barStyle)
+    {
+    case BarStyleLightLight:
+        return "||";
+    default:
+        return "|";
+    }
 }
     
 std::string GenTabCode::GetTimeSignature(const Bar & bar)
@@ -0,0 +1,80 @@
+#include "inputlimits.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "piece.h"
+
+namespace luteconv
+{
+
+void InputLimits::CheckInput(const std::string& filename, uint64_t bytes) const
+{
+    if (m_maxInputBytes > 0 && bytes > m_maxInputBytes)
+    {
+        std::ostringstream ss;
+        ss << "Error: " << filename << " is larger than " << m_maxInputBytes << " bytes";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void InputLimits::CheckInflated(const std::string& filename, uint64_t compressed, uint64_t inflated) const
+{
+    if (m_maxInflatedBytes > 0 && inflated > m_maxInflatedBytes)
+    {
+        std::ostringstream ss;
+        ss << "Error: " << filename << " decompresses to more than " << m_maxInflatedBytes << " bytes";
+        throw std::runtime_error(ss.str());
+    }
+
+    // small files are allowed a high ratio, e.g. a few compressed bytes of empty file
+    const uint64_t floor{64 * 1024};
+    if (m_maxRatio > 0 && inflated > floor && inflated / m_maxRatio > compressed)
+    {
+        std::ostringstream ss;
+        ss << "Error: " << filename << " compression ratio is more than " << m_maxRatio;
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void InputLimits::CheckZipEntries(const std::string& filename, uint64_t entries) const
+{
+    if (m_maxZipEntries > 0 && entries > m_maxZipEntries)
+    {
+        std::ostringstream ss;
+        ss << "Error: " << filename << " has more than " << m_maxZipEntries << " zip entries";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void InputLimits::CheckBars(uint64_t bars) const
+{
+    if (m_maxBars > 0 && bars > m_maxBars)
+    {
+        std::ostringstream ss;
+        ss << "Error: More than " << m_maxBars << " bars";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void InputLimits::CheckPiece(const Piece& piece) const
+{
+    CheckBars(piece.m_bars.size());
+    if (m_maxNotes == 0)
+        return;
+
+    uint64_t notes{0};
+    for (const auto & bar : piece.m_bars)
+    {
+        for (const auto & chord : bar.m_chords)
+            notes += piece.Notes(chord).size();
+        if (notes > m_maxNotes)
+        {
+            std::ostringstream ss;
+            ss << "Error: More than " << m_maxNotes << " notes";
+            throw std::runtime_error(ss.str());
+        }
+    }
+}
+
+} // namespace luteconv
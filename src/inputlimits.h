@@ -0,0 +1,84 @@
+#ifndef _INPUTLIMITS_H_
+#define _INPUTLIMITS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace luteconv
+{
+
+class Piece;
+
+/**
+ * Limits on the source so that a hostile or corrupt file fails fast, rather
+ * than exhausting memory.  0 => no limit.
+ */
+class InputLimits
+{
+public:
+
+    /**
+     * Constructor
+     */
+    InputLimits() = default;
+
+    /**
+     * Destructor
+     */
+    ~InputLimits() = default;
+
+    /**
+     * Check the size of the source file
+     *
+     * @param[in] filename
+     * @param[in] bytes
+     * @throws std::runtime_error if too large
+     */
+    void CheckInput(const std::string& filename, uint64_t bytes) const;
+
+    /**
+     * Check the decompressed size, so far, of a compressed source file
+     *
+     * @param[in] filename
+     * @param[in] compressed bytes of the source file
+     * @param[in] inflated bytes decompressed so far, or declared
+     * @throws std::runtime_error if too large, or the compression ratio too high
+     */
+    void CheckInflated(const std::string& filename, uint64_t compressed, uint64_t inflated) const;
+
+    /**
+     * Check the number of entries in a zip archive
+     *
+     * @param[in] filename
+     * @param[in] entries
+     * @throws std::runtime_error if too many
+     */
+    void CheckZipEntries(const std::string& filename, uint64_t entries) const;
+
+    /**
+     * Check the number of bars parsed so far
+     *
+     * @param[in] bars
+     * @throws std::runtime_error if too many
+     */
+    void CheckBars(uint64_t bars) const;
+
+    /**
+     * Check the numbers of bars and notes of a parsed piece
+     *
+     * @param[in] piece
+     * @throws std::runtime_error if too many
+     */
+    void CheckPiece(const Piece& piece) const;
+
+    uint64_t m_maxInputBytes{256 * 1024 * 1024};
+    uint64_t m_maxInflatedBytes{256 * 1024 * 1024};
+    uint64_t m_maxRatio{200};
+    uint64_t m_maxZipEntries{1000};
+    uint64_t m_maxBars{1000000};
+    uint64_t m_maxNotes{10000000};
+};
+
+} // namespace luteconv
+
+#endif // _INPUTLIMITS_H_
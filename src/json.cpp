@@ -0,0 +1,26 @@
+#include "json.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace luteconv
+{
+
+std::string Json::String(const std::string& text)
+{
+    std::ostringstream ss;
+    ss << '"';
+    for (const unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+            ss << '\\' << c;
+        else if (c < 0x20)
+            ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        else
+            ss << c;
+    }
+    ss << '"';
+    return ss.str();
+}
+
+} // namespace luteconv
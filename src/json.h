@@ -0,0 +1,37 @@
+#ifndef _JSON_H_
+#define _JSON_H_
+
+#include <string>
+
+namespace luteconv
+{
+
+/**
+ * Helpers for the JSON output of --stats, --info and --trace
+ */
+class Json
+{
+public:
+    
+    /**
+     * Constructor
+     */
+    Json() = default;
+    
+    /**
+     * Destructor
+     */
+    ~Json() = default;
+    
+    /**
+     * Quote and escape text as a JSON string
+     * 
+     * @param[in] text
+     * @return "text"
+     */
+    static std::string String(const std::string& text);
+};
+
+} // namespace luteconv
+
+#endif // _JSON_H_
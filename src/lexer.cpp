@@ -0,0 +1,136 @@
+#include "lexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace luteconv
+{
+
+LineLexer::LineLexer(std::string_view text)
+: m_text{text}
+{
+}
+
+LineLexer::LineLexer(std::string_view text, int lineNo)
+: m_text{text}, m_lineNo{lineNo}
+{
+}
+
+bool LineLexer::Next(std::string_view& line)
+{
+    if (m_end)
+        return false;
+    
+    const size_t newline = m_text.find('\n', m_pos);
+    if (newline == std::string_view::npos)
+    {
+        line = m_text.substr(m_pos);
+        m_pos = m_text.size();
+        m_end = true;
+    }
+    else
+    {
+        line = m_text.substr(m_pos, newline - m_pos);
+        m_pos = newline + 1;
+    }
+    
+    ++m_lineNo;
+    return true;
+}
+
+int LineLexer::LineNo() const
+{
+    return m_lineNo;
+}
+
+std::string LineLexer::Read(std::istream& src)
+{
+    std::string text;
+    
+    // size the buffer in one go if the stream is seekable
+    const std::istream::pos_type begin = src.tellg();
+    if (begin != std::istream::pos_type(-1) && src.seekg(0, std::ios::end))
+    {
+        const std::istream::pos_type end = src.tellg();
+        src.seekg(begin);
+        if (end != std::istream::pos_type(-1) && end >= begin)
+        {
+            text.resize(static_cast<size_t>(end - begin));
+            src.read(&text[0], text.size());
+            text.resize(static_cast<size_t>(src.gcount()));
+            return text;
+        }
+    }
+    
+    src.clear();
+    text.assign(std::istreambuf_iterator<char>(src), std::istreambuf_iterator<char>());
+    return text;
+}
+
+std::string_view LineLexer::TrimRight(std::string_view s)
+{
+    size_t size = s.size();
+    while (size > 0 && isspace(static_cast<unsigned char>(s[size - 1])))
+        --size;
+    return s.substr(0, size);
+}
+
+TabCodeLexer::TabCodeLexer(std::string_view text)
+: m_text{text}
+{
+}
+
+TabCodeLexer::TabCodeLexer(std::string_view text, int lineNo)
+: m_text{text}, m_lineNo{lineNo + 1}
+{
+}
+
+bool TabCodeLexer::Next(std::string_view& token, TokenType& type)
+{
+    // skip white space
+    while (m_pos < m_text.size())
+    {
+        const char c = m_text[m_pos];
+        if (c == '\n')
+            ++m_lineNo;
+        else if (c != ' ' && c != '\t' && c != '\r')
+            break;
+        ++m_pos;
+    }
+    
+    if (m_pos >= m_text.size())
+        return false;
+    
+    const size_t begin = m_pos;
+    m_tokenLineNo = m_lineNo;
+    
+    if (m_text[m_pos] == '{')
+    {
+        const size_t close = m_text.find('}', m_pos + 1);
+        m_pos = close == std::string_view::npos ? m_text.size() : close + 1;
+        type = TokenComment;
+        token = m_text.substr(begin, m_pos - begin);
+        m_lineNo += static_cast<int>(std::count(token.begin(), token.end(), '\n'));
+        return true;
+    }
+    
+    ++m_pos;
+    while (m_pos < m_text.size())
+    {
+        const char c = m_text[m_pos];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '{')
+            break;
+        ++m_pos;
+    }
+    type = TokenTabword;
+    token = m_text.substr(begin, m_pos - begin);
+    return true;
+}
+
+int TabCodeLexer::LineNo() const
+{
+    return m_tokenLineNo;
+}
+
+} // namespace luteconv
@@ -0,0 +1,136 @@
+#ifndef _LEXER_H_
+#define _LEXER_H_
+
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace luteconv
+{
+
+/**
+ * Split a text buffer into lines without copying
+ */
+class LineLexer
+{
+public:
+    
+    /**
+     * Constructor
+     * 
+     * @param[in] text, must outlive the lexer
+     */
+    explicit LineLexer(std::string_view text);
+    
+    /**
+     * Constructor, for text that is part of a larger document
+     * 
+     * @param[in] text, must outlive the lexer
+     * @param[in] lineNo number of lines preceding text
+     */
+    LineLexer(std::string_view text, int lineNo);
+    
+    /**
+     * Destructor
+     */
+    ~LineLexer() = default;
+    
+    /**
+     * Get the next line.  As std::getline, the line does not include the
+     * '\n'; text ending with '\n' is followed by an empty last line.
+     * 
+     * @param[out] line
+     * @return true <=> line set, false <=> end of text
+     */
+    bool Next(std::string_view& line);
+    
+    /**
+     * Line number of the line last returned by Next, counting from 1
+     * 
+     * @return line number
+     */
+    int LineNo() const;
+    
+    /**
+     * Read all of a stream into memory
+     * 
+     * @param[in] src
+     * @return contents
+     */
+    static std::string Read(std::istream& src);
+    
+    /**
+     * Remove trailing white space
+     * 
+     * @param[in] s
+     * @return s without trailing white space
+     */
+    static std::string_view TrimRight(std::string_view s);
+    
+private:
+    std::string_view m_text;
+    size_t m_pos{0};
+    int m_lineNo{0};
+    bool m_end{false};
+};
+
+/**
+ * Split TabCode text into tabwords and comments without copying
+ */
+class TabCodeLexer
+{
+public:
+    
+    enum TokenType
+    {
+        TokenTabword,   // delimited by white space or the start of a comment
+        TokenComment,   // from { to the next }, may span lines
+    };
+    
+    /**
+     * Constructor
+     * 
+     * @param[in] text, must outlive the lexer
+     */
+    explicit TabCodeLexer(std::string_view text);
+    
+    /**
+     * Constructor, for text that is part of a larger document
+     * 
+     * @param[in] text, must outlive the lexer
+     * @param[in] lineNo number of lines preceding text
+     */
+    TabCodeLexer(std::string_view text, int lineNo);
+    
+    /**
+     * Destructor
+     */
+    ~TabCodeLexer() = default;
+    
+    /**
+     * Get the next token.  A comment includes its braces, an unterminated
+     * comment extends to the end of the text.
+     * 
+     * @param[out] token
+     * @param[out] type
+     * @return true <=> token set, false <=> end of text
+     */
+    bool Next(std::string_view& token, TokenType& type);
+    
+    /**
+     * Line number of the start of the token last returned by Next, counting from 1
+     * 
+     * @return line number
+     */
+    int LineNo() const;
+    
+private:
+    std::string_view m_text;
+    size_t m_pos{0};
+    int m_lineNo{1};
+    int m_tokenLineNo{0};
+};
+
+} // namespace luteconv
+
+#endif // _LEXER_H_
@@ -1,36 +1,338 @@
 #include "logger.h"
 
+#include <atomic>
+#include <cctype>
 #include <chrono>
-#include <iomanip>
+#include <condition_variable>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "datetime.h"
 
 namespace luteconv
 {
 
-bool Logger::m_verbose{false};
+namespace
+{
+
+const char* const levelNames[] = {"OFF", "ERROR", "WARNING", "INFO", "DEBUG"};
 
-void Logger::SetVerbose(bool verbose)
+/**
+ * Writes records on a background thread.  Producers hand over records
+ * through a bounded lock free ring, multiple producers, single consumer.
+ */
+class LogWriter
 {
-    m_verbose = verbose;
+public:
+    LogWriter()
+    : m_slots{new Slot[capacity]}
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+
+        m_thread = std::thread(&LogWriter::Run, this);
+    }
+
+    ~LogWriter()
+    {
+        m_stop.store(true);
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+    // Queue a record, the record is swapped with an empty string.  Waits if the ring is full.
+    void Push(std::string& record)
+    {
+        while (!TryPush(record))
+        {
+            m_cv.notify_one();
+            std::this_thread::yield();
+        }
+
+        if (m_sleeping.load(std::memory_order_relaxed))
+            m_cv.notify_one();
+    }
+
+    void Flush()
+    {
+        const size_t target = m_enqueuePos.load();
+        m_cv.notify_one();
+        while (m_written.load() < target)
+            std::this_thread::yield();
+    }
+
+    void SetFile(const std::string& filename)
+    {
+        std::unique_ptr<std::ofstream> file;
+        if (!filename.empty())
+        {
+            file.reset(new std::ofstream(filename, std::ofstream::out | std::ofstream::app));
+            if (!file->is_open())
+                throw std::runtime_error(std::string("Error: Can't open ") + filename);
+        }
+
+        Flush();
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        m_file = std::move(file);
+        m_filename = filename;
+    }
+
+    // not synchronised with SetFile
+    const std::string& Filename() const
+    {
+        return m_filename;
+    }
+
+private:
+    static const size_t capacity = 4096; // power of 2
+
+    struct Slot
+    {
+        std::atomic<size_t> m_sequence{0};
+        std::string m_record;
+    };
+
+    bool TryPush(std::string& record)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot& slot = m_slots[pos & (capacity - 1)];
+            const size_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+            if (sequence == pos)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.m_record.swap(record);
+                    slot.m_sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < pos)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(std::string& record)
+    {
+        Slot& slot = m_slots[m_dequeuePos & (capacity - 1)];
+        if (slot.m_sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+            return false; // empty
+
+        record.swap(slot.m_record);
+        slot.m_sequence.store(m_dequeuePos + capacity, std::memory_order_release);
+        ++m_dequeuePos;
+        return true;
+    }
+
+    void Run()
+    {
+        std::string record;
+        for (;;)
+        {
+            size_t count{0};
+            {
+                std::lock_guard<std::mutex> lock(m_sinkMutex);
+                std::ostream& sink = m_file ? *m_file : std::cerr;
+                while (TryPop(record))
+                {
+                    sink << record << '\n';
+                    ++count;
+                }
+                if (count > 0)
+                    sink.flush();
+            }
+
+            if (count > 0)
+            {
+                m_written.fetch_add(count);
+                continue;
+            }
+
+            if (m_stop.load())
+                break;
+
+            // Producers don't take the mutex, a missed notification costs at most the timeout
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_sleeping.store(true);
+            m_cv.wait_for(lock, std::chrono::milliseconds(10));
+            m_sleeping.store(false);
+        }
+    }
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<size_t> m_enqueuePos{0};
+    size_t m_dequeuePos{0}; // writer thread only
+    std::atomic<size_t> m_written{0};
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_stop{false};
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::mutex m_sinkMutex;
+    std::unique_ptr<std::ofstream> m_file; // nullptr => stderr
+    std::string m_filename;
+    std::thread m_thread;
+};
+
+// replaced in a forked child, see Logger::AfterFork
+std::unique_ptr<LogWriter>& WriterPtr()
+{
+    static std::unique_ptr<LogWriter> writer{new LogWriter};
+    return writer;
 }
 
-bool Logger::Verbose()
+LogWriter& Writer()
 {
-    return m_verbose;
+    return *WriterPtr();
 }
 
-std::ostringstream& Logger::Get()
+// per thread formatting buffer, reused by every record
+std::ostringstream& Buffer()
+{
+    thread_local std::ostringstream buffer;
+    return buffer;
+}
+
+// timestamp to the second, reformatted only when the second changes
+const std::string& Timestamp()
 {
-    std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    struct std::tm * ptm = std::gmtime(&tt);
+    thread_local std::time_t last{0};
+    thread_local std::string timestamp;
 
-    os << std::put_time(ptm,"%FT%T") << " ";
+    const std::time_t now = std::time(nullptr);
+    if (now != last)
+    {
+        last = now;
+        timestamp = DateTime::Now("%FT%T");
+    }
+    return timestamp;
+}
+
+} // namespace
+
+thread_local LogLevel Logger::m_level{LogOff};
+thread_local std::string Logger::m_filter;
+
+Logger::Logger(LogLevel level, const char* file)
+: m_recordLevel{level}, m_file{file}
+{
+}
+
+std::ostringstream& Logger::Get()
+{
+    std::ostringstream& os = Buffer();
+    os.str("");
+    os << Timestamp() << " " << levelNames[m_recordLevel] << " " << Subsystem(m_file) << ": ";
     return os;
 }
 
 Logger::~Logger()
 {
-    std::cout << os.str() << std::endl;
+    std::string record = Buffer().str();
+    Writer().Push(record);
+}
+
+void Logger::Set(LogLevel level, const std::string& filter)
+{
+    m_level = level;
+    m_filter = filter;
+}
+
+LogLevel Logger::Level()
+{
+    return m_level;
+}
+
+const std::string& Logger::Filter()
+{
+    return m_filter;
+}
+
+void Logger::SetFile(const std::string& filename)
+{
+    Writer().SetFile(filename);
+}
+
+void Logger::Flush()
+{
+    Writer().Flush();
+}
+
+void Logger::AfterFork()
+{
+    // the forked writer has no thread, and its mutexes may have been held
+    // by it, so it is abandoned rather than destroyed
+    LogWriter* const forked = WriterPtr().release();
+    WriterPtr().reset(new LogWriter);
+    try
+    {
+        Writer().SetFile(forked->Filename());
+    }
+    catch (const std::exception&)
+    {
+        // stderr
+    }
+}
+
+LogLevel Logger::GetLevel(const std::string& name)
+{
+    for (int i = LogOff; i <= LogDebug; ++i)
+    {
+        std::string lower{levelNames[i]};
+        for (auto & c : lower)
+            c = std::tolower(c);
+
+        if (name == lower)
+            return static_cast<LogLevel>(i);
+    }
+    throw std::runtime_error(std::string("Error: Unknown log level: ") + name);
+}
+
+std::string_view Logger::Subsystem(const char* file)
+{
+    // source file name without directory or extension
+    std::string_view subsystem{file};
+    const size_t slash = subsystem.find_last_of("/\\");
+    if (slash != std::string_view::npos)
+        subsystem.remove_prefix(slash + 1);
+    return subsystem.substr(0, subsystem.find('.'));
+}
+
+bool Logger::Matches(std::string_view subsystem)
+{
+    std::string_view filter{m_filter};
+    while (!filter.empty())
+    {
+        const size_t comma = filter.find(',');
+        if (filter.substr(0, comma) == subsystem)
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        filter.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+LoggerScope::LoggerScope(LogLevel level, const std::string& filter)
+: m_savedLevel{Logger::Level()}, m_savedFilter{Logger::Filter()}
+{
+    Logger::Set(level, filter);
+}
+
+LoggerScope::~LoggerScope()
+{
+    Logger::Set(m_savedLevel, m_savedFilter);
 }
 
 } // namespace luteconv
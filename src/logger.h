@@ -2,54 +2,157 @@
 #define _LOGGER_H_
 
 #include <sstream>
+#include <string>
+#include <string_view>
 
 namespace luteconv
 {
 
-#define LOGGER \
-if (!Logger::Verbose()) ; \
-else Logger().Get()
+// Log a record at level, the subsystem is the name of the source file.
+// When the level is disabled for the calling thread the record is not formatted.
+#define LOGGER_LEVEL(level) \
+if (!luteconv::Logger::Enabled(level, __FILE__)) ; \
+else luteconv::Logger(level, __FILE__).Get()
 
-//  A very very simple logger
+#define LOGGER LOGGER_LEVEL(luteconv::LogInfo)
+#define LOGGER_WARNING LOGGER_LEVEL(luteconv::LogWarning)
+#define LOGGER_DEBUG LOGGER_LEVEL(luteconv::LogDebug)
+
+enum LogLevel
+{
+    LogOff,
+    LogError,
+    LogWarning,
+    LogInfo,
+    LogDebug
+};
+
+// A simple asynchronous logger.  Records are formatted on the calling thread
+// and written to stderr, or a file, by a background thread.
 class Logger
 {
 public:
-    
+
     /**
      * Constructor
+     *
+     * @param[in] level
+     * @param[in] file source file, its name is the subsystem
      */
-    Logger() = default;
-    
+    Logger(LogLevel level, const char* file);
+
     /**
-     * Destructor
+     * Destructor, queues the record
      */
     ~Logger();
 
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
     /**
-     * Get the logger
+     * Get the stream to format the record
      */
     std::ostringstream& Get();
-    
+
+    /**
+     * Set the level and subsystem filter for the calling thread
+     *
+     * @param[in] level records above this level are discarded
+     * @param[in] filter comma separated subsystems to log, empty => all
+     */
+    static void Set(LogLevel level, const std::string& filter = "");
+
+    /**
+     * Get the level of the calling thread
+     *
+     * @return level
+     */
+    static LogLevel Level();
+
+    /**
+     * Get the subsystem filter of the calling thread
+     *
+     * @return filter
+     */
+    static const std::string& Filter();
+
+    /**
+     * Is logging enabled for the calling thread
+     *
+     * @param[in] level
+     * @param[in] file source file
+     * @return true <=> enabled
+     */
+    static bool Enabled(LogLevel level, const char* file)
+    {
+        return level <= m_level && (m_filter.empty() || Matches(Subsystem(file)));
+    }
+
+    /**
+     * Write records to a file rather than stderr, for all threads.
+     *
+     * @param[in] filename empty => stderr
+     */
+    static void SetFile(const std::string& filename);
+
     /**
-     * Set verbose logging
-     * 
-     * @param[in] verbode
+     * Wait until all queued records have been written
      */
-   static void SetVerbose(bool verbose);
-   
-   /**
-    * Get verbosity
-    * 
-    * @return true <=> verbose
-    */
-   static bool Verbose();
+    static void Flush();
+
+    /**
+     * Start a new writer in a forked child, whose copy of the writer has no
+     * thread.  Records go to the same file, or stderr, as the parent's.
+     */
+    static void AfterFork();
+
+    /**
+     * Parse a level name
+     *
+     * @param[in] name "off", "error", "warning", "info" or "debug"
+     * @return level
+     */
+    static LogLevel GetLevel(const std::string& name);
 
 private:
-   std::ostringstream os;
-   static bool m_verbose;
+    static std::string_view Subsystem(const char* file);
+    static bool Matches(std::string_view subsystem);
+
+    const LogLevel m_recordLevel;
+    const char* const m_file;
+    static thread_local LogLevel m_level;
+    static thread_local std::string m_filter;
+};
+
+/**
+ * Set logging for the calling thread for the lifetime
+ * of this object, then restore the previous setting
+ */
+class LoggerScope
+{
+public:
+
+    /**
+     * Constructor
+     *
+     * @param[in] level
+     * @param[in] filter comma separated subsystems to log, empty => all
+     */
+    LoggerScope(LogLevel level, const std::string& filter);
+
+    /**
+     * Destructor
+     */
+    ~LoggerScope();
+
+    LoggerScope(const LoggerScope&) = delete;
+    LoggerScope& operator=(const LoggerScope&) = delete;
+
+private:
+    const LogLevel m_savedLevel;
+    const std::string m_savedFilter;
 };
 
 } // namespace luteconv
 
 #endif // _LOGGER_H_
-
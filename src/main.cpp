@@ -1,9 +1,96 @@
 #include "converter.h"
+#include "logger.h"
+#include "parallel.h"
+#include "pieceinfo.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "workerpool.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+/**
+ * Convert a batch of files, see --batch
+ *
+ * @tparam Pool Scheduler, threads, or WorkerPool, processes
+ * @param[in] options
+ * @retval 0 => OK
+ * @retval 1 => one or more files failed
+ */
+template <typename Pool>
+int Batch(const luteconv::Options& options)
+{
+    Pool pool(options.m_jobs, options.m_timeout);
+    for (const auto & srcFilename : options.m_srcFilenames)
+        pool.Add(options.BatchOptions(srcFilename));
+
+    // worker processes are measured apart, their files' statistics sum to the total
+    constexpr bool inProcess = std::is_same<Pool, luteconv::Scheduler>::value;
+    luteconv::Stats process;
+    if (inProcess && !options.m_stats.empty())
+        process.StartProcess();
+    pool.Run(!options.m_stats.empty());
+    if (inProcess && !options.m_stats.empty())
+        process.StopProcess();
+
+    int rc{0};
+    std::vector<luteconv::Stats> stats;
+    for (const auto & job : pool.Jobs())
+    {
+        if (!job.m_error.empty())
+        {
+            std::cerr << job.m_options.m_srcFilename << ": " << job.m_error << std::endl;
+            rc = 1;
+        }
+        stats.push_back(job.m_stats);
+    }
+
+    if (!options.m_stats.empty())
+        luteconv::Stats::Print(std::cout, stats, options.m_stats == "json", inProcess ? &process : nullptr);
+    return rc;
+}
+
+/**
+ * Print the metadata of the source files, see --info
+ *
+ * @param[in] options
+ * @retval 0 => OK
+ * @retval 1 => one or more files failed
+ */
+int Info(const luteconv::Options& options)
+{
+    std::vector<luteconv::PieceInfo> infos(options.m_srcFilenames.size());
+    luteconv::Parallel::For(infos.size(), options.m_jobs, [&options, &infos](size_t begin, size_t end)
+        {
+            luteconv::Converter converter;
+            for (size_t i = begin; i < end; ++i)
+            {
+                try
+                {
+                    converter.Info(options.InfoOptions(options.m_srcFilenames[i]), infos[i]);
+                }
+                catch (const std::exception & e)
+                {
+                    infos[i].m_srcFilename = options.m_srcFilenames[i];
+                    infos[i].m_error = e.what();
+                }
+            }
+        });
+
+    luteconv::PieceInfo::Print(std::cout, infos, options.m_info == "json");
+    return std::any_of(infos.cbegin(), infos.cend(),
+            [](const luteconv::PieceInfo& info) { return !info.m_error.empty(); }) ? 1 : 0;
+}
+
+} // namespace
 
 /**
  * tab to musicxml
@@ -15,19 +102,50 @@
  */
 int main(int argc, char *argv[]) 
 {
+    int rc{0};
     try
     {
         luteconv::Options options;
         options.ProcessArgs(argc, argv);
+        luteconv::Logger::Set(options.m_logLevel, options.m_logFilter);
+        if (!options.m_logFile.empty())
+            luteconv::Logger::SetFile(options.m_logFile);
+        if (!options.m_traceFile.empty())
+            luteconv::Trace::Start();
 
         luteconv::Converter converter;
-        converter.Convert(options);
+        if (!options.m_info.empty())
+        {
+            rc = Info(options);
+        }
+        else if (!options.m_batchDir.empty())
+        {
+            if (options.m_isolate)
+                rc = Batch<luteconv::WorkerPool>(options);
+            else
+                rc = Batch<luteconv::Scheduler>(options);
+        }
+        else if (options.m_stats.empty())
+        {
+            converter.Convert(options);
+        }
+        else
+        {
+            std::vector<luteconv::Stats> stats(1);
+            converter.Convert(options, stats.front());
+            luteconv::Stats::Print(std::cout, stats, options.m_stats == "json");
+        }
+
+        if (!options.m_traceFile.empty())
+            luteconv::Trace::Write(options.m_traceFile);
     }
     catch (const std::exception & e)
     {
+        luteconv::Logger::Flush();
         std::cerr << e.what() << std::endl;
         return 1;
     }
     
-    return 0;
+    luteconv::Logger::Flush();
+    return rc;
 }
@@ -1,10 +1,11 @@
 #include "options.h"
+#include "platform.h"
+#include "trace.h"
 
 #include <popl/include/popl.hpp>
 
 #include <iostream>
-
-#include "logger.h"
+#include <map>
 
 namespace luteconv
 {
@@ -27,6 +28,8 @@ void Options::PrintHelp(const std::string & allowed)
             << "Supported source formats: ft3, jtxml, jtz, mei, musicxml, mxl, tab, tc" << std::endl
             << "Supported desination formats: mei, musicxml, mxl, tab, tc" << std::endl
             << "Usage: luteconv [options ...] source-file [destination-file]" << std::endl
+            << "       luteconv [options ...] --batch directory source-file ..." << std::endl
+            << "       luteconv [options ...] --info[=json] source-file ..." << std::endl
             << std::endl
             << allowed << std::endl
             << "The destination-file can be specified either using the --output option" << std::endl
@@ -39,6 +42,8 @@ void Options::PrintHelp(const std::string & allowed)
             << std::endl
             << "format = \"ft3\" | \"jtxml\" | \"jtz\" | \"mei\" | \"musicxml\" | \"mxl\" | \"tab\" | \"tc\"" << std::endl
             << "   if a file format is not specified then the filetype is used." << std::endl
+            << "   mxl <=> musicxml and jtz => jtxml copy the contents without parsing," << std::endl
+            << "   unless --tuning, --7tuning, --flags or --Dsttabtype is given." << std::endl
             << std::endl
             << "tuning = Courses in scientific pitch notation, in increasing course number." << std::endl
             << "    Luteconv uses the tuning specifed by option --tuning, if given; otherwise" << std::endl
@@ -46,13 +51,47 @@ void Options::PrintHelp(const std::string & allowed)
             << "    tuning is based on the number of courses used in the piece as follows:" << std::endl
             << "    = 8   \"G4 D4 A3 F3 C3 G2 F2 D2\"" << std::endl
             << "    <= 10 \"G4 D4 A3 F3 C3 G2 F2 Eb2 D2 C2\"" << std::endl
-            << "    >= 11 \"F4 D4 A3 F3 D3 A2 G2 F2 E2 D2 C2 B1 A1\"" << std::endl
+            << "    >= 11 \"F4 D4 A3 F3 D3 A2 G2 F2 E2 D2 C2 B1 A1 G1\"" << std::endl
             << "    Option --7tuning, if given, will then modify the tuning of the" << std::endl
             << "    7th, 8th, ... courses." << std::endl
             << std::endl
             << "Where the source format allows more than one piece per file" << std::endl
             << "the --index option selects the desired piece, counting from 0.  Default 0." << std::endl
             << std::endl
+            << "Option --tabindex saves the offset of each section of a tab file in" << std::endl
+            << "source-file.tabidx, later conversions of the same file read just the" << std::endl
+            << "section selected by --index." << std::endl
+            << std::endl
+            << "Option --jobs sets the number of threads used for large pieces, 0 uses" << std::endl
+            << "one thread per processor.  Default 1." << std::endl
+            << std::endl
+            << "Option --loglevel = off | error | warning | info | debug.  Default off," << std::endl
+            << "--Verbose sets info.  The log is written to stderr, or to --logfile." << std::endl
+            << "Option --logfilter logs only the given comma separated subsystems," << std::endl
+            << "e.g. parsertab,parsermei." << std::endl
+            << std::endl
+            << "Option --stats[=json] prints the time spent in each stage of the conversion," << std::endl
+            << "bytes in and out, bar, chord and note counts and peak RSS." << std::endl
+            << "Option --trace writes a Chrome trace of the conversion, one track per thread," << std::endl
+            << "to view in chrome://tracing or https://ui.perfetto.dev" << std::endl
+            << std::endl
+            << "Option --batch converts each source-file into directory, named for the" << std::endl
+            << "source-file with the type of --dstformat, which must be given.  --jobs" << std::endl
+            << "files are converted at a time, largest first.  Source-files must have" << std::endl
+            << "different names.  Option --timeout limits the seconds per file, a file" << std::endl
+            << "that takes longer fails and the batch continues." << std::endl
+            << "Option --isolate converts in --jobs worker processes, a file that crashes" << std::endl
+            << "its worker fails, the worker is restarted and the batch continues." << std::endl
+            << std::endl
+            << "Option --info[=json] prints the title, composer, copyright, credits, tuning," << std::endl
+            << "time signature and number of bars of each source-file, without converting." << std::endl
+            << "The chords are skimmed, not kept, and --jobs files are read at a time." << std::endl
+            << std::endl
+            << "Options --maxinput, --maxinflated, --maxratio, --maxentries, --maxbars and" << std::endl
+            << "--maxnotes limit the source file bytes, decompressed bytes, compression ratio," << std::endl
+            << "zip entries, bars and notes, 0 => no limit.  Default 268435456, 268435456," << std::endl
+            << "200, 1000, 1000000 and 10000000." << std::endl
+            << std::endl
             << "Report bugs to: paul@bayleaf.org.uk" << std::endl
             << "pkg home page: <https://bitbucket.org/bayleaf/luteconv/src/master/>" << std::endl
             << "General help using GNU software: <https://www.gnu.org/gethelp/>" << std::endl
@@ -77,7 +116,24 @@ void Options::ProcessArgs(int argc, char** argv)
     auto indexOption = op.add<Value<std::string>>("i", "index", "Set section index", "0", &m_index);
     auto flagsOption = op.add<Value<int>>("f", "flags", "Add flags to destination rhythm", 0, &m_flags);
     auto verboseOption = op.add<Switch>("V", "Verbose", "Set verbose output");
+    auto logLevelOption = op.add<Value<std::string>>("", "loglevel", "Set log level");
+    auto logFilterOption = op.add<Value<std::string>>("", "logfilter", "Log only these subsystems", "", &m_logFilter);
+    auto logFileOption = op.add<Value<std::string>>("", "logfile", "Set log file", "", &m_logFile);
+    auto statsOption = op.add<Implicit<std::string>>("", "stats", "Print statistics, text or json", "text");
+    auto infoOption = op.add<Implicit<std::string>>("", "info", "Print metadata, text or json", "text");
+    op.add<Value<uint64_t>>("", "maxinput", "Limit source file bytes", m_limits.m_maxInputBytes, &m_limits.m_maxInputBytes);
+    op.add<Value<uint64_t>>("", "maxinflated", "Limit decompressed bytes", m_limits.m_maxInflatedBytes, &m_limits.m_maxInflatedBytes);
+    op.add<Value<uint64_t>>("", "maxratio", "Limit compression ratio", m_limits.m_maxRatio, &m_limits.m_maxRatio);
+    op.add<Value<uint64_t>>("", "maxentries", "Limit zip entries", m_limits.m_maxZipEntries, &m_limits.m_maxZipEntries);
+    op.add<Value<uint64_t>>("", "maxbars", "Limit bars", m_limits.m_maxBars, &m_limits.m_maxBars);
+    op.add<Value<uint64_t>>("", "maxnotes", "Limit notes", m_limits.m_maxNotes, &m_limits.m_maxNotes);
+    auto traceOption = op.add<Value<std::string>>("", "trace", "Write a Chrome trace file", "", &m_traceFile);
     auto wrapOption = op.add<Value<int>>("w", "wrap", "Stave wrap threshold", 25, &m_wrapThreshold);
+    auto jobsOption = op.add<Value<int>>("j", "jobs", "Set number of threads", 1, &m_jobs);
+    auto tabIndexOption = op.add<Switch>("", "tabindex", "Cache tab section offsets");
+    auto batchOption = op.add<Value<std::string>>("", "batch", "Convert source files into directory", "", &m_batchDir);
+    op.add<Value<double>>("", "timeout", "Limit seconds per file of a batch", 0.0, &m_timeout);
+    auto isolateOption = op.add<Switch>("", "isolate", "Convert batch files in worker processes");
     
     op.parse(argc, argv);
     
@@ -88,7 +144,7 @@ void Options::ProcessArgs(int argc, char** argv)
         throw std::runtime_error(ss.str().c_str());
     }
     
-    if (op.non_option_args().size() > 2)
+    if (op.non_option_args().size() > 2 && !batchOption->is_set() && !infoOption->is_set())
     {
         throw std::runtime_error("Error: too many arguments");
     }
@@ -120,6 +176,7 @@ void Options::ProcessArgs(int argc, char** argv)
     if (dstTabTypeOption->is_set())
     {
         m_dstTabType = GetTabType(dstTabTypeOption->value());
+        m_dstTabTypeSet = true;
     }    
 
     if (srcFormatOption->is_set())
@@ -146,7 +203,82 @@ void Options::ProcessArgs(int argc, char** argv)
 
     if (verboseOption->is_set())
     {
-        Logger::SetVerbose(true);
+        m_logLevel = LogInfo;
+    }
+    
+    if (logLevelOption->is_set())
+    {
+        m_logLevel = Logger::GetLevel(logLevelOption->value());
+    }
+    
+    if (statsOption->is_set())
+    {
+        m_stats = statsOption->value();
+        if (m_stats != "text" && m_stats != "json")
+            throw std::runtime_error(std::string("Error: Unknown statistics format: ") + m_stats);
+    }
+    
+    if (traceOption->is_set() && !Trace::Compiled())
+    {
+        throw std::runtime_error("Error: --trace needs a build with cmake -DTRACE=ON");
+    }
+    
+    if (tabIndexOption->is_set())
+    {
+        m_tabIndexCache = true;
+    }
+    
+    if (m_jobs < 0)
+        throw std::runtime_error(std::string("Error: number of jobs must not be negative"));
+    
+    if (m_timeout < 0.0)
+        throw std::runtime_error(std::string("Error: timeout must not be negative"));
+    
+    if (isolateOption->is_set())
+    {
+        if (!batchOption->is_set())
+            throw std::runtime_error(std::string("Error: --isolate needs --batch"));
+        m_isolate = true;
+    }
+    
+    if (infoOption->is_set())
+    {
+        m_info = infoOption->value();
+        if (m_info != "text" && m_info != "json")
+            throw std::runtime_error(std::string("Error: Unknown information format: ") + m_info);
+        if (batchOption->is_set() || outputOption->is_set())
+            throw std::runtime_error(std::string("Error: --info, --batch and --output are exclusive"));
+        
+        // source filenames, each source's format is set by InfoOptions
+        m_srcFilenames = op.non_option_args();
+        if (m_srcFilenames.empty())
+            throw std::runtime_error(std::string("Error: source filename missing"));
+        return;
+    }
+    
+    if (batchOption->is_set())
+    {
+        // source filenames, each source's format is set by BatchOptions
+        m_srcFilenames = op.non_option_args();
+        if (m_srcFilenames.empty())
+            throw std::runtime_error(std::string("Error: source filename missing"));
+        if (outputOption->is_set())
+            throw std::runtime_error(std::string("Error: --batch and --output are exclusive"));
+        if (m_dstFormat == FormatUnknown)
+            throw std::runtime_error(std::string("Error: --batch needs --dstformat"));
+        if (m_dstTabType == TabUnknown)
+            throw std::runtime_error(std::string("Error: unknown destination tablature type"));
+        
+        // sources with the same stem would write the same destination concurrently
+        std::map<std::string, std::string> dstFilenames;
+        for (const auto & srcFilename : m_srcFilenames)
+        {
+            const auto inserted = dstFilenames.emplace(BatchDstFilename(srcFilename), srcFilename);
+            if (!inserted.second)
+                throw std::runtime_error("Error: " + inserted.first->second + " and " + srcFilename +
+                        " both convert to " + inserted.first->first);
+        }
+        return;
     }
     
     // source filename
@@ -183,6 +315,55 @@ void Options::SetFormatFilename()
         m_dstFormat = GetFormatFilename(m_dstFilename);
 }
 
+Options Options::BatchOptions(const std::string& srcFilename) const
+{
+    Options options{*this};
+    options.m_srcFilename = srcFilename;
+    options.m_srcFilenames.clear();
+    
+    // batch files are converted concurrently, each on one thread
+    options.m_jobs = 1;
+    
+    options.m_dstFilename = BatchDstFilename(srcFilename);
+    options.SetFormatFilename();
+    return options;
+}
+
+std::string Options::BatchDstFilename(const std::string& srcFilename) const
+{
+    std::string stem{srcFilename};
+    const size_t slash = stem.find_last_of(pathSeparator);
+    if (slash != std::string::npos)
+        stem = stem.substr(slash + 1);
+    const size_t dot = stem.find_last_of(".");
+    if (dot != std::string::npos)
+        stem = stem.substr(0, dot);
+    return m_batchDir + pathSeparator + stem + "." + GetFileType(m_dstFormat);
+}
+
+Options Options::InfoOptions(const std::string& srcFilename) const
+{
+    Options options{*this};
+    options.m_srcFilename = srcFilename;
+    options.m_srcFilenames.clear();
+    
+    // files are read concurrently, each on one thread
+    options.m_jobs = 1;
+    
+    options.SetFormatFilename();
+    return options;
+}
+
+bool Options::Passthrough() const
+{
+    if (!m_tuning.empty() || !m_7tuning.empty() || m_flags != 0 || m_dstTabTypeSet)
+        return false;
+    
+    return (m_srcFormat == FormatMxl && m_dstFormat == FormatMusicxml) ||
+           (m_srcFormat == FormatMusicxml && m_dstFormat == FormatMxl) ||
+           (m_srcFormat == FormatJtz && m_dstFormat == FormatJtxml);
+}
+
 TabType Options::GetTabType(const std::string& tabType)
 {
     if (tabType == "french")
@@ -210,6 +391,31 @@ Format Options::GetFormatFilename(const std::string& filename)
     return FormatUnknown;
 }
 
+std::string Options::GetFileType(Format format)
+{
+    switch (format)
+    {
+    case FormatFt3:
+        return "ft3";
+    case FormatJtxml:
+        return "jtxml";
+    case FormatJtz:
+        return "jtz";
+    case FormatMei:
+        return "mei";
+    case FormatMusicxml:
+        return "musicxml";
+    case FormatMxl:
+        return "mxl";
+    case FormatTab:
+        return "tab";
+    case FormatTabCode:
+        return "tc";
+    default:
+        return "";
+    }
+}
+
 Format Options::GetFormat(const std::string& format)
 {
     if (format == "ft3")
@@ -1,6 +1,8 @@
 #ifndef _OPTIONS_H_
 #define _OPTIONS_H_
 
+#include "inputlimits.h"
+#include "logger.h"
 #include "pitch.h"
 
 #include <string>
@@ -57,23 +59,65 @@ public:
      */
     void SetFormatFilename();
     
+    /**
+     * Options to convert one source file of a batch, see --batch.  The destination
+     * is in the batch directory, named for the source with the destination file type.
+     *
+     * @param[in] srcFilename
+     * @return options
+     */
+    Options BatchOptions(const std::string& srcFilename) const;
+    
+    /**
+     * Options to read the metadata of one source file, see --info
+     *
+     * @param[in] srcFilename
+     * @return options
+     */
+    Options InfoOptions(const std::string& srcFilename) const;
+    
+    /**
+     * Is the conversion between a zip archive and the file it contains, mxl <=>
+     * musicxml or jtz => jtxml, with no option that changes the content.  Such
+     * a conversion copies the contents without parsing them.
+     *
+     * @return true <=> passthrough
+     */
+    bool Passthrough() const;
+    
     Format m_srcFormat{FormatUnknown};
     Format m_dstFormat{FormatUnknown};
     TabType m_srcTabType{TabUnknown};
     TabType m_dstTabType{TabFrench};
+    bool m_dstTabTypeSet{false};    // --Dsttabtype given, see Passthrough
     std::vector<Pitch> m_tuning;
     std::vector<Pitch> m_7tuning;
     std::string m_srcFilename;
     std::string m_dstFilename;
+    std::vector<std::string> m_srcFilenames; // batch or --info source files
+    std::string m_batchDir;     // "" => not a batch
+    double m_timeout{0.0};      // seconds per file of a batch, 0 => no limit
+    bool m_isolate{false};      // convert batch files in worker processes
     const std::string m_version;
     std::string m_index{"0"};
     int m_flags{0};
     int m_wrapThreshold{25};
+    int m_jobs{1};
+    LogLevel m_logLevel{LogOff};
+    std::string m_logFilter;
+    std::string m_logFile;
+    std::string m_stats;        // "" => none, "text" or "json"
+    std::string m_info;         // "" => convert, "text" or "json"
+    std::string m_traceFile;
+    InputLimits m_limits;
+    bool m_tabIndexCache{false};
     
 private:
     void PrintHelp(const std::string & allowed);
     Format GetFormat(const std::string& format);
     Format GetFormatFilename(const std::string& filename);
+    static std::string GetFileType(Format format);
+    std::string BatchDstFilename(const std::string& srcFilename) const;
     TabType GetTabType(const std::string& tabType);
 };
 
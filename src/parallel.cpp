@@ -0,0 +1,95 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cancel.h"
+#include "logger.h"
+#include "stats.h"
+#include "trace.h"
+
+namespace luteconv
+{
+
+int Parallel::Threads(int jobs)
+{
+    if (jobs > 0)
+        return jobs;
+
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+}
+
+void Parallel::For(size_t count, int jobs, const std::function<void(size_t, size_t)>& fn)
+{
+    ForRanges(count, jobs, [&fn](size_t, size_t begin, size_t end) { fn(begin, end); });
+}
+
+size_t Parallel::Ranges(size_t count, int jobs)
+{
+    return std::max<size_t>(1, std::min(count, static_cast<size_t>(Threads(jobs))));
+}
+
+void Parallel::ForRanges(size_t count, int jobs, const std::function<void(size_t, size_t, size_t)>& fn)
+{
+    const size_t threads = Ranges(count, jobs);
+    if (threads <= 1)
+    {
+        fn(0, 0, count);
+        return;
+    }
+
+    std::exception_ptr firstException;
+    std::mutex mutex;
+    const LogLevel logLevel = Logger::Level();
+    const std::string logFilter = Logger::Filter();
+    Cancel* const cancel = Cancel::Current();
+    Stats* const stats = Stats::Current();
+    const auto run = [&](size_t range, size_t begin, size_t end)
+    {
+        // workers log, are cancelled, and are counted as the calling thread
+        Logger::Set(logLevel, logFilter);
+        CancelScope cancelScope(cancel);
+        StatsWorkerScope statsScope(stats);
+        TRACE_SPAN("Parallel::For range");
+        try
+        {
+            fn(range, begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!firstException)
+                firstException = std::current_exception();
+        }
+    };
+
+    // ranges differ in size by at most one
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    const size_t quotient = count / threads;
+    const size_t remainder = count % threads;
+    size_t begin = quotient + (remainder > 0 ? 1 : 0);
+    for (size_t i = 1; i < threads; ++i)
+    {
+        const size_t end = begin + quotient + (i < remainder ? 1 : 0);
+        workers.emplace_back(run, i, begin, end);
+        begin = end;
+    }
+
+    run(0, 0, quotient + (remainder > 0 ? 1 : 0));
+
+    {
+        TRACE_SPAN("Parallel::For join");
+        for (auto & worker : workers)
+            worker.join();
+    }
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+}
+
+} // namespace luteconv
@@ -0,0 +1,69 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace luteconv
+{
+
+/**
+ * Split work across threads
+ */
+class Parallel
+{
+public:
+
+    /**
+     * Constructor
+     */
+    Parallel() = default;
+
+    /**
+     * Destructor
+     */
+    ~Parallel() = default;
+
+    /**
+     * Number of threads to use
+     *
+     * @param[in] jobs requested, 0 => one per hardware thread
+     * @return number of threads, >= 1
+     */
+    static int Threads(int jobs);
+
+    /**
+     * Call fn for contiguous ranges [begin, end) covering [0, count), one range
+     * per thread.  The calling thread processes the first range.  Returns when
+     * all ranges are complete.  If any fn throws then the first exception is
+     * rethrown after all threads have finished.
+     *
+     * @param[in] count number of items
+     * @param[in] jobs number of threads requested, 0 => one per hardware thread
+     * @param[in] fn called as fn(begin, end)
+     */
+    static void For(size_t count, int jobs, const std::function<void(size_t, size_t)>& fn);
+    
+    /**
+     * Number of ranges that For splits items into
+     *
+     * @param[in] count number of items
+     * @param[in] jobs number of threads requested, 0 => one per hardware thread
+     * @return number of ranges, >= 1
+     */
+    static size_t Ranges(size_t count, int jobs);
+    
+    /**
+     * As For, also passing the index of the range, so that each range can
+     * have its own state, e.g. a cache, in a vector of Ranges(count, jobs)
+     *
+     * @param[in] count number of items
+     * @param[in] jobs number of threads requested, 0 => one per hardware thread
+     * @param[in] fn called as fn(range, begin, end)
+     */
+    static void ForRanges(size_t count, int jobs, const std::function<void(size_t, size_t, size_t)>& fn);
+};
+
+} // namespace luteconv
+
+#endif // _PARALLEL_H_
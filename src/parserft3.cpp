@@ -1,12 +1,19 @@
 #include "parserft3.h"
 
+#include <sys/stat.h>
 #include <zlib.h>
 
 #include <stdexcept>
 #include <algorithm>
-#include <regex>
 #include <iterator>
 #include <array>
+#include <limits>
+
+#include "cancel.h"
+#include "parallel.h"
+#include "rtf.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -15,8 +22,12 @@ void ParserFt3::Parse(const Options& options, Piece& piece)
 {
     // .ft3 files are (usually) gzipped.  A curious choice of compression for a Windows program.
     std::vector<uint8_t> ft3Image;
-    Gunzip(options.m_srcFilename, ft3Image);
-    
+    Gunzip(options.m_srcFilename, ft3Image, options.m_limits);
+    Parse(ft3Image, options, piece);
+}
+
+void ParserFt3::Parse(const std::vector<uint8_t>& ft3Image, const Options& options, Piece& piece)
+{
     const std::string cpiece{"CPiece"};
     auto headerBegin = std::search(ft3Image.cbegin(), ft3Image.cend(), cpiece.cbegin(), cpiece.cend());
     if (headerBegin == ft3Image.cend())
@@ -30,19 +41,23 @@ void ParserFt3::Parse(const Options& options, Piece& piece)
     auto bodyBegin = headerEnd + cbar.size();
 
     ParseHeader(headerBegin, headerEnd, piece);
-    ParseBody(bodyBegin, ft3Image.cend(), piece);
+    ParseBody(bodyBegin, ft3Image.cend(), options, piece);
     piece.SetTuning(options);
 }
 
-void ParserFt3::Gunzip(const std::string& filename, std::vector<uint8_t>& ft3Image)
+void ParserFt3::Gunzip(const std::string& filename, std::vector<uint8_t>& ft3Image, const InputLimits& limits)
 {
+    StatsScope statsScope("gunzip");
+    TRACE_SPAN("ParserFt3::Gunzip");
+    struct stat st;
+    const uint64_t compressed = stat(filename.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
     gzFile ft3File = gzopen(filename.c_str(), "rb");
     if (!ft3File)
         throw std::runtime_error("Error: Can't open " + filename);
     
     // decompress and read all the file into memory
     const unsigned int blockSize = 4096;
-    unsigned int ft3ImageSize{0};
+    size_t ft3ImageSize{0};
     ft3Image.resize(blockSize);
     
     for (;;)
@@ -54,7 +69,17 @@ void ParserFt3::Gunzip(const std::string& filename, std::vector<uint8_t>& ft3Ima
             throw std::runtime_error(std::string("Error: Reading ") + filename);
         }
         
-        ft3ImageSize += static_cast<unsigned int>(nRead);
+        ft3ImageSize += static_cast<size_t>(nRead);
+        try
+        {
+            limits.CheckInflated(filename, compressed, ft3ImageSize);
+            Cancel::Check();
+        }
+        catch (...)
+        {
+            gzclose(ft3File);
+            throw;
+        }
         if (nRead < static_cast<int>(blockSize))
             break;
     
@@ -66,16 +91,95 @@ void ParserFt3::Gunzip(const std::string& filename, std::vector<uint8_t>& ft3Ima
     gzclose(ft3File);
 }
 
+void ParserFt3::Gunzip(const std::string& filename, const std::vector<char>& image, std::vector<uint8_t>& ft3Image,
+        const InputLimits& limits)
+{
+    StatsScope statsScope("gunzip");
+    TRACE_SPAN("ParserFt3::Gunzip");
+    
+    // as gzread, a file that is not gzipped is read as is
+    const auto gzipped = [](const Bytef* data, size_t size)
+        {
+            return size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+        };
+    const Bytef* const data = reinterpret_cast<const Bytef*>(image.data());
+    if (!gzipped(data, image.size()))
+    {
+        limits.CheckInflated(filename, image.size(), image.size());
+        ft3Image.assign(data, data + image.size());
+        return;
+    }
+    if (image.size() > std::numeric_limits<uInt>::max())
+        throw std::runtime_error(std::string("Error: Reading ") + filename);
+    
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+        throw std::runtime_error(std::string("Error: Reading ") + filename);
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(image.size());
+    
+    const unsigned int blockSize = 64 * 1024;
+    size_t ft3ImageSize{0};
+    try
+    {
+        int rc{Z_OK};
+        for (;;)
+        {
+            if (rc == Z_STREAM_END)
+            {
+                // as gzread, read concatenated gzip members
+                if (!gzipped(stream.next_in, stream.avail_in))
+                    break;
+                inflateReset(&stream);
+            }
+            
+            ft3Image.resize(ft3ImageSize + blockSize);
+            stream.next_out = ft3Image.data() + ft3ImageSize;
+            stream.avail_out = blockSize;
+            rc = inflate(&stream, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END)
+                throw std::runtime_error(std::string("Error: Reading ") + filename);
+            
+            ft3ImageSize += blockSize - stream.avail_out;
+            limits.CheckInflated(filename, image.size(), ft3ImageSize);
+            Cancel::Check();
+        }
+    }
+    catch (...)
+    {
+        inflateEnd(&stream);
+        throw;
+    }
+    inflateEnd(&stream);
+    
+    ft3Image.resize(ft3ImageSize);
+}
+
 void ParserFt3::ParseHeader(const std::vector<uint8_t>::const_iterator headerBegin,
         const std::vector<uint8_t>::const_iterator headerEnd, Piece& piece)
 {
-    std::vector<uint8_t>::const_iterator ptr = headerBegin + 14;
-    int strLen = *ptr++;
-    piece.m_title = ExtractRtf(reinterpret_cast<const char *>(&*ptr), strLen);
+    // three length prefixed strings: title, author, composer
+    std::vector<uint8_t>::const_iterator ptr = headerBegin;
+    const auto nextString = [&ptr, headerEnd]()
+    {
+        if (std::distance(ptr, headerEnd) < 1)
+            throw std::runtime_error(std::string("Error: CPiece header truncated"));
+        const int strLen = *ptr++;
+        if (std::distance(ptr, headerEnd) < strLen)
+            throw std::runtime_error(std::string("Error: CPiece header truncated"));
+        if (strLen == 0)
+            return std::string();
+        const std::string text = Rtf::ExtractText(reinterpret_cast<const char *>(&*ptr), strLen);
+        ptr += strLen;
+        return text;
+    };
+    
+    if (std::distance(ptr, headerEnd) < 14)
+        throw std::runtime_error(std::string("Error: CPiece header truncated"));
+    ptr += 14;
+    piece.m_title = nextString();
     
-    ptr += strLen;
-    strLen = *ptr++;
-    const std::string author = ExtractRtf(reinterpret_cast<const char *>(&*ptr), strLen);
+    const std::string author = nextString();
     if (!author.empty())
     {
         Credit credit;
@@ -84,44 +188,23 @@ void ParserFt3::ParseHeader(const std::vector<uint8_t>::const_iterator headerBeg
         piece.m_credits.push_back(credit);
     }
 
-    ptr += strLen;
-    strLen = *ptr++;
-    piece.m_composer = ExtractRtf(reinterpret_cast<const char *>(&*ptr), strLen);
-}
-
-// Extract the text from RTF, this is a crude regex that works well
-// enough in practice but could be fooled by more complex RTF.
-std::string ParserFt3::ExtractRtf(const char * rtfBegin,
-        int strLen)
-{
-    std::string rtf{rtfBegin, rtfBegin + strLen};
-    
-    // c++ regex doesn't have the equivalent of perl's /s to enable matching \n and \r
-    rtf.erase(std::remove(rtf.begin(), rtf.end(), '\n'), rtf.end());
-    rtf.erase(std::remove(rtf.begin(), rtf.end(), '\r'), rtf.end());
-    
-    const std::regex re{R"(\{(\\[\w\-;]+|\{[^\}\{]*|\}|[\r\n]*)*\s*([^\\\{]*)(\\[\w\-;]+|\{[^\}\{]*|\}|[\r\n]*)*\})"};
-    std::cmatch results;
-    if (std::regex_match(rtf.c_str(), results, re))
-    {
-        return results[2];
-    }
-    else
-    {
-        return rtf;
-    }
+    piece.m_composer = nextString();
 }
 
 void ParserFt3::ParseBody(const std::vector<uint8_t>::const_iterator bodyBegin,
-        const std::vector<uint8_t>::const_iterator bodyEnd, Piece& piece)
+        const std::vector<uint8_t>::const_iterator bodyEnd, const Options& options, Piece& piece)
 {
+    // Find the bar boundaries first, each bar can then be decoded independently
     const std::array<uint8_t, 2> x03x80{0x03, 0x80};
+    std::vector<std::pair<std::vector<uint8_t>::const_iterator, std::vector<uint8_t>::const_iterator>> barRanges;
     auto barBegin = bodyBegin;
     
-    for (int barNum = 1; ; ++barNum)
+    for (;;)
     {
         auto barEnd = std::search(barBegin, bodyEnd, x03x80.cbegin(), x03x80.cend());
-        ParseBar(barNum, barBegin, barEnd, piece);
+        barRanges.emplace_back(barBegin, barEnd);
+        options.m_limits.CheckBars(barRanges.size());
+        Cancel::Check();
         barBegin = barEnd;
         
         if (barBegin == bodyEnd)
@@ -129,13 +212,42 @@ void ParserFt3::ParseBody(const std::vector<uint8_t>::const_iterator bodyBegin,
 
         barBegin += x03x80.size();
     }
+    
+    // Each range interns its chords in its own table, tables[range], and
+    // parses bars [begins[range], ends[range]).  The tables are merged in order afterwards.
+    piece.m_bars.resize(barRanges.size());
+    const size_t ranges = Parallel::Ranges(barRanges.size(), options.m_jobs);
+    std::vector<ChordTable> tables(ranges, ChordTable(piece.m_chords.Skim()));
+    std::vector<size_t> begins(ranges, 0);
+    std::vector<size_t> ends(ranges, 0);
+    Parallel::ForRanges(barRanges.size(), options.m_jobs, [&](size_t range, size_t begin, size_t end)
+    {
+        std::vector<Note> notes;
+        for (size_t i = begin; i < end; ++i)
+        {
+            Cancel::Check();
+            ParseBar(barRanges[i].first, barRanges[i].second, piece.m_bars[i], notes, tables[range]);
+        }
+        begins[range] = begin;
+        ends[range] = end;
+    });
+    
+    for (size_t range = 0; range < ranges; ++range)
+    {
+        const std::vector<ShapeId> shapes = piece.m_chords.Merge(tables[range]);
+        for (size_t i = begins[range]; i < ends[range]; ++i)
+            piece.m_bars[i].Remap(shapes);
+    }
 }
 
-void ParserFt3::ParseBar(int barNum, const std::vector<uint8_t>::const_iterator barBegin,
-        const std::vector<uint8_t>::const_iterator barEnd, Piece& piece)
+void ParserFt3::ParseBar(const std::vector<uint8_t>::const_iterator barBegin,
+        const std::vector<uint8_t>::const_iterator barEnd, Bar& bar, std::vector<Note>& notes, ChordTable& chords)
 {
-    Bar bar;
-    ParseTimeSignature(barBegin, bar);
+    ParseTimeSignature(barBegin, barEnd, bar);
+    
+    // a bar too short for its first chord has none
+    if (std::distance(barBegin, barEnd) < 32)
+        return;
     
     auto ptr = barBegin + 32;
     
@@ -163,7 +275,8 @@ void ParserFt3::ParseBar(int barNum, const std::vector<uint8_t>::const_iterator
         ptr += 4;
         
         // notes
-        while (AtNextNote(ptr[0], ptr[1]))
+        notes.clear();
+        while (std::distance(ptr, barEnd) >= 5 && AtNextNote(ptr[0], ptr[1]))
         {
             Note note;
             
@@ -203,17 +316,17 @@ void ParserFt3::ParseBar(int barNum, const std::vector<uint8_t>::const_iterator
             
             ptr += 5;
             
-            chord.m_notes.push_back(note);
+            notes.push_back(note);
         }
+        chord.m_shape = chords.Intern(notes);
         bar.m_chords.push_back(chord);
     }
-    
-    piece.m_bars.push_back(bar);
 }
 
-void ParserFt3::ParseTimeSignature(const std::vector<uint8_t>::const_iterator barBegin, Bar& bar)
+void ParserFt3::ParseTimeSignature(const std::vector<uint8_t>::const_iterator barBegin,
+        const std::vector<uint8_t>::const_iterator barEnd, Bar& bar)
 {
-    const uint8_t timeSignature = barBegin[0] & 0x7f;
+    const uint8_t timeSignature = barBegin != barEnd ? barBegin[0] & 0x7f : 0x00;
 
     // time signature
     if (timeSignature == 0x01)
@@ -234,7 +347,7 @@ void ParserFt3::ParseTimeSignature(const std::vector<uint8_t>::const_iterator ba
         bar.m_timeSig.m_beats = 3;
         bar.m_timeSig.m_beatType = 4;
     }
-    else if (timeSignature == 0x06)
+    else if (timeSignature == 0x06 && std::distance(barBegin, barEnd) >= 10)
     {
         bar.m_timeSig.m_timeSymbol = TimeSyNormal;
         bar.m_timeSig.m_beats = barBegin[9];
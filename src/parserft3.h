@@ -30,6 +30,9 @@ namespace luteconv
  * No voice text
  * No mensural notation
  * No ties
+ *
+ * Bars are delimited by 0x03 0x80 so once the bar boundaries are found
+ * the bars can be decoded concurrently, see Options::m_jobs.
  */
 class ParserFt3
 {
@@ -46,28 +49,55 @@ public:
     ~ParserFt3() = default;
     
     /**
-     * Parse .tab file
+     * Parse .ft3 file
      *
      * @param[in] options
      * @param[out] piece destination
      */
     void Parse(const Options& options, Piece& piece);
     
+    /**
+     * Parse .ft3 image
+     *
+     * @param[in] ft3Image uncompressed .ft3 file contents
+     * @param[in] options
+     * @param[out] piece destination
+     */
+    void Parse(const std::vector<uint8_t>& ft3Image, const Options& options, Piece& piece);
+    
+    /**
+     * Read and uncompress .ft3 file
+     *
+     * @param[in] filename
+     * @param[out] ft3Image uncompressed file contents
+     * @param[in] limits on the uncompressed size
+     */
+    static void Gunzip(const std::string& filename, std::vector<uint8_t>& ft3Image, const InputLimits& limits = InputLimits());
+    
+    /**
+     * Uncompress .ft3 file already read into memory
+     *
+     * @param[in] filename for messages
+     * @param[in] image file contents
+     * @param[out] ft3Image uncompressed file contents
+     * @param[in] limits on the uncompressed size
+     */
+    static void Gunzip(const std::string& filename, const std::vector<char>& image, std::vector<uint8_t>& ft3Image,
+            const InputLimits& limits = InputLimits());
+    
 private:
-    void Gunzip(const std::string& filename, std::vector<uint8_t>& ft3Image);
     
     void ParseHeader(const std::vector<uint8_t>::const_iterator headerBegin,
             const std::vector<uint8_t>::const_iterator headerEnd, Piece& piece);
     
-    std::string ExtractRtf(const char* rtfBegin, int strLen);
-    
     void ParseBody(const std::vector<uint8_t>::const_iterator bodyBegin,
-            const std::vector<uint8_t>::const_iterator bodyEnd, Piece& piece);
+            const std::vector<uint8_t>::const_iterator bodyEnd, const Options& options, Piece& piece);
     
-    void ParseBar(int barNum, const std::vector<uint8_t>::const_iterator barBegin,
-            const std::vector<uint8_t>::const_iterator barEnd, Piece& piece);
+    void ParseBar(const std::vector<uint8_t>::const_iterator barBegin,
+            const std::vector<uint8_t>::const_iterator barEnd, Bar& bar, std::vector<Note>& notes, ChordTable& chords);
     
-    void ParseTimeSignature(const std::vector<uint8_t>::const_iterator barBegin, Bar& bar);
+    void ParseTimeSignature(const std::vector<uint8_t>::const_iterator barBegin,
+            const std::vector<uint8_t>::const_iterator barEnd, Bar& bar);
     
     static bool AtNextNote(uint8_t s, uint8_t f);
     
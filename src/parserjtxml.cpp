@@ -4,8 +4,11 @@
 #include <sstream>
 #include <stdexcept>
 
+#include "cancel.h"
 #include "pitch.h"
 #include "logger.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -15,14 +18,24 @@ using namespace pugi;
 void ParserJtxml::Parse(const std::string& filename, void* contents, size_t size, const Options& options, Piece& piece)
 {
     xml_document doc;
-    xml_parse_result result = doc.load_buffer_inplace(contents, size);
+    xml_parse_result result;
+    {
+        StatsScope statsScope("xml");
+        TRACE_SPAN("pugixml load");
+        result = doc.load_buffer_inplace(contents, size);
+    }
     Parse(filename, doc, result, options, piece);
 }
 
 void ParserJtxml::Parse(const Options& options, Piece& piece)
 {
     xml_document doc;
-    xml_parse_result result = doc.load_file(options.m_srcFilename.c_str());
+    xml_parse_result result;
+    {
+        StatsScope statsScope("xml");
+        TRACE_SPAN("pugixml load");
+        result = doc.load_file(options.m_srcFilename.c_str());
+    }
     Parse(options.m_srcFilename, doc, result, options, piece);
 }
   
@@ -60,7 +73,7 @@ void ParserJtxml::Parse(const std::string& filename, xml_document& doc, xml_pars
         xml_node xmlstaff = xmlsystem.child("instruments").child("instrument").child("staff");
         if (!xmlstaff)
         {
-            LOGGER << "No xmlstaff";
+            LOGGER_WARNING << "No xmlstaff";
         }
         
         piece.m_bars.push_back(Bar());
@@ -73,6 +86,8 @@ void ParserJtxml::Parse(const std::string& filename, xml_document& doc, xml_pars
         
         if (piece.m_bars.back().m_chords.empty())
             piece.m_bars.pop_back();
+        options.m_limits.CheckBars(piece.m_bars.size());
+        Cancel::Check();
     }
     
     piece.SetTuning(options);
@@ -112,13 +127,14 @@ void ParserJtxml::ParseEvent(xml_node& xmlevent, Piece& piece)
         xml_node xmlnotes = xmlevent.child("notes");
         if (!xmlnotes)
         {
-            LOGGER << "No notes";
+            LOGGER_WARNING << "No notes";
         }
+        std::vector<Note> notes;
         for (xml_node xmlnote = xmlnotes.child("note"); xmlnote;
                 xmlnote = xmlnote.next_sibling("note"))
         {
-            chord.m_notes.push_back(Note());
-            Note& note = chord.m_notes.back();
+            notes.push_back(Note());
+            Note& note = notes.back();
             
             note.m_string = xmlnote.attribute("string").as_int() + 1;
             // jtxml doesn't store the fret but rather the pitch as a MIDI note.  Calculate the fret from the tuning.
@@ -126,6 +142,7 @@ void ParserJtxml::ParseEvent(xml_node& xmlevent, Piece& piece)
             // TODO fingering
             // TODO ornaments
         }
+        chord.m_shape = piece.m_chords.Intern(notes);
     }
     else if (type == "bar")
     {
@@ -146,7 +163,7 @@ void ParserJtxml::ParseEvent(xml_node& xmlevent, Piece& piece)
     }
     else
     {
-        LOGGER << "Unprocessed event=" << type;
+        LOGGER_WARNING << "Unprocessed event=" << type;
     }
 }
 
@@ -229,7 +246,7 @@ void ParserJtxml::ParseFlag(int flagNum, Chord& chord)
             break;
 
         default:
-            LOGGER << "Unprocessed flag=" << flagNum;
+            LOGGER_WARNING << "Unprocessed flag=" << flagNum;
             break;
     }
 }
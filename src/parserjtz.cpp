@@ -13,7 +13,16 @@ void ParserJtz::Parse(const Options& options, Piece& piece)
 {
     std::vector<char> image;
     std::string zipFilename;
-    Unzipper::Unzip(options.m_srcFilename, image, zipFilename);
+    Unzipper::Unzip(options.m_srcFilename, image, zipFilename, options.m_limits);
+    ParserJtxml parser;
+    parser.Parse(zipFilename, image.data(), image.size(), options, piece);
+}
+
+void ParserJtz::Parse(const Options& options, const std::vector<char>& zipImage, Piece& piece)
+{
+    std::vector<char> image;
+    std::string zipFilename;
+    Unzipper::Unzip(options.m_srcFilename, zipImage, image, zipFilename, options.m_limits);
     ParserJtxml parser;
     parser.Parse(zipFilename, image.data(), image.size(), options, piece);
 }
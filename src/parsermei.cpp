@@ -6,9 +6,12 @@
 #include <algorithm>
 #include <stdexcept>
 
+#include "cancel.h"
 #include "mei.h"
 #include "pitch.h"
 #include "logger.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -18,14 +21,24 @@ using namespace pugi;
 void ParserMei::Parse(const std::string& filename, void* contents, size_t size, const Options& options, Piece& piece)
 {
     xml_document doc;
-    xml_parse_result result = doc.load_buffer_inplace(contents, size);
+    xml_parse_result result;
+    {
+        StatsScope statsScope("xml");
+        TRACE_SPAN("pugixml load");
+        result = doc.load_buffer_inplace(contents, size);
+    }
     Parse(filename, doc, result, options, piece);
 }
 
 void ParserMei::Parse(const Options& options, Piece& piece)
 {
     xml_document doc;
-    xml_parse_result result = doc.load_file(options.m_srcFilename.c_str());
+    xml_parse_result result;
+    {
+        StatsScope statsScope("xml");
+        TRACE_SPAN("pugixml load");
+        result = doc.load_file(options.m_srcFilename.c_str());
+    }
     Parse(options.m_srcFilename, doc, result, options, piece);
 }
   
@@ -70,10 +83,13 @@ void ParserMei::Parse(const std::string& filename, xml_document& doc, xml_parse_
         throw std::runtime_error("Error: Can't find <section>");
 
     bool firstBar{true};
+    FingIndex fings;
     for (xml_node xmlmeasure = xmlsection.child("measure"); xmlmeasure; xmlmeasure = xmlmeasure.next_sibling("measure"))
     {
         const int measureNo{xmlmeasure.attribute("n").as_int()};
         piece.m_bars.push_back(Bar());
+        options.m_limits.CheckBars(piece.m_bars.size());
+        Cancel::Check();
         Bar& bar = piece.m_bars.back();
         
         if (firstBar && timeSig.m_timeSymbol != TimeSyNone)
@@ -82,36 +98,38 @@ void ParserMei::Parse(const std::string& filename, xml_document& doc, xml_parse_
         xml_node xmllayer = xmlmeasure.child("staff").child("layer");
         if (!xmllayer)
         {
-            LOGGER << "measure " << measureNo << ": can't find <layer>";
+            LOGGER_WARNING << "measure " << measureNo << ": can't find <layer>";
             continue;
         }
         
-        ParseTabGrpList(xmlmeasure, xmllayer, GridNone, bar);
+        fings.clear();
+        IndexFingering(xmlmeasure, fings);
+        ParseTabGrpList(fings, xmllayer, GridNone, bar, piece);
         firstBar = false;
     }
     piece.SetTuning(options);
 }
 
-void ParserMei::ParseTabGrpList(xml_node& xmlmeasure, xml_node& xmlparent, Grid grid, Bar& bar)
+void ParserMei::ParseTabGrpList(const FingIndex& fings, xml_node& xmlparent, Grid grid, Bar& bar, Piece& piece)
 {
     for (xml_node xmlchild = xmlparent.first_child(); xmlchild; xmlchild = xmlchild.next_sibling())
     {
         const std::string childName{xmlchild.name()};
         if (childName == "tabGrp")
         {
-            ParseTabGrp(xmlmeasure, xmlchild, grid, bar);
+            ParseTabGrp(fings, xmlchild, grid, bar, piece);
             if (grid == GridStart)
                 grid = GridMid;
         }
         else if (childName == "beam")
         {
-            ParseTabGrpList(xmlmeasure, xmlchild, GridStart, bar);
+            ParseTabGrpList(fings, xmlchild, GridStart, bar, piece);
             if (!bar.m_chords.empty())
                 bar.m_chords.back().m_grid = GridEnd;
         }
         else if (childName == "choice" || childName == "corr")
         {
-            ParseTabGrpList(xmlmeasure, xmlchild, grid, bar);
+            ParseTabGrpList(fings, xmlchild, grid, bar, piece);
         }
         else if (childName == "sic")
         {
@@ -119,12 +137,12 @@ void ParserMei::ParseTabGrpList(xml_node& xmlmeasure, xml_node& xmlparent, Grid
         }
         else
         {
-            LOGGER << "ParseTabGrpList element " << childName << " ignored";
+            LOGGER_WARNING << "ParseTabGrpList element " << childName << " ignored";
         }
     }
 }
 
-void ParserMei::ParseTabGrp(xml_node& xmlmeasure, xml_node& xmltabGrp, Grid grid, Bar& bar)
+void ParserMei::ParseTabGrp(const FingIndex& fings, xml_node& xmltabGrp, Grid grid, Bar& bar, Piece& piece)
 {
     bar.m_chords.push_back(Chord());
     Chord& chord = bar.m_chords.back();
@@ -143,18 +161,20 @@ void ParserMei::ParseTabGrp(xml_node& xmlmeasure, xml_node& xmltabGrp, Grid grid
     chord.m_dotted = xmltabGrp.attribute("dots").as_int() == 1;
     chord.m_grid = grid;
     
-    ParseNoteList(xmlmeasure, xmltabGrp, chord);
+    std::vector<Note> notes;
+    ParseNoteList(fings, xmltabGrp, notes);
+    chord.m_shape = piece.m_chords.Intern(notes);
 }
 
-void ParserMei::ParseNoteList(xml_node& xmlmeasure, xml_node& xmlparent, Chord& chord)
+void ParserMei::ParseNoteList(const FingIndex& fings, xml_node& xmlparent, std::vector<Note>& notes)
 {
     for (xml_node xmlchild = xmlparent.first_child(); xmlchild; xmlchild = xmlchild.next_sibling())
     {
         const std::string childName{xmlchild.name()};
         if (childName == "note")
         {
-            chord.m_notes.push_back(Note());
-            Note& note = chord.m_notes.back();
+            notes.push_back(Note());
+            Note& note = notes.back();
             
             // string & fret
             note.m_string = xmlchild.attribute("tab.course").as_int();
@@ -162,11 +182,11 @@ void ParserMei::ParseNoteList(xml_node& xmlmeasure, xml_node& xmlparent, Chord&
             const std::string xmlid{xmlchild.attribute("xml:id").value()};
             
             if (!xmlid.empty())
-                ParseFingering(xmlmeasure, xmlid, note);
+                ParseFingering(fings, xmlid, note);
         }
         else if (childName == "choice" || childName == "corr")
         {
-            ParseNoteList(xmlmeasure, xmlchild, chord);
+            ParseNoteList(fings, xmlchild, notes);
         }
         else if (childName == "sic")
         {
@@ -178,54 +198,29 @@ void ParserMei::ParseNoteList(xml_node& xmlmeasure, xml_node& xmlparent, Chord&
         }
         else
         {
-            LOGGER << "ParseNoteList element " << childName << " ignored";
+            LOGGER_WARNING << "ParseNoteList element " << childName << " ignored";
         }
     }
 }
 
-void ParserMei::ParseFingering(xml_node& xmlmeasure, const std::string& xmlid, Note& note)
+void ParserMei::IndexFingering(xml_node& xmlparent, FingIndex& fings)
 {
-    // TODO fingering may apply to a range of ids
     // fingering <fing playingHand='right' playingFinger='1' startid='m3.n8'/>
     // Why is <fing> not a child of <note>?
-    for (xml_node xmlchild = xmlmeasure.first_child(); xmlchild; xmlchild = xmlchild.next_sibling())
+    for (xml_node xmlchild = xmlparent.first_child(); xmlchild; xmlchild = xmlchild.next_sibling())
     {
         const std::string childName{xmlchild.name()};
         if (childName == "fing")
         {
             // FIXME startid should contain #id not id but example da_crema-1546_10-no_6.mei doesn't have #
-            if (xmlchild.attribute("startid").value() == xmlid || xmlchild.attribute("startid").value() == ("#" + xmlid))
-            {
-                const std::string playingHand{xmlchild.attribute("playingHand").value()};
-                const std::string playingFinger{xmlchild.attribute("playingFinger").value()};
-    
-                if (!playingFinger.empty())
-                {
-                    for (int i = 1; Mei::fingering[i]; ++i)
-                    {
-                        if (playingFinger == Mei::fingering[i])
-                        {
-                            if (playingHand == "left")
-                            {
-                                note.m_leftFingering = static_cast<Fingering>(i);
-                            }
-                            else if (playingHand == "right")
-                            {
-                                note.m_rightFingering = static_cast<Fingering>(i);
-                            }
-                            else
-                            {
-                                LOGGER << "Unknown playingHand: " << playingHand;
-                            }
-                            break;
-                        }
-                    }
-                }
-            }
+            const std::string startid{xmlchild.attribute("startid").value()};
+            fings[startid].push_back(xmlchild);
+            if (!startid.empty() && startid[0] == '#')
+                fings[startid.substr(1)].push_back(xmlchild);
         }
         else if (childName == "choice" || childName == "corr")
         {
-            ParseFingering(xmlchild, xmlid, note);
+            IndexFingering(xmlchild, fings);
         }
         else if (childName == "sic")
         {
@@ -234,6 +229,43 @@ void ParserMei::ParseFingering(xml_node& xmlmeasure, const std::string& xmlid, N
     }
 }
 
+void ParserMei::ParseFingering(const FingIndex& fings, const std::string& xmlid, Note& note)
+{
+    // TODO fingering may apply to a range of ids
+    const auto it = fings.find(xmlid);
+    if (it == fings.end())
+        return;
+
+    for (const xml_node& xmlfing : it->second)
+    {
+        const std::string playingHand{xmlfing.attribute("playingHand").value()};
+        const std::string playingFinger{xmlfing.attribute("playingFinger").value()};
+
+        if (!playingFinger.empty())
+        {
+            for (int i = 1; Mei::fingering[i]; ++i)
+            {
+                if (playingFinger == Mei::fingering[i])
+                {
+                    if (playingHand == "left")
+                    {
+                        note.m_leftFingering = static_cast<Fingering>(i);
+                    }
+                    else if (playingHand == "right")
+                    {
+                        note.m_rightFingering = static_cast<Fingering>(i);
+                    }
+                    else
+                    {
+                        LOGGER_WARNING << "Unknown playingHand: " << playingHand;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+}
+
 TimeSig ParserMei::ParseTimeSignature(xml_node& xmlmensur)
 {
     TimeSig timeSig;
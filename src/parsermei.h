@@ -2,6 +2,9 @@
 #define _PARSERMEI_H_
 
 #include <pugixml.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "options.h"
 #include "piece.h"
 
@@ -45,11 +48,15 @@ public:
     void Parse(const Options& options, Piece& piece);
     
 private:
+    // <fing> elements of a measure by startid, in document order
+    using FingIndex = std::unordered_map<std::string, std::vector<pugi::xml_node>>;
+
     void Parse(const std::string& filename, pugi::xml_document& doc, pugi::xml_parse_result& result, const Options& options, Piece& piece);
-    void ParseTabGrpList(pugi::xml_node& xmlmeasure, pugi::xml_node& xmlparent, Grid grid, Bar& bar);
-    void ParseTabGrp(pugi::xml_node& xmlmeasure, pugi::xml_node& xmltabGrp, Grid grid, Bar& bar);
-    void ParseNoteList(pugi::xml_node& xmlmeasure, pugi::xml_node& xmlparent, Chord& chord);
-    void ParseFingering(pugi::xml_node& xmlmeasure, const std::string& xmlid, Note& note);
+    void ParseTabGrpList(const FingIndex& fings, pugi::xml_node& xmlparent, Grid grid, Bar& bar, Piece& piece);
+    void ParseTabGrp(const FingIndex& fings, pugi::xml_node& xmltabGrp, Grid grid, Bar& bar, Piece& piece);
+    void ParseNoteList(const FingIndex& fings, pugi::xml_node& xmlparent, std::vector<Note>& notes);
+    void IndexFingering(pugi::xml_node& xmlparent, FingIndex& fings);
+    void ParseFingering(const FingIndex& fings, const std::string& xmlid, Note& note);
     void ParseCourseTuning(pugi::xml_node& xmlcourseTuning, Piece& piece);
     TimeSig ParseTimeSignature(pugi::xml_node& xmlmensur);
 };
@@ -6,8 +6,11 @@
 #include <algorithm>
 #include <stdexcept>
 
+#include "cancel.h"
 #include "musicxml.h"
 #include "pitch.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
@@ -17,14 +20,24 @@ using namespace pugi;
 void ParserMusicXml::Parse(const std::string& filename, void* contents, size_t size, const Options& options, Piece& piece)
 {
     xml_document doc;
-    xml_parse_result result = doc.load_buffer_inplace(contents, size);
+    xml_parse_result result;
+    {
+        StatsScope statsScope("xml");
+        TRACE_SPAN("pugixml load");
+        result = doc.load_buffer_inplace(contents, size);
+    }
     Parse(filename, doc, result, options, piece);
 }
 
 void ParserMusicXml::Parse(const Options& options, Piece& piece)
 {
     xml_document doc;
-    xml_parse_result result = doc.load_file(options.m_srcFilename.c_str());
+    xml_parse_result result;
+    {
+        StatsScope statsScope("xml");
+        TRACE_SPAN("pugixml load");
+        result = doc.load_file(options.m_srcFilename.c_str());
+    }
     Parse(options.m_srcFilename, doc, result, options, piece);
 }
   
@@ -60,17 +73,23 @@ void ParserMusicXml::Parse(const std::string& filename, xml_document& doc, xml_p
     for (xml_node xmlmeasure = xmlpart.child("measure"); xmlmeasure; xmlmeasure = xmlmeasure.next_sibling("measure"))
     {
         piece.m_bars.push_back(Bar());
+        options.m_limits.CheckBars(piece.m_bars.size());
+        Cancel::Check();
 
         ParseTimeSignature(xmlmeasure, piece);
         ParseBarline(xmlmeasure, piece);
         
         Bar& bar = piece.m_bars.back();
         bool firstNote{true};
+        std::vector<Note> notes; // of the last chord, interned when the chord is complete
         for (xml_node xmlnote = xmlmeasure.child("note"); xmlnote; xmlnote = xmlnote.next_sibling("note"))
         {
             // do we need a new chord?
             if (!xmlnote.child("chord"))
             {
+                if (!bar.m_chords.empty())
+                    bar.m_chords.back().m_shape = piece.m_chords.Intern(notes);
+                notes.clear();
                 bar.m_chords.push_back(Chord());
                 firstNote = true;
             }
@@ -97,8 +116,8 @@ void ParserMusicXml::Parse(const std::string& filename, xml_document& doc, xml_p
             xml_node xmltechnical = xmlnote.child("notations").child("technical");
             if (xmltechnical)
             {
-                chord.m_notes.push_back(Note());
-                Note& note = chord.m_notes.back();
+                notes.push_back(Note());
+                Note& note = notes.back();
                 // string & fret
                 note.m_string = xmltechnical.child("string").text().as_int();
                 note.m_fret = xmltechnical.child("fret").text().as_int();
@@ -123,6 +142,9 @@ void ParserMusicXml::Parse(const std::string& filename, xml_document& doc, xml_p
                 }
             }
         }
+        
+        if (!bar.m_chords.empty())
+            bar.m_chords.back().m_shape = piece.m_chords.Intern(notes);
     }
     piece.SetTuning(options);
 }
@@ -5,6 +5,7 @@
 #include "piece.h"
 
 #include <string>
+#include <vector>
 
 namespace luteconv
 {
@@ -33,6 +34,15 @@ public:
      * @param[out] piece destination
      */
     void Parse(const Options& options, Piece& piece);
+    
+    /**
+     * Parse a memory image of a .mxl file
+     *
+     * @param[in] options
+     * @param[in] zipImage archive
+     * @param[out] piece destination
+     */
+    void Parse(const Options& options, const std::vector<char>& zipImage, Piece& piece);
 };
 
 } // namespace luteconv
@@ -4,17 +4,26 @@
 #include <fstream>
 #include <algorithm>
 #include <cctype>
-#include <chrono>
-#include <iomanip>
 #include <functional>
+#include <iterator>
 
+#include "cancel.h"
+#include "datetime.h"
+#include "lexer.h"
 #include "logger.h"
+#include "tabindex.h"
 
 namespace luteconv
 {
 
 void ParserTab::Parse(const Options& options, Piece& piece)
 {
+    if (options.m_tabIndexCache)
+    {
+        ParseCached(options, piece);
+        return;
+    }
+    
     std::fstream src;
     src.open(options.m_srcFilename.c_str(), std::fstream::in);
     if (!src.is_open())
@@ -24,44 +33,136 @@ void ParserTab::Parse(const Options& options, Piece& piece)
     
 void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
 {
-    int lineNo{0};
-    Bar bar;
-    bool barIsClear{true};
-    int section{0};
-    TabType tabType = options.m_srcTabType;
-    int topString{tabType == TabItalian ? 6 : 1};
+    const std::string text = LineLexer::Read(src);
+    Parse(text, options, piece);
+}
+
+void ParserTab::Parse(std::string_view text, const Options& options, Piece& piece)
+{
+    TabIndex index;
+    index.Build(text);
+    
+    TabSection section;
+    if (index.Find(SectionIndex(options), section))
+        ParseSection(text.substr(section.m_offset, section.m_size), section.m_lineNo, options, piece);
+    else
+        ParseSection("", 0, options, piece);
+}
+
+void ParserTab::ParseCached(const Options& options, Piece& piece)
+{
+    TabIndex::Key key;
+    if (!TabIndex::GetKey(options.m_srcFilename, key))
+        throw std::runtime_error("Error: Can't open " + options.m_srcFilename);
+    
+    const std::string sidecar = TabIndex::SidecarFilename(options.m_srcFilename);
+    const int target = SectionIndex(options);
+    TabIndex index;
+    TabSection section;
+    
+    if (index.Load(sidecar, key))
+    {
+        // read just the section
+        std::string text;
+        if (index.Find(target, section))
+        {
+            std::fstream src;
+            src.open(options.m_srcFilename.c_str(), std::fstream::in | std::fstream::binary);
+            if (!src.is_open())
+                throw std::runtime_error("Error: Can't open " + options.m_srcFilename);
+            
+            text.resize(section.m_size);
+            src.seekg(static_cast<std::streamoff>(section.m_offset));
+            src.read(&text[0], text.size());
+            text.resize(static_cast<size_t>(src.gcount()));
+        }
+        LOGGER_DEBUG << sidecar << " section " << target << " of " << index.Size();
+        ParseSection(text, section.m_lineNo, options, piece);
+        return;
+    }
+    
+    std::fstream src;
+    src.open(options.m_srcFilename.c_str(), std::fstream::in | std::fstream::binary);
+    if (!src.is_open())
+        throw std::runtime_error("Error: Can't open " + options.m_srcFilename);
+    const std::string text = LineLexer::Read(src);
+    
+    index.Build(text);
+    if (!index.Save(sidecar, key))
+    {
+        LOGGER_WARNING << "Can't write " << sidecar << ", ignored";
+    }
     
-    int target{0};
+    if (index.Find(target, section))
+        ParseSection(std::string_view(text).substr(section.m_offset, section.m_size), section.m_lineNo, options, piece);
+    else
+        ParseSection("", 0, options, piece);
+}
+
+int ParserTab::SectionIndex(const Options& options)
+{
     try
     {
-        target = std::stoi(options.m_index);
+        return std::stoi(options.m_index);
     }
     catch (...)
     {
-        LOGGER << "option --index=" << options.m_index << " is not a number, ignored";
+        LOGGER_WARNING << "option --index=" << options.m_index << " is not a number, ignored";
     }
+    return 0;
+}
+
+namespace
+{
+
+// directives that are matched on the whole line or on a prefix of the line
+enum Directive
+{
+    DirItalian7,        // italian 7 course tablature
+    DirItalian,         // italian or spanish tablature
+    DirSpanish,         // spanish tablature
+    DirTuning,          // -tuning
+    DirScribe,          // $scribe=
+    DirCopyright,       // -G
+};
+
+struct DirectiveEntry
+{
+    std::string_view m_text;
+    bool m_prefix;      // false => whole line
+    Directive m_directive;
+};
+
+const DirectiveEntry directives[] = {
+    {"-s",                  false,  DirItalian7},
+    {"-i",                  false,  DirItalian},
+    {"-O",                  false,  DirItalian},
+    {"$numstyle=italian",   false,  DirItalian},
+    {"-milan",              false,  DirSpanish},
+    {"-tuning ",            true,   DirTuning},
+    {"$scribe=",            true,   DirScribe},
+    {"-G",                  false,  DirCopyright},
+};
+
+} // namespace
+
+void ParserTab::ParseSection(std::string_view text, int lineNo, const Options& options, Piece& piece)
+{
+    LineLexer lexer{text, lineNo};
+    std::string_view line;
+    Bar bar;
+    bool barIsClear{true};
+    TabType tabType = options.m_srcTabType;
+    int topString{tabType == TabItalian ? 6 : 1};
     
-    while (!src.eof())
+    while (lexer.Next(line))
     {
-        std::string line;
-        getline(src, line);
-        ++lineNo;
+        const int lineNo = lexer.LineNo();
+        options.m_limits.CheckBars(piece.m_bars.size());
+        Cancel::Check();
         
         // remove trailing spaces
-        line.erase(std::find_if_not(line.rbegin(), line.rend(), [](int c){return isspace(c);}).base(), line.end());
-        
-        // assume sections are separated by end of page
-        if (line == "p")
-        {
-            ++section;
-            if (section > target)
-                break;
-            else
-                continue;
-        }
-        
-        if (section != target)
-            continue;
+        line = LineLexer::TrimRight(line);
         
         if (line.empty())
         {
@@ -78,76 +179,68 @@ void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
         if (line[0] == 'e') // end of document - tab will work but will complain without it.
             break;
         
-        if (line == "-s")
-        {
-            // italian 7 course tablature
-            if (tabType == TabUnknown || tabType == TabItalian)
-            {
-                tabType = TabItalian;
-                topString = 7;
-            }
-            continue;
-        }
-        
-        if (line == "-i" || line == "-O" || line == "$numstyle=italian")
-        {
-            // italian or spanish tablature: assume italian
-            if (tabType == TabUnknown)
-            {
-                tabType = TabItalian;
-                topString = 6;
-            }
-            continue;
-        }
-        
-        if (line == "-milan")
-        {
-            // spanish tablature
-            if (options.m_srcTabType == TabUnknown && (tabType == TabUnknown || tabType == TabItalian))
-            {
-                tabType = TabSpanish;
-                topString = 1;
-            }
-            continue;
-        }
-        
-        const std::string tuning{"-tuning "};
-        if (line.substr(0, tuning.size()) == tuning)
-        {
-            try
-            {
-                Pitch::SetTuningTab(line.substr(tuning.size()).c_str(), piece.m_tuning);
-            }
-            catch (...)
-            {
-                LOGGER << lineNo << ": \"" << line << "\" -tuning syntax error, ignored";
-                piece.m_tuning.clear();
-            }
-            continue;
-        }
+        const DirectiveEntry* directive = std::find_if(std::begin(directives), std::end(directives),
+                [line](const DirectiveEntry& entry)
+                {
+                    return entry.m_prefix ? line.substr(0, entry.m_text.size()) == entry.m_text : line == entry.m_text;
+                });
         
-        if (line.substr(0, 8) == "$scribe=")
+        if (directive != std::end(directives))
         {
-            piece.m_copyright = line.substr(8);
-            
-            // Prefix "Copyright <year>", unless already there
-            if (piece.m_copyright.find("Copyright") == std::string::npos)
+            const std::string_view value = line.substr(directive->m_text.size());
+            switch (directive->m_directive)
             {
-                std::time_t tt = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                struct std::tm * ptm = std::gmtime(&tt);
-                std::ostringstream ss;
-                ss << "Copyright " << std::put_time(ptm,"%Y") << " " << piece.m_copyright;
-                piece.m_copyright = ss.str();
+            case DirItalian7:
+                // italian 7 course tablature
+                if (tabType == TabUnknown || tabType == TabItalian)
+                {
+                    tabType = TabItalian;
+                    topString = 7;
+                }
+                break;
+            case DirItalian:
+                // italian or spanish tablature: assume italian
+                if (tabType == TabUnknown)
+                {
+                    tabType = TabItalian;
+                    topString = 6;
+                }
+                break;
+            case DirSpanish:
+                // spanish tablature
+                if (options.m_srcTabType == TabUnknown && (tabType == TabUnknown || tabType == TabItalian))
+                {
+                    tabType = TabSpanish;
+                    topString = 1;
+                }
+                break;
+            case DirTuning:
+                try
+                {
+                    Pitch::SetTuningTab(std::string(value).c_str(), piece.m_tuning);
+                }
+                catch (...)
+                {
+                    LOGGER_WARNING << lineNo << ": \"" << line << "\" -tuning syntax error, ignored";
+                    piece.m_tuning.clear();
+                }
+                break;
+            case DirScribe:
+                piece.m_copyright = value;
+                
+                // Prefix "Copyright <year>", unless already there
+                if (piece.m_copyright.find("Copyright") == std::string::npos)
+                {
+                    piece.m_copyright = "Copyright " + DateTime::Now("%Y") + " " + piece.m_copyright;
+                }
+                break;
+            case DirCopyright:
+                piece.m_copyrightEnabled = true;
+                break;
             }
             continue;
         }
         
-        if (line == "-G")
-        {
-            piece.m_copyrightEnabled = true;
-            continue;
-        }
-        
         switch (line[0])
         {
         case '{':   // { words }     - one of more lines of text (unjustified, not wrapped)
@@ -161,7 +254,7 @@ void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
                     credit.m_align = AlignCenter;
                     credit.m_left = CleanTabString(line.substr(5, line.size() - 6));
                 }
-                else if (slash != line.std::string::npos)
+                else if (slash != std::string_view::npos)
                 {
                     const std::string left = CleanTabString(line.substr(1, slash - 1));
                     const std::string right = CleanTabString(line.substr(slash + 1, line.size() - slash - 2));
@@ -209,7 +302,7 @@ void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
             if (line.size() == 1 || line[1] == '!')
                 ParseBarLine(line, bar, barIsClear, piece);
             else
-                ParseChord(line, lineNo, bar, barIsClear, topString);
+                ParseChord(line, lineNo, bar, barIsClear, topString, piece);
             break;
         case 'C':   // a big C
             // [[fallthrough]]
@@ -245,7 +338,7 @@ void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
         case 'L':   // longa
             // [[fallthrough]]
         case 'x':   // same number of flags as the last one
-            ParseChord(line, lineNo, bar, barIsClear, topString);
+            ParseChord(line, lineNo, bar, barIsClear, topString, piece);
             break;
         case 't':   // first note of a triplet, followed by the
                     // followed by the number of lines there would be
@@ -269,15 +362,15 @@ void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
                 const char flags[] = {"012345wWBL"};
                 const char * const flagsEnd = flags + sizeof(flags);
                 if (std::find(flags, flagsEnd, line[1]) != flagsEnd)
-                    ParseChord(line.substr(1), lineNo, bar, barIsClear, topString);
+                    ParseChord(line.substr(1), lineNo, bar, barIsClear, topString, piece);
                 else
-                    ParseChord("0" + line.substr(1), lineNo, bar, barIsClear, topString);
+                    ParseChord(line.substr(1), lineNo, bar, barIsClear, topString, piece, true);
                 bar.m_chords.back().m_fermata = true;
             }
             break;
         
         default:
-            LOGGER << lineNo << ": \"" << line << "\" ignored";
+            LOGGER_WARNING << lineNo << ": \"" << line << "\" ignored";
         }
     }
     
@@ -287,7 +380,7 @@ void ParserTab::Parse(std::istream& src, const Options& options, Piece& piece)
     piece.SetTuning(options);
 }
 
-std::string ParserTab::CleanTabString(const std::string& src)
+std::string ParserTab::CleanTabString(std::string_view src)
 {
     std::string dst;
     
@@ -305,7 +398,7 @@ std::string ParserTab::CleanTabString(const std::string& src)
     return dst;
 }
 
-void ParserTab::ParseBarLine(const std::string& line, Bar& bar, bool& barIsClear, Piece& piece)
+void ParserTab::ParseBarLine(std::string_view line, Bar& bar, bool& barIsClear, Piece& piece)
 {
     if (line.substr(0, 4) == ".bb." || line.substr(0, 5) == ".b.b.")
     {
@@ -397,21 +490,24 @@ void ParserTab::ParseBarLine(const std::string& line, Bar& bar, bool& barIsClear
     barIsClear = true;
 }
 
-void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool& barIsClear, int topString)
+void ParserTab::ParseChord(std::string_view line, int lineNo, Bar& bar, bool& barIsClear, int topString, Piece& piece,
+                           bool implicitFlag)
 {
+    if (!implicitFlag && line.empty())
+        return;
+
     bar.m_chords.emplace_back(); // new chord
     Chord & chord = bar.m_chords.back();
-    static Chord previousChord;
     
     // flags
     size_t idx{0};
-    if (line[idx] == 'x')
+    if (!implicitFlag && line[idx] == 'x')
     {
         // same number of flags as the last one
         // get flags from previous chord
-        chord.m_noteType = previousChord.m_noteType;
-        chord.m_dotted = previousChord.m_dotted;
-        if (previousChord.m_grid == GridNone)
+        chord.m_noteType = m_previousChord.m_noteType;
+        chord.m_dotted = m_previousChord.m_dotted;
+        if (m_previousChord.m_grid == GridNone)
             chord.m_noFlag = true;
         else
             chord.m_grid = GridMid;
@@ -419,7 +515,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
     }
     else
     {
-        if (line[idx] == '#')
+        if (!implicitFlag && line[idx] == '#')
         {
             // first note of a grid
             chord.m_grid = GridStart;
@@ -428,7 +524,12 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
                 return;
         }
         
-        if (line[idx] >= '0' && line[idx] <= '5')
+        if (implicitFlag)
+        {
+            // no flag given, as 0 flags
+            chord.m_noteType = NoteTypeQuarter;
+        }
+        else if (line[idx] >= '0' && line[idx] <= '5')
         {
             // a note with that many flags
             // TODO TAB thinks 0 flag is a crotchet.
@@ -489,7 +590,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
         }
      }
     
-    previousChord = chord; // only need to save the flags data, not the notes.
+    m_previousChord = chord; // only need to save the flags data, not the notes.
         
     if (idx < line.size() && line[idx] == '-')
     {
@@ -504,6 +605,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
     int string{topString - stringInc};
 
     barIsClear = false;
+    m_notes.clear();
     
     while (idx < line.size())
     {
@@ -516,8 +618,8 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
             continue;
         }
         
-        chord.m_notes.emplace_back(); // allocate new note
-        Note& note = chord.m_notes.back();
+        m_notes.emplace_back(); // allocate new note
+        Note& note = m_notes.back();
         
         // optional left ornament or left fingering followed by letter or diapason
         while (idx < line.size())
@@ -562,7 +664,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
 
             // /diapason
             int diapason{0};
-            if (string >= 7 && line[idx] == '/')
+            if (idx < line.size() && string >= 7 && line[idx] == '/')
             {
                 // diapason
                 do
@@ -604,7 +706,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
             }
             
             // fret number >= 10
-            if (idx < line.size() - 3 && line[idx] == 'N' && isdigit(line[idx + 1]) && isdigit(line[idx + 2]))
+            if (idx + 3 < line.size() && line[idx] == 'N' && isdigit(line[idx + 1]) && isdigit(line[idx + 2]))
             {
                 // fret
                 note.m_fret = (line[idx + 1] - '0') * 10 + (line[idx + 2] - '0');
@@ -614,7 +716,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
             }
             
             // fret number roman X
-            if (idx < line.size() - 2 && line[idx] == '!' && line[idx + 1] == 'x')
+            if (idx + 2 < line.size() && line[idx] == '!' && line[idx + 1] == 'x')
             {
                 // fret
                 note.m_fret = 10;
@@ -630,7 +732,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
                 break;
             }
             
-            if (idx < line.size() - 1 && (line[idx] == '!' || (line[idx] == '\\' && line[idx + 1] == '\\')))
+            if (idx + 1 < line.size() && (line[idx] == '!' || (line[idx] == '\\' && line[idx + 1] == '\\')))
             {
                 // escape operator or \\ one backslash in note position
                 idx += 2;
@@ -641,7 +743,10 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
                 ++idx; // ignore prefix operator and the prefix
                 
             // ignore other prefixes
-            LOGGER << lineNo << ": \"" << line << "\" ignoring prefix \"" << line[idx] << "\"";
+            if (idx < line.size())
+            {
+                LOGGER_WARNING << lineNo << ": \"" << line << "\" ignoring prefix \"" << line[idx] << "\"";
+            }
             ++idx;
             break;
         }
@@ -684,7 +789,7 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
                 }
                 else
                 {
-                    LOGGER<< lineNo << ": \"" << line << "\" ignoring postfix \"&" << line[idx] << "\"";
+                    LOGGER_WARNING << lineNo << ": \"" << line << "\" ignoring postfix \"&" << line[idx] << "\"";
                 }
             }
             else
@@ -697,11 +802,13 @@ void ParserTab::ParseChord(const std::string& line, int lineNo, Bar& bar, bool&
         
         // note not needed
         if (note.m_string == 0)
-            chord.m_notes.pop_back();
+            m_notes.pop_back();
     }
+    
+    chord.m_shape = piece.m_chords.Intern(m_notes);
 }
 
-void ParserTab::ParseTimeSignature(const std::string& line, Bar& bar)
+void ParserTab::ParseTimeSignature(std::string_view line, Bar& bar)
 {
     if (line == "C" || line == "SC")
     {
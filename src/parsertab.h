@@ -2,6 +2,7 @@
 #define _PARSERTAB_H_
 
 #include <iostream>
+#include <string_view>
 
 #include "piece.h"
 #include "options.h"
@@ -43,11 +44,27 @@ public:
      */
     void Parse(std::istream& srcFile, const Options& options, Piece& piece);
     
+    /**
+     * Parse .tab file image, only the section selected by --index
+     *
+     * @param[in] text .tab image
+     * @param[in] options
+     * @param[out] piece destination
+     */
+    void Parse(std::string_view text, const Options& options, Piece& piece);
+    
 private:
-    void ParseBarLine(const std::string& line, Bar& bar, bool& barIsClear, Piece& piece);
-    void ParseChord(const std::string& line, int lineNo, Bar& bar, bool& barIsClear, int topString);
-    void ParseTimeSignature(const std::string& line, Bar& bar);
-    std::string CleanTabString(const std::string& src);
+    void ParseCached(const Options& options, Piece& piece);
+    void ParseSection(std::string_view text, int lineNo, const Options& options, Piece& piece);
+    static int SectionIndex(const Options& options);
+    void ParseBarLine(std::string_view line, Bar& bar, bool& barIsClear, Piece& piece);
+    void ParseChord(std::string_view line, int lineNo, Bar& bar, bool& barIsClear, int topString, Piece& piece,
+                    bool implicitFlag = false);
+    void ParseTimeSignature(std::string_view line, Bar& bar);
+    std::string CleanTabString(std::string_view src);
+    
+    Chord m_previousChord; // flags of the previous chord, for 'x'
+    std::vector<Note> m_notes; // notes of the chord being parsed
     
 };
 
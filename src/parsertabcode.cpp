@@ -3,16 +3,81 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <array>
 #include <cctype>
-#include <chrono>
-#include <iomanip>
+#include <iterator>
+#include <utility>
 
+#include "cancel.h"
+#include "lexer.h"
 #include "logger.h"
+#include "parallel.h"
 #include "platform.h"
 
 namespace luteconv
 {
 
+namespace
+{
+
+struct BarLineEntry
+{
+    std::string_view m_tabword;
+    BarStyle m_barStyle;
+    Repeat m_repeat;
+};
+
+const BarLineEntry barLines[] = {
+    {"|",       BarStyleRegular,    RepNone},
+    {"||",      BarStyleLightLight, RepNone},
+    {"|:",      BarStyleRegular,    RepForward},
+    {"||:",     BarStyleLightLight, RepForward},
+    {":|",      BarStyleRegular,    RepBackward},
+    {":||",     BarStyleLightLight, RepBackward},
+    {":|:",     BarStyleRegular,    RepJanus},
+    {":||:",    BarStyleLightLight, RepJanus},
+    {"|=",      BarStyleRegular,    RepNone},
+    {"|0",      BarStyleRegular,    RepNone},
+    {"|=0",     BarStyleRegular,    RepNone},
+};
+
+struct TimeSigEntry
+{
+    std::string_view m_tabword;
+    TimeSymbol m_timeSymbol;
+    int m_beats;
+    int m_beatType;
+};
+
+const TimeSigEntry timeSigs[] = {
+    {"M(C)",    TimeSyCommon,   4,  4},
+    {"M(C/)",   TimeSyCut,      2,  2},
+};
+
+// rhythm sign => note type, -1 => not a rhythm sign
+// TabCode documentation has Q = 1 flag, therefore B = NoteTypeWhole, not NoteTypeBreve
+constexpr std::array<signed char, 256> MakeRhythmSigns()
+{
+    std::array<signed char, 256> table{};
+    for (size_t i = 0; i < table.size(); ++i)
+        table[i] = -1;
+    
+    const char signs[] = "BWHQESTYZ";
+    for (int i = 0; signs[i] != '\0'; ++i)
+        table[static_cast<unsigned char>(signs[i])] = static_cast<signed char>(NoteTypeWhole + i);
+    return table;
+}
+
+constexpr std::array<signed char, 256> rhythmSigns = MakeRhythmSigns();
+
+// rhythm of chords before the first rhythm sign of a chunk, until stitched
+const NoteType noteTypeUnknown = static_cast<NoteType>(NoteType256th + 1);
+
+// smaller files are parsed serially
+const size_t parallelThreshold = 64 * 1024;
+
+} // namespace
+
 void ParserTabCode::Parse(const Options& options, Piece& piece)
 {
     std::fstream src;
@@ -23,6 +88,12 @@ void ParserTabCode::Parse(const Options& options, Piece& piece)
 }
     
 void ParserTabCode::Parse(std::istream& src, const Options& options, Piece& piece)
+{
+    const std::string text = LineLexer::Read(src);
+    Parse(text, options, piece);
+}
+
+void ParserTabCode::Parse(std::string_view text, const Options& options, Piece& piece)
 {
     LOGGER << "Parse TabCode";
 
@@ -34,71 +105,198 @@ void ParserTabCode::Parse(std::istream& src, const Options& options, Piece& piec
     else
         piece.m_title = options.m_srcFilename.substr(slash + 1);
 
+    m_limits = options.m_limits;
+    const int threads = Parallel::Threads(options.m_jobs);
+    if (threads <= 1 || text.size() < parallelThreshold || !ParseChunked(text, threads, options.m_jobs, piece))
+    {
+        TabCodeLexer lexer{text};
+        Bar bar;
+        bool barIsClear{true};
+        ParseTokens(lexer, bar, barIsClear, piece);
+        
+        // deal with missing final bar line
+        ParseBarLine("|", lexer.LineNo(), bar, barIsClear, piece);
+    }
+
+    // TODO some tabcode files have a commented XML section <rules> which can contain
+    // tuning information.  Can't find any documentation for this.  Attempt to parse?
+    piece.SetTuning(options);
+}
+
+bool ParserTabCode::ParseChunked(std::string_view text, int chunkCount, int jobs, Piece& piece)
+{
+    // Speculatively split before bar lines, assuming that the split is not in a comment
+    std::vector<Chunk> chunks;
+    size_t begin{0};
     int lineNo{0};
+    for (int i = 1; i < chunkCount; ++i)
+    {
+        size_t split = std::max(begin + 1, text.size() / chunkCount * i);
+        for (split = text.find_first_of("|:", split); split != std::string_view::npos; split = text.find_first_of("|:", split + 1))
+        {
+            const char prev = text[split - 1];
+            if (prev == ' ' || prev == '\t' || prev == '\r' || prev == '\n')
+                break;
+        }
+        
+        if (split == std::string_view::npos)
+            break;
+        
+        chunks.emplace_back();
+        chunks.back().m_text = text.substr(begin, split - begin);
+        chunks.back().m_lineNo = lineNo;
+        lineNo += static_cast<int>(std::count(text.begin() + begin, text.begin() + split, '\n'));
+        begin = split;
+    }
+    chunks.emplace_back();
+    chunks.back().m_text = text.substr(begin);
+    chunks.back().m_lineNo = lineNo;
+    
+    LOGGER_DEBUG << "Parse TabCode in " << chunks.size() << " chunks";
+    
+    Parallel::For(chunks.size(), jobs, [this, &chunks](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+            {
+                ParserTabCode parser;
+                parser.m_limits = m_limits;
+                parser.ParseChunk(chunks[i], i == 0);
+            }
+        });
+    
+    // the speculation failed if a split was in a comment
+    for (size_t i = 0; i + 1 < chunks.size(); ++i)
+    {
+        if (chunks[i].m_openComment)
+        {
+            LOGGER_DEBUG << "Chunk " << i << " ends in a comment, parse serially";
+            return false;
+        }
+    }
+    
+    // stitch the chunks together, carrying the incomplete bar and rhythm from one chunk to the next
     Bar bar;
     bool barIsClear{true};
-    bool inComment{false};
-    
-    while (!src.eof())
+    Chord previousChord;
+    for (size_t i = 0; i < chunks.size(); ++i)
     {
-        std::string line;
-        getline(src, line);
-        ++lineNo;
-
-        // Tokenize: a token is delimited by whitespace or endl or a comment.
-        // Comments are tokenized as they can contain semantic information.
-        // (IMHO comments should only contain comments!)
-        size_t tokEnd = 0;
-        for (size_t tokBegin = 0; tokBegin < line.size(); tokBegin = tokEnd)
+        Chunk& chunk = chunks[i];
+        
+        if (i > 0)
+            ParseBarLine(chunk.m_barLine, chunk.m_barLineNo, bar, barIsClear, piece);
+        
+        if (!piece.m_bars.empty())
         {
-            // find start of token
-            while (tokBegin < line.size() && (line[tokBegin] == ' ' || line[tokBegin] == '\t'))
-                ++tokBegin;
-            
-            // find end of token
-            tokEnd = tokBegin + 1;
-            while (tokEnd < line.size() && line[tokEnd] != ' ' && line[tokEnd] != '\t' && line[tokEnd] != '{')
-                ++tokEnd;
-            
-            // deal with comments
-            if (inComment)
+            for (const auto & op : chunk.m_prevBarOps)
             {
-                if (line[tokEnd - 1] == '}')
+                if (op.m_eol)
+                    piece.m_bars.back().m_eol = true;
+                else
+                    MergeBarLine(op.m_barStyle, op.m_repeat, piece.m_bars.back());
+            }
+        }
+        
+        // chords before the first rhythm sign in the chunk take the rhythm of the previous chunk
+        bool patched{false};
+        const auto patch = [&previousChord, &patched](std::vector<Chord>& chords)
+            {
+                for (auto it = chords.begin(); it != chords.end() && !patched; ++it)
                 {
-                    inComment = false;
+                    if (it->m_noteType == noteTypeUnknown)
+                    {
+                        it->m_noteType = previousChord.m_noteType;
+                        it->m_dotted = previousChord.m_dotted;
+                    }
+                    else if (!it->m_noFlag && !it->m_fermata)
+                    {
+                        patched = true;
+                    }
                 }
-                continue;
-            }
+            };
+        for (auto it = chunk.m_piece.m_bars.begin(); it != chunk.m_piece.m_bars.end() && !patched; ++it)
+            patch(it->m_chords);
+        patch(chunk.m_bar.m_chords);
+        
+        if (chunk.m_previousChord.m_noteType != noteTypeUnknown)
+            previousChord = chunk.m_previousChord;
+        
+        // the chunk interned its chords in its own table
+        const std::vector<ShapeId> shapes = piece.m_chords.Merge(chunk.m_piece.m_chords);
+        for (auto & chunkBar : chunk.m_piece.m_bars)
+            chunkBar.Remap(shapes);
+        chunk.m_bar.Remap(shapes);
+        
+        piece.m_bars.insert(piece.m_bars.end(),
+                std::make_move_iterator(chunk.m_piece.m_bars.begin()), std::make_move_iterator(chunk.m_piece.m_bars.end()));
+        m_limits.CheckBars(piece.m_bars.size());
+        Cancel::Check();
+        bar = std::move(chunk.m_bar);
+        barIsClear = chunk.m_barIsClear;
+    }
+    
+    // deal with missing final bar line
+    ParseBarLine("|", chunks.back().m_lastLineNo, bar, barIsClear, piece);
+    return true;
+}
+
+void ParserTabCode::ParseChunk(Chunk& chunk, bool first)
+{
+    m_chunk = true;
+    TabCodeLexer lexer{chunk.m_text, chunk.m_lineNo};
     
-            if (line[tokBegin] == '{')
+    if (!first)
+    {
+        // the bar line ending the previous chunk's last bar is parsed when stitching
+        TabCodeLexer::TokenType type{TabCodeLexer::TokenTabword};
+        lexer.Next(chunk.m_barLine, type);
+        chunk.m_barLineNo = lexer.LineNo();
+        m_previousChord.m_noteType = noteTypeUnknown;
+    }
+    
+    ParseTokens(lexer, chunk.m_bar, chunk.m_barIsClear, chunk.m_piece);
+    
+    chunk.m_lastLineNo = lexer.LineNo();
+    chunk.m_previousChord = m_previousChord;
+    chunk.m_openComment = m_openComment;
+    chunk.m_prevBarOps = std::move(m_prevBarOps);
+}
+
+void ParserTabCode::ParseTokens(TabCodeLexer& lexer, Bar& bar, bool& barIsClear, Piece& piece)
+{
+    std::string_view token;
+    TabCodeLexer::TokenType type{TabCodeLexer::TokenTabword};
+    
+    // Comments are tokenized as they can contain semantic information.
+    // (IMHO comments should only contain comments!)
+    while (lexer.Next(token, type))
+    {
+        if (type == TabCodeLexer::TokenComment)
+        {
+            // end of system is encoded in a comment {^}!
+            if (token.substr(0, 3) == "{^}" && barIsClear)
             {
-                // end of system is encoded in a comment {^}!
-                if (line.substr(tokBegin, 3) == "{^}" && barIsClear && !piece.m_bars.empty())
+                if (!piece.m_bars.empty())
                 {
                     Bar& prev = piece.m_bars.back();
                     prev.m_eol = true;
                 }
-                
-                if (line[tokEnd - 1] != '}')
+                else if (m_chunk)
                 {
-                     inComment = true;
+                    m_prevBarOps.push_back({true, BarStyleRegular, RepNone});
                 }
-                continue;
             }
             
-            ParseCodeWord(line.substr(tokBegin, tokEnd - tokBegin), lineNo, bar, barIsClear, piece);
+            // an unterminated comment is always the last token
+            if (token.back() != '}')
+                m_openComment = true;
+            continue;
         }
+        
+        ParseCodeWord(token, lexer.LineNo(), bar, barIsClear, piece);
     }
-    
-    // deal with missing final bar line
-    ParseBarLine("|", lineNo, bar, barIsClear, piece);
-
-    // TODO some tabcode files have a commented XML section <rules> which can contain
-    // tuning information.  Can't find any documentation for this.  Attempt to parse?
-    piece.SetTuning(options);
 }
 
-void ParserTabCode::ParseCodeWord(const std::string& tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece)
+void ParserTabCode::ParseCodeWord(std::string_view tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece)
 {
     switch (tabword[0])
     {
@@ -111,122 +309,87 @@ void ParserTabCode::ParseCodeWord(const std::string& tabword, int lineNo, Bar& b
         ParseTimeSignature(tabword, lineNo, bar);
         break;
     default:
-        ParseChord(tabword, lineNo, bar, barIsClear);
+        ParseChord(tabword, lineNo, bar, barIsClear, piece);
         break;
     }
 }
 
-void ParserTabCode::ParseBarLine(const std::string& tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece)
+void ParserTabCode::ParseBarLine(std::string_view tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece)
 {
-    if (tabword == "|")
-    {
-        bar.m_barStyle = BarStyleRegular;
-    }
-    else if (tabword == "||")
-    {
-        bar.m_barStyle = BarStyleLightLight;
-    }
-    else if (tabword == "|:")
-    {
-        bar.m_barStyle = BarStyleRegular;
-        bar.m_repeat = RepForward;
-    }
-    else if (tabword == "||:")
-    {
-        bar.m_barStyle = BarStyleLightLight;
-        bar.m_repeat = RepForward;
-    }
-    else if (tabword == ":|")
-    {
-        bar.m_barStyle = BarStyleRegular;
-        bar.m_repeat = RepBackward;
-
-    }
-    else if (tabword == ":||")
+    const BarLineEntry* barLine = std::find_if(std::begin(barLines), std::end(barLines),
+            [tabword](const BarLineEntry& entry){ return entry.m_tabword == tabword; });
+    
+    if (barLine != std::end(barLines))
     {
-        bar.m_barStyle = BarStyleLightLight;
-        bar.m_repeat = RepBackward;
+        bar.m_barStyle = barLine->m_barStyle;
+        bar.m_repeat = barLine->m_repeat;
     }
-    else if (tabword == ":|:")
+    else
     {
         bar.m_barStyle = BarStyleRegular;
-        bar.m_repeat = RepJanus;
-    }
-    else if (tabword == ":||:")
-    {
-        bar.m_barStyle = BarStyleLightLight;
-        bar.m_repeat = RepJanus;
+        LOGGER_WARNING << lineNo << ": \"" << tabword << "\" unknown barline";
     }
-    else if (tabword == "|=")
+   
+    if (barIsClear && !piece.m_bars.empty())
     {
-        bar.m_barStyle = BarStyleRegular;
+        // two adjacent bar lines, combine
+        MergeBarLine(bar.m_barStyle, bar.m_repeat, piece.m_bars.back());
     }
-    else if (tabword == "|0")
+    else if (barIsClear && m_chunk)
     {
-        bar.m_barStyle = BarStyleRegular;
+        // the previous bar is in the previous chunk
+        m_prevBarOps.push_back({false, bar.m_barStyle, bar.m_repeat});
     }
-    else if (tabword == "|=0")
+    else if (!barIsClear)
     {
-        bar.m_barStyle = BarStyleRegular;
+        piece.m_bars.push_back(std::move(bar)); // bar is cleared below
+        m_limits.CheckBars(piece.m_bars.size());
+        Cancel::Check();
     }
-    else
+    
+    bar.Clear();
+    barIsClear = true;
+}
+
+void ParserTabCode::MergeBarLine(BarStyle barStyle, Repeat repeat, Bar& prev)
+{
+    if (prev.m_repeat == RepBackward && repeat == RepForward)
     {
-        bar.m_barStyle = BarStyleRegular;
-        LOGGER << lineNo << ": \"" << tabword << "\" unknown barline";
+        prev.m_repeat = RepJanus;
     }
-   
-    if (barIsClear && !piece.m_bars.empty())
+    
+    if (!prev.m_eol)
     {
-        // two adjacent bar lines, combine
-        Bar& prev = piece.m_bars.back();
-        if (prev.m_repeat == RepBackward && bar.m_repeat == RepForward)
+        if (prev.m_barStyle == BarStyleRegular && barStyle == BarStyleRegular)
         {
-            prev.m_repeat = RepJanus;
+            prev.m_barStyle = BarStyleLightLight;
         }
-        
-        if (!prev.m_eol)
+        else if (prev.m_barStyle == BarStyleRegular && barStyle == BarStyleHeavy)
         {
-            if (prev.m_barStyle == BarStyleRegular && bar.m_barStyle == BarStyleRegular)
-            {
-                prev.m_barStyle = BarStyleLightLight;
-            }
-            else if (prev.m_barStyle == BarStyleRegular && bar.m_barStyle == BarStyleHeavy)
-            {
-                prev.m_barStyle = BarStyleLightHeavy;
-            }
-            else if (prev.m_barStyle == BarStyleHeavy && bar.m_barStyle == BarStyleRegular)
-            {
-                prev.m_barStyle = BarStyleHeavyLight;
-            }
-            else if (prev.m_barStyle == BarStyleHeavy && bar.m_barStyle == BarStyleHeavy)
-            {
-                prev.m_barStyle = BarStyleHeavyHeavy;
-            }
+            prev.m_barStyle = BarStyleLightHeavy;
+        }
+        else if (prev.m_barStyle == BarStyleHeavy && barStyle == BarStyleRegular)
+        {
+            prev.m_barStyle = BarStyleHeavyLight;
+        }
+        else if (prev.m_barStyle == BarStyleHeavy && barStyle == BarStyleHeavy)
+        {
+            prev.m_barStyle = BarStyleHeavyHeavy;
         }
     }
-    else if (!barIsClear)
-    {
-        piece.m_bars.push_back(bar);
-    }
-    
-    bar.Clear();
-    barIsClear = true;
 }
 
-void ParserTabCode::ParseChord(const std::string& tabword, int lineNo, Bar& bar, bool& barIsClear)
+void ParserTabCode::ParseChord(std::string_view tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece)
 {
     bar.m_chords.emplace_back(); // new chord
     Chord & chord = bar.m_chords.back();
-    static Chord previousChord;
     
     // flags
     size_t idx{0};
-    const std::string flags{"BWHQESTYZ"};
-    const size_t flagPos = flags.find(tabword[idx]);
-    if (flagPos != std::string::npos)
+    const int rhythmSign = rhythmSigns[static_cast<unsigned char>(tabword[idx])];
+    if (rhythmSign >= 0)
     {
-        // TabCode documentation has Q = 1 flag, therefore B = NoteTypeWhole, not NoteTypeBreve
-        chord.m_noteType = static_cast<NoteType>(NoteTypeBreve + 1 + flagPos);
+        chord.m_noteType = static_cast<NoteType>(rhythmSign);
         ++idx;
         
         if (idx < tabword.size() && tabword[idx] == '.')
@@ -234,7 +397,7 @@ void ParserTabCode::ParseChord(const std::string& tabword, int lineNo, Bar& bar,
             chord.m_dotted = true;
             ++idx;
         }
-        previousChord = chord; // only need to save the flags data, not the notes.
+        m_previousChord = chord; // only need to save the flags data, not the notes.
     }
     else if (tabword[idx] == 'F')
     {
@@ -244,21 +407,22 @@ void ParserTabCode::ParseChord(const std::string& tabword, int lineNo, Bar& bar,
     }
     else
     {
-        chord.m_noteType = previousChord.m_noteType;
-        chord.m_dotted = previousChord.m_dotted;
+        chord.m_noteType = m_previousChord.m_noteType;
+        chord.m_dotted = m_previousChord.m_dotted;
         chord.m_noFlag = true;
     }
     
     // notes
     
     barIsClear = idx >= tabword.size();
+    m_notes.clear();
 
     while (idx < tabword.size())
     {
         if (tabword[idx] >= 'a' && tabword[idx] <= 'p')
         {
-            chord.m_notes.emplace_back(); // allocate new note
-            Note& note = chord.m_notes.back();
+            m_notes.emplace_back(); // allocate new note
+            Note& note = m_notes.back();
 
             note.m_fret = tabword[idx] - 'a' - (tabword[idx] <= 'i' ? 0 : 1); // fret i = j
             ++idx;
@@ -270,13 +434,13 @@ void ParserTabCode::ParseChord(const std::string& tabword, int lineNo, Bar& bar,
             }
             else
             {
-                LOGGER << lineNo << ": \"" << tabword << "\" missing string number";
+                LOGGER_WARNING << lineNo << ": \"" << tabword << "\" missing string number";
             }
         }
         else if (tabword[idx] == 'X')
         {
-            chord.m_notes.emplace_back(); // allocate new note
-            Note& note = chord.m_notes.back();
+            m_notes.emplace_back(); // allocate new note
+            Note& note = m_notes.back();
 
             // diapasons
             ++idx;
@@ -299,7 +463,7 @@ void ParserTabCode::ParseChord(const std::string& tabword, int lineNo, Bar& bar,
                 }
                 else
                 {
-                    LOGGER << lineNo << ": \"" << tabword << "\" missing fret letter";
+                    LOGGER_WARNING << lineNo << ": \"" << tabword << "\" missing fret letter";
                 }
 
                 // /diapason
@@ -321,49 +485,47 @@ void ParserTabCode::ParseChord(const std::string& tabword, int lineNo, Bar& bar,
         else if (tabword[idx] == '(')
         {
             // fingering, ornament or line
-            std::string extra;
-            extra = '(';
+            const size_t extraBegin = idx;
             ++idx;
             while (idx < tabword.size() && tabword[idx] != ')')
-            {
-                extra += tabword[idx];
                 ++idx;
-            }
-            extra += ')';
             
             if (idx < tabword.size())
                 ++idx; // eat )
+            const std::string_view extra = tabword.substr(extraBegin, idx - extraBegin);
             
-            if (!chord.m_notes.empty())
-                ParseExtra(tabword, lineNo, extra, chord.m_notes.back());
+            if (!m_notes.empty())
+                ParseExtra(tabword, lineNo, extra, m_notes.back());
         }
         else if (tabword[idx] == '.')
         {
-            if (!chord.m_notes.empty())
-                chord.m_notes.back().m_rightFingering = FingerFirst;
+            if (!m_notes.empty())
+                m_notes.back().m_rightFingering = FingerFirst;
             ++idx;
         }
         else if (tabword[idx] == ':')
         {
-            if (!chord.m_notes.empty())
-                chord.m_notes.back().m_rightFingering = FingerSecond;
+            if (!m_notes.empty())
+                m_notes.back().m_rightFingering = FingerSecond;
             ++idx;
         }
         else if (tabword[idx] == '!')
         {
-            if (!chord.m_notes.empty())
-                chord.m_notes.back().m_rightFingering = FingerThumb;
+            if (!m_notes.empty())
+                m_notes.back().m_rightFingering = FingerThumb;
             ++idx;
         }
         else
         {
-            LOGGER << lineNo << ": \"" << tabword << "\" unknown tabword";
+            LOGGER_WARNING << lineNo << ": \"" << tabword << "\" unknown tabword";
             ++idx;
         }
     }
+    
+    chord.m_shape = piece.m_chords.Intern(m_notes);
 }
 
-void ParserTabCode::ParseExtra(const std::string& tabword, int lineNo, const std::string& extra, Note& note)
+void ParserTabCode::ParseExtra(std::string_view tabword, int lineNo, std::string_view extra, Note& note)
 {
     // left hand fingering, at any position
     if (extra.substr(0, 5) == "(Fl1:")
@@ -405,7 +567,7 @@ void ParserTabCode::ParseExtra(const std::string& tabword, int lineNo, const std
     // 678
     else if ((extra.substr(0, 4) == "(Oe:"))
     {
-        if (extra[5] == '3' || extra[5] == '5' || extra[5] == '8')
+        if (extra.size() > 5 && (extra[5] == '3' || extra[5] == '5' || extra[5] == '8'))
             note.m_rightOrnament = OrnHash;
         else
             note.m_leftOrnament = OrnHash;
@@ -416,30 +578,27 @@ void ParserTabCode::ParseExtra(const std::string& tabword, int lineNo, const std
     // 678
     else if ((extra.substr(0, 4) == "(Of:"))
     {
-        if (extra[5] == '3' || extra[5] == '5' || extra[5] == '8')
+        if (extra.size() > 5 && (extra[5] == '3' || extra[5] == '5' || extra[5] == '8'))
             note.m_rightOrnament = OrnCross;
         else
             note.m_leftOrnament = OrnCross;
     }
     else
     {
-        LOGGER << lineNo << ": \"" << tabword << "\" extra \"" << extra << "\" ignored";
+        LOGGER_WARNING << lineNo << ": \"" << tabword << "\" extra \"" << extra << "\" ignored";
     }
 }
 
-void ParserTabCode::ParseTimeSignature(const std::string& tabword, int lineNo, Bar& bar)
+void ParserTabCode::ParseTimeSignature(std::string_view tabword, int lineNo, Bar& bar)
 {
-    if (tabword == "M(C)")
-    {
-        bar.m_timeSig.m_timeSymbol = TimeSyCommon;
-        bar.m_timeSig.m_beats = 4;
-        bar.m_timeSig.m_beatType = 4;
-    }
-    else if (tabword == "M(C/)")
+    const TimeSigEntry* timeSig = std::find_if(std::begin(timeSigs), std::end(timeSigs),
+            [tabword](const TimeSigEntry& entry){ return entry.m_tabword == tabword; });
+    
+    if (timeSig != std::end(timeSigs))
     {
-        bar.m_timeSig.m_timeSymbol = TimeSyCut;
-        bar.m_timeSig.m_beats = 2;
-        bar.m_timeSig.m_beatType = 2;
+        bar.m_timeSig.m_timeSymbol = timeSig->m_timeSymbol;
+        bar.m_timeSig.m_beats = timeSig->m_beats;
+        bar.m_timeSig.m_beatType = timeSig->m_beatType;
     }
     else if (tabword.size() == 4 && tabword[1] >= '1' && tabword[1] <= '9')
     {
@@ -457,7 +616,7 @@ void ParserTabCode::ParseTimeSignature(const std::string& tabword, int lineNo, B
     }
     else
     {
-        LOGGER << lineNo << ": \"" << tabword << "\" unknown time signature";
+        LOGGER_WARNING << lineNo << ": \"" << tabword << "\" unknown time signature";
     }
 }
 
@@ -2,7 +2,9 @@
 #define _PARSERTABCODE_H_
 
 #include <iostream>
+#include <string_view>
 
+#include "lexer.h"
 #include "piece.h"
 #include "options.h"
 
@@ -45,12 +47,67 @@ public:
      */
     void Parse(std::istream& srcFile, const Options& options, Piece& piece);
     
+    /**
+     * Parse .tc file image
+     *
+     * @param[in] text .tc image
+     * @param[in] options
+     * @param[out] piece destination
+     */
+    void Parse(std::string_view text, const Options& options, Piece& piece);
+    
+    /**
+     * Parse the bars of a .tc file image in chunks, split before bar lines,
+     * in parallel.
+     *
+     * @param[in] text .tc image
+     * @param[in] chunkCount maximum number of chunks
+     * @param[in] jobs number of threads, 0 => one per hardware thread
+     * @param[out] piece destination, unchanged if false returned
+     * @return true <=> success, false <=> a split was in a comment, parse serially instead
+     */
+    bool ParseChunked(std::string_view text, int chunkCount, int jobs, Piece& piece);
+    
 private:
-    void ParseCodeWord(const std::string& tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece);
-    void ParseExtra(const std::string& tabword, int lineNo, const std::string& extra, Note& note);
-    void ParseBarLine(const std::string& tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece);
-    void ParseChord(const std::string& tabword, int lineNo, Bar& bar, bool& barIsClear);
-    void ParseTimeSignature(const std::string& tabword, int lineNo, Bar& bar);
+    // A change to the bar before a chunk, applied when stitching
+    struct PrevBarOp
+    {
+        bool m_eol;             // true => {^} end of line, false => combine bar lines
+        BarStyle m_barStyle;
+        Repeat m_repeat;
+    };
+    
+    // A chunk of text parsed independently
+    struct Chunk
+    {
+        std::string_view m_text;        // starts with a bar line, except the first
+        int m_lineNo{0};                // lines before m_text
+        std::string_view m_barLine;     // the initial bar line
+        int m_barLineNo{0};
+        int m_lastLineNo{0};
+        Piece m_piece;                  // bars completed in the chunk
+        Bar m_bar;                      // incomplete bar at the end of the chunk
+        bool m_barIsClear{true};
+        Chord m_previousChord;
+        bool m_openComment{false};
+        std::vector<PrevBarOp> m_prevBarOps;
+    };
+    
+    void ParseChunk(Chunk& chunk, bool first);
+    void ParseTokens(TabCodeLexer& lexer, Bar& bar, bool& barIsClear, Piece& piece);
+    static void MergeBarLine(BarStyle barStyle, Repeat repeat, Bar& prev);
+    void ParseCodeWord(std::string_view tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece);
+    void ParseExtra(std::string_view tabword, int lineNo, std::string_view extra, Note& note);
+    void ParseBarLine(std::string_view tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece);
+    void ParseChord(std::string_view tabword, int lineNo, Bar& bar, bool& barIsClear, Piece& piece);
+    void ParseTimeSignature(std::string_view tabword, int lineNo, Bar& bar);
+    
+    Chord m_previousChord; // flags of the previous chord, for tabwords without flags
+    std::vector<Note> m_notes; // notes of the chord being parsed
+    bool m_chunk{false}; // parsing a chunk, record changes to the bar before the chunk
+    bool m_openComment{false}; // text ends in an unterminated comment
+    std::vector<PrevBarOp> m_prevBarOps;
+    InputLimits m_limits;
 };
 
 } // namespace luteconv
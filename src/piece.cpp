@@ -3,25 +3,19 @@
 #include <algorithm>
 #include <stdexcept>
 
+#include "stats.h"
+#include "trace.h"
+
 namespace luteconv
 {
 
 void Piece::SetTuning(const Options& options)
 {
-    // count the numCourses
-    int numCourses{0};
-    for (const auto & bar : m_bars)
-    {
-        for (const auto & chord : bar.m_chords)
-        {
-            for (const auto & note : chord.m_notes)
-            {
-                numCourses = std::max(numCourses, note.m_string);
-            }
-        }
-    }
-
-    numCourses = std::max(numCourses, 6);
+    StatsScope statsScope("tuning");
+    TRACE_SPAN("Piece::SetTuning");
+    
+    // the highest course used
+    const int numCourses = std::max(m_chords.Courses(), 6);
     
     // tuning in the command line takes precedence
     // then tuning from source file
@@ -48,6 +42,107 @@ void Piece::SetTuning(const Options& options)
     }
 }
 
+const std::vector<Note>& Piece::Notes(const Chord& chord) const
+{
+    return m_chords.Notes(chord.m_shape);
+}
+
+bool Chord::operator==(const Chord& rhs) const
+{
+    return m_noteType == rhs.m_noteType && m_grid == rhs.m_grid && m_dotted == rhs.m_dotted &&
+           m_fermata == rhs.m_fermata && m_noFlag == rhs.m_noFlag && m_shape == rhs.m_shape;
+}
+
+bool Chord::operator!=(const Chord& rhs) const
+{
+    return !(*this == rhs);
+}
+
+ChordTable::ChordTable()
+{
+    Intern({});
+}
+
+ChordTable::ChordTable(bool skim)
+{
+    Intern({});
+    m_skim = skim;
+}
+
+ShapeId ChordTable::Intern(const std::vector<Note>& notes)
+{
+    if (m_skim)
+    {
+        for (const auto & note : notes)
+            m_courses = std::max(m_courses, note.m_string);
+        return 0;
+    }
+    
+    MakeKey(notes);
+    const auto it = m_index.find(m_key);
+    if (it != m_index.end())
+        return it->second;
+    
+    for (const auto & note : notes)
+        m_courses = std::max(m_courses, note.m_string);
+    
+    const ShapeId shape = m_shapes.size();
+    m_shapes.push_back(notes);
+    m_index.emplace(m_key, shape);
+    return shape;
+}
+
+const std::vector<Note>& ChordTable::Notes(ShapeId shape) const
+{
+    return m_shapes[shape];
+}
+
+std::vector<ShapeId> ChordTable::Merge(const ChordTable& other)
+{
+    std::vector<ShapeId> shapes;
+    shapes.reserve(other.m_shapes.size());
+    for (const auto & notes : other.m_shapes)
+        shapes.push_back(Intern(notes));
+    
+    // a skimmed table has only its highest course
+    m_courses = std::max(m_courses, other.m_courses);
+    return shapes;
+}
+
+size_t ChordTable::Size() const
+{
+    return m_shapes.size();
+}
+
+int ChordTable::Courses() const
+{
+    return m_courses;
+}
+
+bool ChordTable::Skim() const
+{
+    return m_skim;
+}
+
+void ChordTable::MakeKey(const std::vector<Note>& notes)
+{
+    const auto appendInt = [this](int value)
+        {
+            m_key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+    
+    m_key.clear();
+    for (const auto & note : notes)
+    {
+        appendInt(note.m_string);
+        appendInt(note.m_fret);
+        m_key += static_cast<char>(note.m_leftFingering);
+        m_key += static_cast<char>(note.m_rightFingering);
+        m_key += static_cast<char>(note.m_leftOrnament);
+        m_key += static_cast<char>(note.m_rightOrnament);
+    }
+}
+
 void Bar::Clear()
 {
     m_timeSig = TimeSig();
@@ -59,4 +154,10 @@ void Bar::Clear()
     m_chords.clear();
 }
 
+void Bar::Remap(const std::vector<ShapeId>& shapes)
+{
+    for (auto & chord : m_chords)
+        chord.m_shape = shapes[chord.m_shape];
+}
+
 } // namespace luteconv
@@ -4,7 +4,9 @@
 #include "pitch.h"
 #include "options.h"
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace luteconv
@@ -112,11 +114,23 @@ public:
     Ornament m_rightOrnament{OrnNone};
 };
 
+// Identifies the notes of a chord in a ChordTable
+using ShapeId = uint32_t;
+
+// A chord event.  The notes are interned in the piece's ChordTable, every
+// event that plays the same notes shares them.
 class Chord
 {
 public:
     Chord() = default;
     ~Chord() = default;
+    Chord(const Chord&) = default;
+    Chord(Chord&&) = default;
+    Chord& operator=(const Chord&) = default;
+    Chord& operator=(Chord&&) = default;
+    
+    bool operator==(const Chord& rhs) const;
+    bool operator!=(const Chord& rhs) const;
 
     NoteType m_noteType{NoteTypeQuarter};
     Grid m_grid{GridNone};
@@ -124,7 +138,77 @@ public:
     bool m_fermata{false};
     bool m_noFlag{false};
     
-    std::vector<Note> m_notes;
+    ShapeId m_shape{0}; // notes, 0 => no notes
+};
+
+// Interned chord shapes, the notes played together by a chord
+class ChordTable
+{
+public:
+    /**
+     * Constructor, shape 0 has no notes
+     */
+    ChordTable();
+    
+    /**
+     * Constructor
+     * 
+     * @param[in] skim true => keep only the highest course, every shape is 0, see Converter::Info
+     */
+    explicit ChordTable(bool skim);
+    
+    /**
+     * Destructor
+     */
+    ~ChordTable() = default;
+    
+    /**
+     * Intern a chord shape
+     * 
+     * @param[in] notes
+     * @return id of the shape, equal notes have equal ids
+     */
+    ShapeId Intern(const std::vector<Note>& notes);
+    
+    /**
+     * Get the notes of a shape
+     * 
+     * @param[in] shape
+     * @return notes
+     */
+    const std::vector<Note>& Notes(ShapeId shape) const;
+    
+    /**
+     * Intern every shape of another table
+     * 
+     * @param[in] other
+     * @return ids in this table, indexed by the ids in other
+     */
+    std::vector<ShapeId> Merge(const ChordTable& other);
+    
+    /**
+     * @return number of distinct shapes
+     */
+    size_t Size() const;
+    
+    /**
+     * @return highest course of any shape interned, 0 => none
+     */
+    int Courses() const;
+    
+    /**
+     * @return true <=> skimming, see constructor
+     */
+    bool Skim() const;
+    
+private:
+    void MakeKey(const std::vector<Note>& notes);
+    
+    bool m_skim{false};
+    int m_courses{0};
+    std::vector<std::vector<Note>> m_shapes;
+    std::unordered_map<std::string, ShapeId> m_index; // key is the notes' bytes
+    std::string m_key; // reused to avoid an allocation per lookup
 };
 
 class TimeSig
@@ -140,8 +224,20 @@ class Bar
 public:
     Bar() = default;
     ~Bar() = default;
+    Bar(const Bar&) = default;
+    Bar(Bar&&) = default;
+    Bar& operator=(const Bar&) = default;
+    Bar& operator=(Bar&&) = default;
     
     void Clear();
+    
+    /**
+     * Map the chords' shapes to another table
+     * 
+     * @param[in] shapes new ids, indexed by the current ids, from ChordTable::Merge
+     */
+    void Remap(const std::vector<ShapeId>& shapes);
+    
     TimeSig m_timeSig;
     BarStyle m_barStyle{BarStyleRegular};
     Repeat m_repeat{RepNone};
@@ -176,6 +272,14 @@ public:
      */
     void SetTuning(const Options& options);
     
+    /**
+     * Get the notes of a chord
+     * 
+     * @param[in] chord
+     * @return notes
+     */
+    const std::vector<Note>& Notes(const Chord& chord) const;
+    
     std::string m_title;
     std::string m_composer;
     std::string m_copyright;
@@ -183,6 +287,7 @@ public:
     std::vector<Credit> m_credits;
     std::vector<Bar> m_bars;
     std::vector<Pitch> m_tuning;
+    ChordTable m_chords;
 };
 
 } // namespace luteconv
@@ -0,0 +1,124 @@
+#include "pieceinfo.h"
+
+#include <ostream>
+
+#include "json.h"
+#include "musicxml.h"
+
+namespace luteconv
+{
+
+namespace
+{
+
+std::string CreditText(const Credit& credit)
+{
+    if (credit.m_left.empty())
+        return credit.m_right;
+    if (credit.m_right.empty())
+        return credit.m_left;
+    return credit.m_left + " / " + credit.m_right;
+}
+
+std::string TuningText(const std::vector<Pitch>& tuning)
+{
+    std::string result;
+    for (const auto & pitch : tuning)
+        result += (result.empty() ? "" : " ") + pitch.ToString();
+    return result;
+}
+
+} // namespace
+
+void PieceInfo::Set(const Piece& piece)
+{
+    m_title = piece.m_title;
+    m_composer = piece.m_composer;
+    m_copyright = piece.m_copyrightEnabled ? piece.m_copyright : "";
+    m_credits = piece.m_credits;
+    m_tuning = piece.m_tuning;
+    m_bars = piece.m_bars.size();
+
+    m_timeSig = TimeSig();
+    for (const auto & bar : piece.m_bars)
+    {
+        if (bar.m_timeSig.m_timeSymbol != TimeSyNone || bar.m_timeSig.m_beats != 0)
+        {
+            m_timeSig = bar.m_timeSig;
+            break;
+        }
+    }
+}
+
+void PieceInfo::Print(std::ostream& s, const std::vector<PieceInfo>& infos, bool json)
+{
+    if (json)
+    {
+        s << "{\"files\": [";
+        for (size_t i = 0; i < infos.size(); ++i)
+        {
+            s << (i > 0 ? ", " : "");
+            infos[i].PrintJson(s);
+        }
+        s << "]}" << std::endl;
+        return;
+    }
+
+    for (const auto & info : infos)
+        info.PrintText(s);
+}
+
+void PieceInfo::PrintText(std::ostream& s) const
+{
+    s << m_srcFilename << std::endl;
+    if (!m_error.empty())
+    {
+        s << "    error " << m_error << std::endl;
+        return;
+    }
+
+    s << "    title " << m_title << std::endl
+      << "    composer " << m_composer << std::endl;
+    if (!m_copyright.empty())
+        s << "    copyright " << m_copyright << std::endl;
+    for (const auto & credit : m_credits)
+        s << "    credit " << CreditText(credit) << std::endl;
+    s << "    tuning " << TuningText(m_tuning) << std::endl;
+
+    s << "    time ";
+    if (m_timeSig.m_timeSymbol == TimeSyNone && m_timeSig.m_beats == 0)
+        s << "none";
+    else
+        s << m_timeSig.m_beats << "/" << m_timeSig.m_beatType << " " << MusicXml::timeSymbol[m_timeSig.m_timeSymbol];
+    s << std::endl
+      << "    bars " << m_bars << std::endl;
+}
+
+void PieceInfo::PrintJson(std::ostream& s) const
+{
+    s << "{\"source\": " << Json::String(m_srcFilename);
+    if (!m_error.empty())
+    {
+        s << ", \"error\": " << Json::String(m_error) << "}";
+        return;
+    }
+
+    s << ", \"title\": " << Json::String(m_title) << ", \"composer\": " << Json::String(m_composer)
+      << ", \"copyright\": " << Json::String(m_copyright) << ", \"credits\": [";
+    for (size_t i = 0; i < m_credits.size(); ++i)
+        s << (i > 0 ? ", " : "") << Json::String(CreditText(m_credits[i]));
+    s << "], \"tuning\": " << Json::String(TuningText(m_tuning)) << ", \"time\": ";
+
+    if (m_timeSig.m_timeSymbol == TimeSyNone && m_timeSig.m_beats == 0)
+    {
+        s << "null";
+    }
+    else
+    {
+        s << "{\"symbol\": " << Json::String(MusicXml::timeSymbol[m_timeSig.m_timeSymbol])
+          << ", \"beats\": " << m_timeSig.m_beats << ", \"beat_type\": " << m_timeSig.m_beatType << "}";
+    }
+    s << ", \"bars\": " << m_bars << "}";
+}
+
+} // namespace luteconv
@@ -0,0 +1,64 @@
+#ifndef _PIECEINFO_H_
+#define _PIECEINFO_H_
+
+#include "piece.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace luteconv
+{
+
+/**
+ * The metadata of a piece for cataloguing, see option --info
+ */
+class PieceInfo
+{
+public:
+
+    /**
+     * Constructor
+     */
+    PieceInfo() = default;
+
+    /**
+     * Destructor
+     */
+    ~PieceInfo() = default;
+
+    /**
+     * Set from a parsed, or skimmed, piece
+     *
+     * @param[in] piece
+     */
+    void Set(const Piece& piece);
+
+    /**
+     * Print the metadata of one or more files
+     *
+     * @param[in] s destination
+     * @param[in] infos
+     * @param[in] json true => JSON, false => text
+     */
+    static void Print(std::ostream& s, const std::vector<PieceInfo>& infos, bool json);
+
+    std::string m_srcFilename;
+    std::string m_error;            // "" => read
+    std::string m_title;
+    std::string m_composer;
+    std::string m_copyright;        // "" => none
+    std::vector<Credit> m_credits;
+    std::vector<Pitch> m_tuning;
+    TimeSig m_timeSig;              // of the first bar that has one
+    uint64_t m_bars{0};
+
+private:
+    void PrintText(std::ostream& s) const;
+    void PrintJson(std::ostream& s) const;
+};
+
+} // namespace luteconv
+
+#endif // _PIECEINFO_H_
@@ -0,0 +1,164 @@
+#include "piecesynth.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace luteconv
+{
+
+namespace
+{
+
+// Time signatures to choose from
+const TimeSig timeSigs[] = {
+    {TimeSyCommon, 4, 4},
+    {TimeSyCut,    2, 2},
+    {TimeSyNormal, 3, 4},
+    {TimeSyNormal, 3, 2},
+    {TimeSyNormal, 6, 8},
+    {TimeSyNormal, 2, 4},
+};
+
+const int numTimeSigs = sizeof(timeSigs) / sizeof(timeSigs[0]);
+
+// Duration in 256ths of a whole note
+int Duration(NoteType noteType)
+{
+    return 1024 >> noteType;
+}
+
+} // namespace
+
+PieceSynth::Random::Random(uint64_t seed)
+: m_state{seed}
+{
+}
+
+uint64_t PieceSynth::Random::Next()
+{
+    uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+int PieceSynth::Random::Below(int n)
+{
+    return static_cast<int>(Next() % static_cast<uint64_t>(n));
+}
+
+bool PieceSynth::Random::Chance(double p)
+{
+    // 53 bits is the precision of a double
+    return static_cast<double>(Next() >> 11) < p * static_cast<double>(1ULL << 53);
+}
+
+void PieceSynth::Build(Piece& piece) const
+{
+    if (m_bars < 1)
+        throw std::runtime_error(std::string("Error: number of bars must be positive"));
+
+    if (m_chordsPerBar < 1)
+        throw std::runtime_error(std::string("Error: number of chords per bar must be positive"));
+
+    if (m_courses < 6 || m_courses > 14)
+        throw std::runtime_error(std::string("Error: number of courses must be 6 to 14"));
+
+    Random random(m_seed);
+
+    piece.m_title = "Synthetic piece " + std::to_string(m_seed);
+    piece.m_composer = "luteconv";
+    piece.m_bars.resize(m_bars);
+
+    std::vector<Note> notes;
+    TimeSig timeSig = timeSigs[0];
+    for (int i = 0; i < m_bars; ++i)
+    {
+        Bar& bar = piece.m_bars[i];
+        if (i == 0 || random.Chance(m_timeChanges))
+        {
+            timeSig = timeSigs[random.Below(numTimeSigs)];
+            bar.m_timeSig = timeSig;
+        }
+
+        BuildBar(random, timeSig, notes, piece, bar);
+
+        if (i > 0 && i + 1 < m_bars && random.Chance(m_repeats))
+            bar.m_repeat = static_cast<Repeat>(RepForward + random.Below(3));
+    }
+
+    piece.m_bars.back().m_barStyle = BarStyleLightHeavy;
+    piece.m_bars.back().m_fermata = true;
+
+    Pitch::SetTuning(m_courses, piece.m_tuning);
+    piece.m_tuning.resize(m_courses);
+}
+
+void PieceSynth::BuildBar(Random& random, const TimeSig& timeSig, std::vector<Note>& notes, Piece& piece, Bar& bar) const
+{
+    // Equal chords filling the bar, or as near as note values allow
+    const int duration = timeSig.m_beats * Duration(NoteTypeWhole) / timeSig.m_beatType / m_chordsPerBar;
+    NoteType noteType{NoteType256th};
+    bool dotted{false};
+    for (int t = NoteTypeLong; t <= NoteType256th; ++t)
+    {
+        const NoteType candidate = static_cast<NoteType>(t);
+        if (Duration(candidate) * 3 / 2 == duration && Duration(candidate) > 1)
+        {
+            noteType = candidate;
+            dotted = true;
+            break;
+        }
+        if (Duration(candidate) <= duration)
+        {
+            noteType = candidate;
+            break;
+        }
+    }
+
+    bar.m_chords.resize(m_chordsPerBar);
+    for (auto & chord : bar.m_chords)
+    {
+        chord.m_noteType = noteType;
+        chord.m_dotted = dotted;
+
+        // 1 to 4 notes on different courses, in course order, sometimes a diapason
+        const int size = 1 + random.Below(4);
+        notes.clear();
+        int course = 1 + random.Below(3);
+        for (int i = 0; i < size && course <= 6; ++i)
+        {
+            notes.emplace_back();
+            BuildNote(random, course, notes.back());
+            course += 1 + random.Below(3);
+        }
+        
+        if (m_courses > 6 && random.Chance(0.25))
+        {
+            notes.emplace_back();
+            BuildNote(random, 7 + random.Below(m_courses - 6), notes.back());
+        }
+        chord.m_shape = piece.m_chords.Intern(notes);
+    }
+}
+
+void PieceSynth::BuildNote(Random& random, int course, Note& note) const
+{
+    // diapasons are played open
+    note.m_string = course;
+    note.m_fret = (course <= 6) ? random.Below(10) : 0;
+
+    if (random.Chance(m_fingering))
+    {
+        note.m_rightFingering = static_cast<Fingering>(FingerFirst + random.Below(3));
+        if (note.m_fret > 0)
+            note.m_leftFingering = static_cast<Fingering>(FingerFirst + random.Below(4));
+    }
+
+    if (random.Chance(m_ornaments))
+    {
+        note.m_leftOrnament = static_cast<Ornament>(OrnHash + random.Below(OrnBrackets));
+    }
+}
+
+} // namespace luteconv
@@ -0,0 +1,66 @@
+#ifndef _PIECESYNTH_H_
+#define _PIECESYNTH_H_
+
+#include "piece.h"
+
+#include <cstdint>
+
+namespace luteconv
+{
+
+/**
+ * Build random, but valid, pieces of any size for scaling tests.
+ *
+ * The same settings and seed always build the same piece, on any platform.
+ */
+class PieceSynth
+{
+public:
+
+    /**
+     * Constructor
+     */
+    PieceSynth() = default;
+
+    /**
+     * Destructor
+     */
+    ~PieceSynth() = default;
+
+    /**
+     * Build a piece
+     *
+     * @param[out] piece destination
+     */
+    void Build(Piece& piece) const;
+
+    uint64_t m_seed{1};
+    int m_bars{100};
+    int m_chordsPerBar{4};
+    int m_courses{6};           // 6...14
+    double m_fingering{0.1};    // probability a note is fingered
+    double m_ornaments{0.05};   // probability a note has an ornament
+    double m_repeats{0.02};     // probability a bar has a repeat
+    double m_timeChanges{0.02}; // probability a bar changes time signature
+
+private:
+    // splitmix64, the standard library's distributions differ between implementations
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed);
+        uint64_t Next();
+        int Below(int n);
+        bool Chance(double p);
+
+    private:
+        uint64_t m_state;
+    };
+
+    void BuildBar(Random& random, const TimeSig& timeSig, std::vector<Note>& notes, Piece& piece, Bar& bar) const;
+    void BuildNote(Random& random, int course, Note& note) const;
+};
+
+} // namespace luteconv
+
+#endif // _PIECESYNTH_H_
@@ -98,7 +98,7 @@ void Pitch::SetTuning(int courses, std::vector<Pitch>& tuning)
     }
     else
     {
-        SetTuning("F4 D4 A3 F3 D3 A2 G2 F2 E2 D2 C2 B1 A1", tuning);
+        SetTuning("F4 D4 A3 F3 D3 A2 G2 F2 E2 D2 C2 B1 A1 G1", tuning);
     }
 }
 
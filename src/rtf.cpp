@@ -0,0 +1,348 @@
+#include "rtf.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace luteconv
+{
+
+std::string Rtf::ExtractText(const char* rtf, size_t size)
+{
+    std::string text;
+    text.reserve(size);
+
+    // skip leading white space to find the RTF signature
+    size_t idx{0};
+    while (idx < size && isspace(static_cast<unsigned char>(rtf[idx])))
+        ++idx;
+
+    const char signature[] = "{\\rtf";
+    const size_t signatureSize = sizeof(signature) - 1;
+    if (size - idx < signatureSize || std::strncmp(rtf + idx, signature, signatureSize) != 0)
+    {
+        // not RTF, just remove line breaks
+        std::remove_copy_if(rtf, rtf + size, std::back_inserter(text), [](char c){return c == '\r' || c == '\n';});
+        return text;
+    }
+
+    // group state is saved on { and restored on }
+    struct Group
+    {
+        bool m_skip{false};     // in a destination group, e.g. \fonttbl
+        int m_ucSkip{1};        // number of fallback characters after \uN
+    };
+    std::vector<Group> groups;
+    Group group;
+
+    bool groupStart{false};     // next token is the first in a group
+    int fallback{0};            // fallback characters still to skip after \uN
+    unsigned long highSurrogate{0};
+
+    while (idx < size)
+    {
+        const char c = rtf[idx];
+
+        if (c == '{')
+        {
+            groups.push_back(group);
+            groupStart = true;
+            ++idx;
+            continue;
+        }
+
+        if (c == '}')
+        {
+            if (groups.empty())
+                break; // end of document
+
+            group = groups.back();
+            groups.pop_back();
+            groupStart = false;
+            fallback = 0;
+            ++idx;
+            continue;
+        }
+
+        if (c == '\r' || c == '\n')
+        {
+            // line breaks are not text
+            ++idx;
+            continue;
+        }
+
+        if (c != '\\')
+        {
+            // plain text
+            groupStart = false;
+            if (!group.m_skip)
+            {
+                if (fallback > 0)
+                    --fallback;
+                else
+                    text += c;
+            }
+            ++idx;
+            continue;
+        }
+
+        // control word or control symbol
+        ++idx;
+        if (idx >= size)
+            break;
+
+        if (isalpha(static_cast<unsigned char>(rtf[idx])))
+        {
+            // control word: \letters[-][digits][space]
+            const size_t wordBegin = idx;
+            while (idx < size && isalpha(static_cast<unsigned char>(rtf[idx])))
+                ++idx;
+            const std::string word{rtf + wordBegin, rtf + idx};
+
+            bool hasParam{false};
+            bool negative{false};
+            long param{0};
+            if (idx < size && rtf[idx] == '-')
+            {
+                negative = true;
+                ++idx;
+            }
+            while (idx < size && isdigit(static_cast<unsigned char>(rtf[idx])))
+            {
+                hasParam = true;
+                param = param * 10 + (rtf[idx] - '0');
+                ++idx;
+            }
+            if (negative)
+                param = -param;
+
+            // a single space delimits the control word
+            if (idx < size && rtf[idx] == ' ')
+                ++idx;
+
+            if (groupStart && IsDestination(word))
+                group.m_skip = true;
+            groupStart = false;
+
+            if (group.m_skip)
+                continue;
+
+            if (word == "uc")
+            {
+                group.m_ucSkip = hasParam ? static_cast<int>(std::max(param, 0L)) : 1;
+                continue;
+            }
+
+            // a control word counts as a single fallback character
+            if (fallback > 0)
+            {
+                --fallback;
+                continue;
+            }
+
+            if (word == "u" && hasParam)
+            {
+                // signed 16 bit
+                unsigned long codePoint = static_cast<unsigned long>(param < 0 ? param + 0x10000 : param);
+                if (codePoint >= 0xd800 && codePoint <= 0xdbff)
+                {
+                    highSurrogate = codePoint;
+                }
+                else
+                {
+                    if (codePoint >= 0xdc00 && codePoint <= 0xdfff && highSurrogate != 0)
+                        codePoint = 0x10000 + ((highSurrogate - 0xd800) << 10) + (codePoint - 0xdc00);
+                    highSurrogate = 0;
+                    AppendUtf8(codePoint, text);
+                }
+                fallback = group.m_ucSkip;
+            }
+            else if (word == "par" || word == "line" || word == "tab" || word == "sect" || word == "page")
+            {
+                text += ' ';
+            }
+            else if (word == "lquote")
+            {
+                AppendUtf8(0x2018, text);
+            }
+            else if (word == "rquote")
+            {
+                AppendUtf8(0x2019, text);
+            }
+            else if (word == "ldblquote")
+            {
+                AppendUtf8(0x201c, text);
+            }
+            else if (word == "rdblquote")
+            {
+                AppendUtf8(0x201d, text);
+            }
+            else if (word == "endash")
+            {
+                AppendUtf8(0x2013, text);
+            }
+            else if (word == "emdash")
+            {
+                AppendUtf8(0x2014, text);
+            }
+            else if (word == "bullet")
+            {
+                AppendUtf8(0x2022, text);
+            }
+            // other control words are formatting, ignore
+            continue;
+        }
+
+        // control symbol
+        const char symbol = rtf[idx];
+        ++idx;
+
+        if (symbol == '*')
+        {
+            // \* ignorable destination
+            if (groupStart)
+                group.m_skip = true;
+            continue;
+        }
+        groupStart = false;
+
+        if (symbol == '\'')
+        {
+            // \'xx hex escape
+            const int high = idx < size ? HexDigit(rtf[idx]) : -1;
+            const int low = idx + 1 < size ? HexDigit(rtf[idx + 1]) : -1;
+            if (high < 0 || low < 0)
+            {
+                // malformed, discard
+                if (high >= 0)
+                    ++idx;
+                continue;
+            }
+
+            const int value = high * 16 + low;
+            idx += 2;
+
+            if (group.m_skip)
+                continue;
+
+            if (fallback > 0)
+                --fallback;
+            else
+                AppendUtf8(Cp1252(static_cast<unsigned char>(value)), text);
+            continue;
+        }
+
+        if (group.m_skip)
+            continue;
+
+        if (fallback > 0)
+        {
+            --fallback;
+            continue;
+        }
+
+        switch (symbol)
+        {
+        case '\\':
+            // [[fallthrough]]
+        case '{':
+            // [[fallthrough]]
+        case '}':
+            text += symbol;
+            break;
+        case '~':   // non-breaking space
+            text += ' ';
+            break;
+        case '_':   // non-breaking hyphen
+            text += '-';
+            break;
+        case '\r':
+            // [[fallthrough]]
+        case '\n':  // same as \par
+            text += ' ';
+            break;
+        default:    // \- optional hyphen, etc.
+            break;
+        }
+    }
+
+    // remove leading and trailing spaces
+    const auto isSpace = [](int c){return c == ' ' || c == '\t';};
+    text.erase(std::find_if_not(text.rbegin(), text.rend(), isSpace).base(), text.end());
+    text.erase(text.begin(), std::find_if_not(text.begin(), text.end(), isSpace));
+    return text;
+}
+
+bool Rtf::IsDestination(const std::string& word)
+{
+    // groups whose text is not part of the document
+    static const char* const destinations[] = {
+        "author", "colortbl", "comment", "datastore", "doccomm", "fldinst", "filetbl",
+        "footer", "footerf", "footerl", "footerr", "footnote", "generator", "header",
+        "headerf", "headerl", "headerr", "info", "keywords", "latentstyles", "listoverridetable",
+        "listtable", "object", "operator", "pict", "revtbl", "rsidtbl", "stylesheet",
+        "subject", "themedata", "title", "xmlnstbl", "fonttbl", nullptr};
+
+    for (const char* const* dest = destinations; *dest; ++dest)
+    {
+        if (word == *dest)
+            return true;
+    }
+    return false;
+}
+
+void Rtf::AppendUtf8(unsigned long codePoint, std::string& dst)
+{
+    if (codePoint < 0x80)
+    {
+        dst += static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        dst += static_cast<char>(0xc0 | (codePoint >> 6));
+        dst += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+    else if (codePoint < 0x10000)
+    {
+        dst += static_cast<char>(0xe0 | (codePoint >> 12));
+        dst += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        dst += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+    else if (codePoint < 0x110000)
+    {
+        dst += static_cast<char>(0xf0 | (codePoint >> 18));
+        dst += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+        dst += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        dst += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+unsigned long Rtf::Cp1252(unsigned char c)
+{
+    // Windows code page 1252 differs from ISO-8859-1 only in 0x80 ... 0x9f
+    static const unsigned short cp1252[] = {
+        0x20ac, 0x0081, 0x201a, 0x0192, 0x201e, 0x2026, 0x2020, 0x2021,
+        0x02c6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008d, 0x017d, 0x008f,
+        0x0090, 0x2018, 0x2019, 0x201c, 0x201d, 0x2022, 0x2013, 0x2014,
+        0x02dc, 0x2122, 0x0161, 0x203a, 0x0153, 0x009d, 0x017e, 0x0178};
+
+    if (c >= 0x80 && c <= 0x9f)
+        return cp1252[c - 0x80];
+
+    return c;
+}
+
+int Rtf::HexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace luteconv
@@ -0,0 +1,50 @@
+#ifndef _RTF_H_
+#define _RTF_H_
+
+#include <cstddef>
+#include <string>
+
+namespace luteconv
+{
+
+/**
+ * Extract the visible text from Rich Text Format
+ *
+ * A single pass tokenizer, not a full RTF reader.  Control words are
+ * skipped, as are destination groups such as the font table.  Hex escapes
+ * \'xx (code page 1252) and Unicode escapes \uN are decoded to UTF-8.
+ */
+class Rtf
+{
+public:
+
+    /**
+     * Constructor
+     */
+    Rtf() = default;
+
+    /**
+     * Destructor
+     */
+    ~Rtf() = default;
+
+    /**
+     * Extract text from RTF.  Text that is not RTF is returned
+     * with any line breaks removed.
+     *
+     * @param[in] rtf
+     * @param[in] size
+     * @return UTF-8 text, leading and trailing spaces removed
+     */
+    static std::string ExtractText(const char* rtf, size_t size);
+
+private:
+    static bool IsDestination(const std::string& word);
+    static void AppendUtf8(unsigned long codePoint, std::string& dst);
+    static unsigned long Cp1252(unsigned char c);
+    static int HexDigit(char c);
+};
+
+} // namespace luteconv
+
+#endif // _RTF_H_
@@ -0,0 +1,194 @@
+#include "scheduler.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+
+#include "converter.h"
+#include "logger.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace luteconv
+{
+
+Scheduler::Scheduler(int jobs, double timeout)
+: m_threads{Parallel::Threads(jobs)}, m_timeout{timeout}
+{
+}
+
+void Scheduler::Add(const Options& options)
+{
+    m_jobs.push_back(Job{options});
+    m_jobs.back().m_cost = Cost(options);
+    m_jobs.back().m_cancel = std::make_unique<Cancel>();
+}
+
+void Scheduler::Run(bool stats)
+{
+    TRACE_SPAN("Scheduler::Run");
+    if (m_jobs.empty())
+        return;
+
+    // deal the jobs, largest first, so each queue is in decreasing cost
+    std::vector<size_t> order(m_jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs)
+        {
+            return m_jobs[lhs].m_cost > m_jobs[rhs].m_cost;
+        });
+
+    const size_t threads = std::min(m_jobs.size(), static_cast<size_t>(m_threads));
+    m_queues = std::vector<Queue>(threads);
+    for (size_t i = 0; i < order.size(); ++i)
+        m_queues[i % threads].m_jobs.push_back(order[i]);
+
+    LOGGER << "Scheduler " << m_jobs.size() << " jobs on " << threads << " threads";
+
+    // read ahead in about the order the jobs start, two files per thread, and
+    // as many queued to write
+    AsyncIO io(static_cast<int>(threads), 2 * threads, m_jobs.front().m_options.m_limits.m_maxInputBytes);
+    std::vector<std::string> filenames;
+    filenames.reserve(order.size());
+    for (const size_t job : order)
+        filenames.push_back(m_jobs[job].m_options.m_srcFilename);
+    io.Prefetch(filenames);
+
+    // one range per thread
+    Parallel::For(threads, static_cast<int>(threads), [this, stats, &io](size_t begin, size_t end)
+        {
+            for (size_t worker = begin; worker < end; ++worker)
+            {
+                size_t job{0};
+                while (Take(worker, job))
+                    Convert(m_jobs[job], stats, io);
+            }
+        });
+
+    // wait for the writes behind
+    io.Finish();
+}
+
+void Scheduler::CancelAll()
+{
+    m_cancelled = true;
+    for (auto & job : m_jobs)
+        job.m_cancel->Request();
+}
+
+const std::vector<Scheduler::Job>& Scheduler::Jobs() const
+{
+    return m_jobs;
+}
+
+uint64_t Scheduler::Cost(const Options& options)
+{
+    struct stat st;
+    if (stat(options.m_srcFilename.c_str(), &st) != 0)
+        return 0;
+
+    // relative cost of a byte of each format: compressed files expand several
+    // times over, tab and TabCode are denser than XML
+    uint64_t weight{1};
+    switch (options.m_srcFormat)
+    {
+    case FormatFt3:
+    case FormatJtz:
+    case FormatMxl:
+        weight = 8;
+        break;
+    case FormatTab:
+    case FormatTabCode:
+        weight = 4;
+        break;
+    default:
+        break;
+    }
+    return static_cast<uint64_t>(st.st_size) * weight;
+}
+
+bool Scheduler::Take(size_t worker, size_t& job)
+{
+    {
+        // own queue, largest first
+        Queue& queue = m_queues[worker];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if (!queue.m_jobs.empty())
+        {
+            job = queue.m_jobs.front();
+            queue.m_jobs.pop_front();
+            return true;
+        }
+    }
+
+    // steal another thread's smallest
+    for (size_t i = 1; i < m_queues.size(); ++i)
+    {
+        Queue& queue = m_queues[(worker + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.m_mutex);
+        if (!queue.m_jobs.empty())
+        {
+            job = queue.m_jobs.back();
+            queue.m_jobs.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::Convert(Job& job, bool stats, AsyncIO& io)
+{
+    job.m_order = m_started++;
+    std::vector<char> srcImage;
+    const bool readAhead{io.Take(job.m_options.m_srcFilename, srcImage)};
+    if (m_cancelled)
+    {
+        job.m_error = Cancelled(false).what();
+        return;
+    }
+
+    job.m_cancel->SetTimeout(m_timeout);
+    CancelScope cancelScope(job.m_cancel.get());
+    try
+    {
+        Converter converter;
+        std::string dstImage;
+        if (!readAhead)
+        {
+            if (stats)
+                converter.Convert(job.m_options, job.m_stats);
+            else
+                converter.Convert(job.m_options);
+        }
+        else if (converter.Convert(job.m_options, srcImage, dstImage, stats ? &job.m_stats : nullptr))
+        {
+            // the write's outcome is read after Run
+            io.Write(job.m_options.m_dstFilename, std::move(dstImage), [&job](const std::string& error)
+                {
+                    job.m_error = error;
+                });
+        }
+    }
+    catch (const Cancelled& e)
+    {
+        job.m_timedOut = e.m_timedOut;
+        if (e.m_timedOut)
+        {
+            std::ostringstream ss;
+            ss << "Error: Timed out after " << m_timeout << " seconds";
+            job.m_error = ss.str();
+        }
+        else
+        {
+            job.m_error = e.what();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        job.m_error = e.what();
+    }
+}
+
+} // namespace luteconv
@@ -0,0 +1,120 @@
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include "asyncio.h"
+#include "cancel.h"
+#include "options.h"
+#include "stats.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace luteconv
+{
+
+/**
+ * Convert a batch of files concurrently, see option --batch.
+ *
+ * Files are started largest estimated cost first, so that a large file is not
+ * left to run alone at the end of the batch.  Each thread has a queue, dealt in
+ * order of cost; a thread whose queue is empty steals the smallest job from
+ * another.  A file that passes its deadline, or is cancelled, fails without
+ * stopping the rest of the batch.
+ *
+ * Source files are read ahead, in the order they are expected to start, and
+ * destination files written behind, see AsyncIO.
+ */
+class Scheduler
+{
+public:
+
+    /**
+     * A file to convert, and its outcome
+     */
+    struct Job
+    {
+        Options m_options;
+        uint64_t m_cost{0};             // estimated, see Cost()
+        Stats m_stats;
+        std::string m_error;            // "" => converted
+        bool m_timedOut{false};
+        bool m_crashed{false};          // the worker process died, see WorkerPool
+        int m_order{-1};                // order started, -1 => not run
+        std::unique_ptr<Cancel> m_cancel;
+    };
+
+    /**
+     * Constructor
+     *
+     * @param[in] jobs number of threads, 0 => one per hardware thread
+     * @param[in] timeout seconds per file, 0 => no limit
+     */
+    Scheduler(int jobs, double timeout);
+
+    /**
+     * Destructor
+     */
+    ~Scheduler() = default;
+
+    /**
+     * Add a file to convert, before Run
+     *
+     * @param[in] options
+     */
+    void Add(const Options& options);
+
+    /**
+     * Convert all the files, returns when all have converted or failed
+     *
+     * @param[in] stats true => collect statistics of each file
+     */
+    void Run(bool stats);
+
+    /**
+     * Cancel the batch, from any thread.  Running conversions stop at their
+     * next bar, those not started are not run.
+     */
+    void CancelAll();
+
+    /**
+     * The files, in the order added
+     *
+     * @return jobs
+     */
+    const std::vector<Job>& Jobs() const;
+
+    /**
+     * Estimate the cost of converting a file from its size and format
+     *
+     * @param[in] options
+     * @return cost, in units of a byte of XML
+     */
+    static uint64_t Cost(const Options& options);
+
+private:
+    // A thread's jobs, in decreasing cost
+    struct Queue
+    {
+        std::mutex m_mutex;
+        std::deque<size_t> m_jobs;
+    };
+
+    bool Take(size_t worker, size_t& job);
+    void Convert(Job& job, bool stats, AsyncIO& io);
+
+    const int m_threads;
+    const double m_timeout;
+    std::vector<Job> m_jobs;
+    std::vector<Queue> m_queues;
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<int> m_started{0};
+};
+
+} // namespace luteconv
+
+#endif // _SCHEDULER_H_
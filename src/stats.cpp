@@ -0,0 +1,536 @@
+#include "stats.h"
+
+#include <sys/stat.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+
+#include "json.h"
+#include "piece.h"
+
+namespace
+{
+
+// Parallel::For workers add to the statistics of the thread that started them
+std::mutex workerMutex;
+
+#ifdef LUTECONV_ALLOC_STATS
+// An accounting build replaces the global allocator.  Allocations are counted
+// only while some thread is collecting statistics, for the process and for the
+// allocating thread.  Each allocation is prefixed with its size to track the
+// live bytes.
+std::atomic<int> collecting{0};
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> allocatedBytes{0};
+thread_local uint64_t threadAllocations{0};
+thread_local uint64_t threadAllocatedBytes{0};
+constexpr size_t headerSize = 16;  // keeps the default new alignment
+std::atomic<int64_t> liveBytes{0};
+std::atomic<int64_t> peakBytes{0};
+
+void RaisePeak(int64_t bytes)
+{
+    int64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (bytes > peak && !peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Header before an allocation of the given alignment, a multiple of it
+size_t HeaderSize(std::align_val_t alignment)
+{
+    return std::max(headerSize, static_cast<size_t>(alignment));
+}
+
+// Count an allocation of size bytes at block, returns the user's pointer after the header
+void* Allocated(void* block, std::size_t header, std::size_t size)
+{
+    if (block == nullptr)
+        throw std::bad_alloc();
+
+    if (collecting.load(std::memory_order_relaxed) > 0)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        ++threadAllocations;
+        threadAllocatedBytes += size;
+    }
+
+    *static_cast<std::size_t*>(block) = size;
+    RaisePeak(liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size));
+    return static_cast<char*>(block) + header;
+}
+
+// Uncount the allocation at p, returns its block
+void* Freed(void* p, std::size_t header)
+{
+    void* block = static_cast<char*>(p) - header;
+    liveBytes.fetch_sub(static_cast<int64_t>(*static_cast<std::size_t*>(block)), std::memory_order_relaxed);
+    return block;
+}
+#endif
+
+void StartCollecting()
+{
+#ifdef LUTECONV_ALLOC_STATS
+    ++collecting;
+#endif
+}
+
+void StopCollecting()
+{
+#ifdef LUTECONV_ALLOC_STATS
+    --collecting;
+#endif
+}
+
+// Allocations of the process, and of the calling thread, while collecting
+uint64_t ProcessAllocations()
+{
+#ifdef LUTECONV_ALLOC_STATS
+    return allocations.load();
+#else
+    return 0;
+#endif
+}
+
+uint64_t ProcessAllocatedBytes()
+{
+#ifdef LUTECONV_ALLOC_STATS
+    return allocatedBytes.load();
+#else
+    return 0;
+#endif
+}
+
+uint64_t ThreadAllocations()
+{
+#ifdef LUTECONV_ALLOC_STATS
+    return threadAllocations;
+#else
+    return 0;
+#endif
+}
+
+uint64_t ThreadAllocatedBytes()
+{
+#ifdef LUTECONV_ALLOC_STATS
+    return threadAllocatedBytes;
+#else
+    return 0;
+#endif
+}
+
+// Start measuring the peak live bytes, returns the peak of any enclosing measurement
+int64_t StartPeak(int64_t& startLiveBytes)
+{
+#ifdef LUTECONV_ALLOC_STATS
+    startLiveBytes = liveBytes.load();
+    return peakBytes.exchange(startLiveBytes);
+#else
+    startLiveBytes = 0;
+    return 0;
+#endif
+}
+
+// Stop measuring, returns the peak above the live bytes at the start
+uint64_t StopPeak(int64_t startLiveBytes, int64_t savedPeakBytes)
+{
+#ifdef LUTECONV_ALLOC_STATS
+    const int64_t peak = peakBytes.load();
+    RaisePeak(savedPeakBytes);
+    return peak > startLiveBytes ? static_cast<uint64_t>(peak - startLiveBytes) : 0;
+#else
+    (void)startLiveBytes;
+    (void)savedPeakBytes;
+    return 0;
+#endif
+}
+
+double Milliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double Milliseconds(std::clock_t clocks)
+{
+    return 1000.0 * static_cast<double>(clocks) / CLOCKS_PER_SEC;
+}
+
+// CPU time of the calling thread, ms
+double ThreadCpu()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return Milliseconds(std::clock());
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return 1000.0 * static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1000000.0;
+#endif
+}
+
+uint64_t FileSize(const std::string& filename)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return 0;
+    return static_cast<uint64_t>(st.st_size);
+}
+
+uint64_t PeakRss()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+}
+
+} // namespace
+
+#ifdef LUTECONV_ALLOC_STATS
+// The replacement global allocator of an accounting build, the array, nothrow
+// and sized forms call these.  Over-aligned allocations have a header of their
+// alignment, so the pointer after it keeps the alignment.
+void* operator new(std::size_t size)
+{
+    return Allocated(std::malloc(headerSize + size), headerSize, size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    const size_t header = HeaderSize(alignment);
+    const size_t align = static_cast<size_t>(alignment);
+    return Allocated(std::aligned_alloc(align, (header + size + align - 1) / align * align), header, size);
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p != nullptr)
+        std::free(Freed(p, headerSize));
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    if (p != nullptr)
+        std::free(Freed(p, HeaderSize(alignment)));
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, std::size_t /*size*/, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+#endif
+
+namespace luteconv
+{
+
+thread_local Stats* Stats::m_current{nullptr};
+
+void Stats::Start(const std::string& srcFilename, const std::string& dstFilename)
+{
+    *this = Stats();
+    m_srcFilename = srcFilename;
+    m_dstFilename = dstFilename;
+    m_bytesIn = FileSize(srcFilename);
+
+    StartCollecting();
+    m_startAllocations = Allocations();
+    m_startAllocatedBytes = AllocatedBytes();
+    m_savedPeakBytes = StartPeak(m_startLiveBytes);
+    m_startWall = std::chrono::steady_clock::now();
+    m_startCpu = Cpu();
+    m_current = this;
+}
+
+void Stats::Stop()
+{
+    m_current = nullptr;
+    m_wall = Milliseconds(std::chrono::steady_clock::now() - m_startWall);
+    m_cpu = Cpu() - m_startCpu;
+    m_allocations = Allocations() - m_startAllocations;
+    m_allocatedBytes = AllocatedBytes() - m_startAllocatedBytes;
+    m_peakBytes = StopPeak(m_startLiveBytes, m_savedPeakBytes);
+    StopCollecting();
+
+    m_bytesOut = FileSize(m_dstFilename);
+    m_peakRss = PeakRss();
+}
+
+void Stats::StartProcess()
+{
+    *this = Stats();
+    StartCollecting();
+    m_startAllocations = ProcessAllocations();
+    m_startAllocatedBytes = ProcessAllocatedBytes();
+    m_savedPeakBytes = StartPeak(m_startLiveBytes);
+    m_startWall = std::chrono::steady_clock::now();
+    m_startCpu = Milliseconds(std::clock());
+}
+
+void Stats::StopProcess()
+{
+    m_wall = Milliseconds(std::chrono::steady_clock::now() - m_startWall);
+    m_cpu = Milliseconds(std::clock()) - m_startCpu;
+    m_allocations = ProcessAllocations() - m_startAllocations;
+    m_allocatedBytes = ProcessAllocatedBytes() - m_startAllocatedBytes;
+    m_peakBytes = StopPeak(m_startLiveBytes, m_savedPeakBytes);
+    StopCollecting();
+
+    m_peakRss = PeakRss();
+}
+
+void Stats::Count(const Piece& piece)
+{
+    m_bars = piece.m_bars.size();
+    for (const auto & bar : piece.m_bars)
+    {
+        m_chords += bar.m_chords.size();
+        for (const auto & chord : bar.m_chords)
+            m_notes += piece.Notes(chord).size();
+    }
+}
+
+Stats* Stats::Current()
+{
+    return m_current;
+}
+
+double Stats::Cpu() const
+{
+    std::lock_guard<std::mutex> lock(workerMutex);
+    return ThreadCpu() + m_workerCpu;
+}
+
+uint64_t Stats::Allocations() const
+{
+    std::lock_guard<std::mutex> lock(workerMutex);
+    return ThreadAllocations() + m_workerAllocations;
+}
+
+uint64_t Stats::AllocatedBytes() const
+{
+    std::lock_guard<std::mutex> lock(workerMutex);
+    return ThreadAllocatedBytes() + m_workerAllocatedBytes;
+}
+
+void Stats::Add(Stats& total) const
+{
+    total.m_wall += m_wall;
+    total.m_cpu += m_cpu;
+    total.m_bytesIn += m_bytesIn;
+    total.m_bytesOut += m_bytesOut;
+    total.m_bars += m_bars;
+    total.m_chords += m_chords;
+    total.m_notes += m_notes;
+    total.m_allocations += m_allocations;
+    total.m_allocatedBytes += m_allocatedBytes;
+    total.m_peakBytes = std::max(total.m_peakBytes, m_peakBytes);
+    total.m_peakRss = std::max(total.m_peakRss, m_peakRss);
+
+    for (const auto & stage : m_stages)
+    {
+        auto it = std::find_if(total.m_stages.begin(), total.m_stages.end(),
+                [&stage](const Stage& s){ return s.m_name == stage.m_name; });
+        if (it == total.m_stages.end())
+        {
+            total.m_stages.push_back(stage);
+        }
+        else
+        {
+            it->m_wall += stage.m_wall;
+            it->m_cpu += stage.m_cpu;
+            it->m_allocations += stage.m_allocations;
+            it->m_allocatedBytes += stage.m_allocatedBytes;
+            it->m_peakBytes = std::max(it->m_peakBytes, stage.m_peakBytes);
+        }
+    }
+}
+
+void Stats::Print(std::ostream& s, const std::vector<Stats>& stats, bool json, const Stats* process)
+{
+    Stats total;
+    for (const auto & file : stats)
+        file.Add(total);
+    if (process != nullptr)
+    {
+        total.m_wall = process->m_wall;
+        total.m_cpu = process->m_cpu;
+        total.m_allocations = process->m_allocations;
+        total.m_allocatedBytes = process->m_allocatedBytes;
+        total.m_peakBytes = process->m_peakBytes;
+        total.m_peakRss = std::max(total.m_peakRss, process->m_peakRss);
+    }
+
+    if (json)
+    {
+        s << "{\"files\": [";
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            s << (i > 0 ? ", " : "");
+            stats[i].PrintJson(s, true);
+        }
+        s << "], \"total\": ";
+        total.PrintJson(s, false);
+        s << "}" << std::endl;
+        return;
+    }
+
+    for (const auto & file : stats)
+        file.PrintText(s);
+
+    if (stats.size() > 1)
+    {
+        total.m_srcFilename = "total";
+        total.PrintText(s);
+    }
+}
+
+void Stats::PrintText(std::ostream& s) const
+{
+    s << m_srcFilename;
+    if (!m_dstFilename.empty())
+        s << " -> " << m_dstFilename;
+    s << std::endl;
+
+    s << std::fixed << std::setprecision(3)
+      << "    " << std::left << std::setw(20) << "stage" << std::right << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms";
+    if (Accounting())
+        s << std::setw(12) << "allocs" << std::setw(14) << "bytes" << std::setw(14) << "peak bytes";
+    s << std::endl;
+    for (const auto & stage : m_stages)
+    {
+        s << "    " << std::left << std::setw(20) << (std::string(2 * stage.m_depth, ' ') + stage.m_name) << std::right
+          << std::setw(12) << stage.m_wall << std::setw(12) << stage.m_cpu;
+        if (Accounting())
+            s << std::setw(12) << stage.m_allocations << std::setw(14) << stage.m_allocatedBytes << std::setw(14) << stage.m_peakBytes;
+        s << std::endl;
+    }
+    s << "    " << std::left << std::setw(20) << "all" << std::right << std::setw(12) << m_wall << std::setw(12) << m_cpu;
+    if (Accounting())
+        s << std::setw(12) << m_allocations << std::setw(14) << m_allocatedBytes << std::setw(14) << m_peakBytes;
+    s << std::endl;
+    s.unsetf(std::ios_base::floatfield);
+
+    s << "    bytes in " << m_bytesIn << ", out " << m_bytesOut << std::endl
+      << "    bars " << m_bars << ", chords " << m_chords << ", notes " << m_notes << std::endl;
+    if (Accounting())
+        s << "    allocations " << m_allocations << ", " << m_allocatedBytes << " bytes, peak live " << m_peakBytes << " bytes" << std::endl;
+    s << "    peak RSS " << m_peakRss << " KiB" << std::endl;
+}
+
+void Stats::PrintJson(std::ostream& s, bool file) const
+{
+    s << "{";
+    if (file)
+        s << "\"source\": " << Json::String(m_srcFilename) << ", \"destination\": " << Json::String(m_dstFilename) << ", ";
+
+    s << std::fixed << std::setprecision(3)
+      << "\"wall_ms\": " << m_wall << ", \"cpu_ms\": " << m_cpu << ", \"stages\": [";
+    for (size_t i = 0; i < m_stages.size(); ++i)
+    {
+        s << (i > 0 ? ", " : "") << "{\"name\": " << Json::String(m_stages[i].m_name) << ", \"depth\": " << m_stages[i].m_depth
+          << ", \"wall_ms\": " << m_stages[i].m_wall << ", \"cpu_ms\": " << m_stages[i].m_cpu;
+        if (Accounting())
+        {
+            s << ", \"allocations\": " << m_stages[i].m_allocations << ", \"allocated_bytes\": " << m_stages[i].m_allocatedBytes
+              << ", \"peak_bytes\": " << m_stages[i].m_peakBytes;
+        }
+        s << "}";
+    }
+    s.unsetf(std::ios_base::floatfield);
+
+    s << "], \"bytes_in\": " << m_bytesIn << ", \"bytes_out\": " << m_bytesOut
+      << ", \"bars\": " << m_bars << ", \"chords\": " << m_chords << ", \"notes\": " << m_notes;
+    if (Accounting())
+        s << ", \"allocations\": " << m_allocations << ", \"allocated_bytes\": " << m_allocatedBytes << ", \"peak_bytes\": " << m_peakBytes;
+    s << ", \"peak_rss_kib\": " << m_peakRss << "}";
+}
+
+StatsScope::StatsScope(const char* stage)
+: m_stats{Stats::Current()}
+{
+    if (m_stats == nullptr)
+        return;
+
+    // stages are listed in the order they first start
+    auto& stages = m_stats->m_stages;
+    auto it = std::find_if(stages.begin(), stages.end(), [stage](const Stats::Stage& s){ return s.m_name == stage; });
+    if (it == stages.end())
+    {
+        stages.emplace_back();
+        stages.back().m_name = stage;
+        stages.back().m_depth = m_stats->m_depth;
+        it = stages.end() - 1;
+    }
+    m_stage = it - stages.begin();
+    ++m_stats->m_depth;
+
+    if (Stats::Accounting())
+    {
+        m_startAllocations = m_stats->Allocations();
+        m_startAllocatedBytes = m_stats->AllocatedBytes();
+        m_savedPeakBytes = StartPeak(m_startLiveBytes);
+    }
+    m_startWall = std::chrono::steady_clock::now();
+    m_startCpu = m_stats->Cpu();
+}
+
+StatsScope::~StatsScope()
+{
+    if (m_stats == nullptr)
+        return;
+
+    Stats::Stage& stage = m_stats->m_stages[m_stage];
+    stage.m_wall += Milliseconds(std::chrono::steady_clock::now() - m_startWall);
+    stage.m_cpu += m_stats->Cpu() - m_startCpu;
+    if (Stats::Accounting())
+    {
+        stage.m_allocations += m_stats->Allocations() - m_startAllocations;
+        stage.m_allocatedBytes += m_stats->AllocatedBytes() - m_startAllocatedBytes;
+        stage.m_peakBytes = std::max(stage.m_peakBytes, StopPeak(m_startLiveBytes, m_savedPeakBytes));
+    }
+    --m_stats->m_depth;
+}
+
+StatsWorkerScope::StatsWorkerScope(Stats* stats)
+: m_stats{stats == Stats::Current() ? nullptr : stats}
+{
+    if (m_stats == nullptr)
+        return;
+
+    m_startCpu = ThreadCpu();
+    m_startAllocations = ThreadAllocations();
+    m_startAllocatedBytes = ThreadAllocatedBytes();
+}
+
+StatsWorkerScope::~StatsWorkerScope()
+{
+    if (m_stats == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(workerMutex);
+    m_stats->m_workerCpu += ThreadCpu() - m_startCpu;
+    m_stats->m_workerAllocations += ThreadAllocations() - m_startAllocations;
+    m_stats->m_workerAllocatedBytes += ThreadAllocatedBytes() - m_startAllocatedBytes;
+}
+
+} // namespace luteconv
@@ -0,0 +1,220 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace luteconv
+{
+
+class Piece;
+
+/**
+ * Timing and resource statistics of a conversion, see option --stats
+ */
+class Stats
+{
+public:
+
+    /**
+     * Time spent in a stage, stages may nest.
+     * Allocations are tallied only by an accounting build, see Accounting()
+     */
+    struct Stage
+    {
+        std::string m_name;
+        int m_depth{0};
+        double m_wall{0.0};             // ms
+        double m_cpu{0.0};              // ms, of the converting thread and its Parallel::For workers
+        uint64_t m_allocations{0};      // as m_cpu, including nested stages
+        uint64_t m_allocatedBytes{0};
+        uint64_t m_peakBytes{0};        // peak live bytes above those live at the start
+    };
+
+    /**
+     * Constructor
+     */
+    Stats() = default;
+
+    /**
+     * Destructor
+     */
+    ~Stats() = default;
+
+    /**
+     * Start collecting for the calling thread
+     *
+     * @param[in] srcFilename
+     * @param[in] dstFilename
+     */
+    void Start(const std::string& srcFilename, const std::string& dstFilename);
+
+    /**
+     * Stop collecting
+     */
+    void Stop();
+
+    /**
+     * Start collecting the total of a batch, for all threads of the process.
+     * The calling thread does not collect, see Current().
+     */
+    void StartProcess();
+
+    /**
+     * Stop collecting the total of a batch
+     */
+    void StopProcess();
+
+    /**
+     * Count the bars, chords and notes of a piece
+     *
+     * @param[in] piece
+     */
+    void Count(const Piece& piece);
+
+    /**
+     * Print statistics of one or more conversions, and their total.
+     * Conversions that ran concurrently in this process share its threads, so
+     * the total time and allocations are those collected by StartProcess, the
+     * counts are summed.
+     *
+     * @param[in] s destination
+     * @param[in] stats
+     * @param[in] json true => JSON, false => text
+     * @param[in] process collected by StartProcess, nullptr => sum the conversions
+     */
+    static void Print(std::ostream& s, const std::vector<Stats>& stats, bool json, const Stats* process = nullptr);
+
+    /**
+     * Statistics being collected by the calling thread
+     *
+     * @return stats, nullptr => none
+     */
+    static Stats* Current();
+
+    /**
+     * Is this an allocation accounting build, cmake -DALLOC_STATS=ON.
+     * It replaces the global operator new and delete to count allocations,
+     * tallies them per stage and tracks peak live bytes.
+     *
+     * @return true <=> accounting
+     */
+    static constexpr bool Accounting()
+    {
+#ifdef LUTECONV_ALLOC_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string m_srcFilename;
+    std::string m_dstFilename;
+    double m_wall{0.0};             // ms
+    double m_cpu{0.0};              // ms, of the converting thread and its Parallel::For workers
+    uint64_t m_bytesIn{0};
+    uint64_t m_bytesOut{0};
+    uint64_t m_bars{0};
+    uint64_t m_chords{0};
+    uint64_t m_notes{0};
+    uint64_t m_allocations{0};      // as m_cpu, accounting only
+    uint64_t m_allocatedBytes{0};   // accounting only
+    uint64_t m_peakBytes{0};        // peak live bytes above those live at the start, accounting only
+    uint64_t m_peakRss{0};          // KiB, of the process so far
+    std::vector<Stage> m_stages;
+
+private:
+    friend class StatsScope;
+    friend class StatsWorkerScope;
+
+    double Cpu() const;
+    uint64_t Allocations() const;
+    uint64_t AllocatedBytes() const;
+    void Add(Stats& total) const;
+    void PrintText(std::ostream& s) const;
+    void PrintJson(std::ostream& s, bool file) const;
+
+    std::chrono::steady_clock::time_point m_startWall;
+    double m_startCpu{0.0};
+    uint64_t m_startAllocations{0};
+    uint64_t m_startAllocatedBytes{0};
+    int64_t m_startLiveBytes{0};
+    int64_t m_savedPeakBytes{0};
+    int m_depth{0};
+    double m_workerCpu{0.0};        // ms, of finished Parallel::For workers
+    uint64_t m_workerAllocations{0};
+    uint64_t m_workerAllocatedBytes{0};
+    static thread_local Stats* m_current;
+};
+
+/**
+ * Time a stage of the conversion for the lifetime of this object.
+ * Does nothing if the calling thread is not collecting statistics.
+ */
+class StatsScope
+{
+public:
+
+    /**
+     * Constructor
+     *
+     * @param[in] stage name
+     */
+    explicit StatsScope(const char* stage);
+
+    /**
+     * Destructor
+     */
+    ~StatsScope();
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+private:
+    Stats* const m_stats;
+    size_t m_stage{0};
+    std::chrono::steady_clock::time_point m_startWall;
+    double m_startCpu{0.0};
+    uint64_t m_startAllocations{0};
+    uint64_t m_startAllocatedBytes{0};
+    int64_t m_startLiveBytes{0};
+    int64_t m_savedPeakBytes{0};
+};
+
+/**
+ * Add the CPU time and allocations of a Parallel::For worker thread to the
+ * statistics of the thread that started it, for the lifetime of this object.
+ * Stages are timed only by the collecting thread.
+ */
+class StatsWorkerScope
+{
+public:
+
+    /**
+     * Constructor
+     *
+     * @param[in] stats of the starting thread, nullptr or the calling thread's => none
+     */
+    explicit StatsWorkerScope(Stats* stats);
+
+    /**
+     * Destructor
+     */
+    ~StatsWorkerScope();
+
+    StatsWorkerScope(const StatsWorkerScope&) = delete;
+    StatsWorkerScope& operator=(const StatsWorkerScope&) = delete;
+
+private:
+    Stats* const m_stats;
+    double m_startCpu{0.0};
+    uint64_t m_startAllocations{0};
+    uint64_t m_startAllocatedBytes{0};
+};
+
+} // namespace luteconv
+
+#endif // _STATS_H_
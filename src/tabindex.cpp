@@ -0,0 +1,175 @@
+#include "tabindex.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "lexer.h"
+
+namespace luteconv
+{
+
+namespace
+{
+
+const char sidecarMagic[] = "luteconv-tabindex 1";
+const size_t hashSample = 4096;
+
+void Fnv1a(const char* data, size_t size, uint64_t& hash)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+}
+
+} // namespace
+
+bool TabIndex::Key::operator==(const Key& rhs) const
+{
+    return m_size == rhs.m_size && m_mtime == rhs.m_mtime && m_hash == rhs.m_hash;
+}
+
+void TabIndex::Build(std::string_view text)
+{
+    m_sections.clear();
+    
+    TabSection section;
+    LineLexer lexer{text};
+    std::string_view line;
+    size_t offset{0};
+    
+    while (lexer.Next(line))
+    {
+        const size_t next = offset + line.size() + 1;
+        
+        // assume sections are separated by end of page
+        if (LineLexer::TrimRight(line) == "p")
+        {
+            section.m_size = offset > section.m_offset ? offset - 1 - section.m_offset : 0;
+            m_sections.push_back(section);
+            section.m_offset = std::min(next, text.size());
+            section.m_lineNo = lexer.LineNo();
+        }
+        offset = next;
+    }
+    
+    section.m_size = text.size() - section.m_offset;
+    m_sections.push_back(section);
+}
+
+bool TabIndex::Find(int index, TabSection& section) const
+{
+    if (index < 0 || static_cast<size_t>(index) >= m_sections.size())
+        return false;
+    
+    section = m_sections[index];
+    return true;
+}
+
+size_t TabIndex::Size() const
+{
+    return m_sections.size();
+}
+
+bool TabIndex::Load(const std::string& filename, const Key& key)
+{
+    m_sections.clear();
+    
+    std::ifstream src(filename.c_str());
+    std::string magic;
+    if (!std::getline(src, magic) || magic != sidecarMagic)
+        return false;
+    
+    Key cached;
+    size_t count{0};
+    if (!(src >> cached.m_size >> cached.m_mtime >> cached.m_hash >> count) || !(cached == key))
+        return false;
+    
+    // a file of n bytes has at most n + 1 sections, a larger count is corrupt
+    if (count == 0 || count > key.m_size + 1)
+        return false;
+    
+    for (size_t i = 0; i < count; ++i)
+    {
+        TabSection section;
+        if (!(src >> section.m_offset >> section.m_size >> section.m_lineNo) ||
+                section.m_offset > key.m_size || section.m_size > key.m_size - section.m_offset)
+        {
+            m_sections.clear();
+            return false;
+        }
+        m_sections.push_back(section);
+    }
+    return true;
+}
+
+bool TabIndex::Save(const std::string& filename, const Key& key) const
+{
+    // write a temporary file then rename it, a concurrent Load sees the old sidecar or the new
+    std::ostringstream ss;
+    ss << filename << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << "-" << std::random_device()() << ".tmp";
+    const std::string tmpFilename = ss.str();
+    
+    std::ofstream dst(tmpFilename.c_str());
+    dst << sidecarMagic << "\n"
+        << key.m_size << " " << key.m_mtime << " " << key.m_hash << " " << m_sections.size() << "\n";
+    for (const auto & section : m_sections)
+        dst << section.m_offset << " " << section.m_size << " " << section.m_lineNo << "\n";
+    dst.close();
+    
+    std::error_code ec;
+    if (!dst.fail())
+        std::filesystem::rename(tmpFilename, filename, ec);
+    if (dst.fail() || ec)
+    {
+        std::filesystem::remove(tmpFilename, ec);
+        return false;
+    }
+    return true;
+}
+
+bool TabIndex::GetKey(const std::string& filename, Key& key)
+{
+    std::error_code ec;
+    const std::filesystem::path path{filename};
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return false;
+    
+    key.m_size = size;
+    key.m_mtime = mtime.time_since_epoch().count();
+    key.m_hash = 0xcbf29ce484222325ULL;
+    
+    // sample the head and tail, rather than read the whole file
+    std::ifstream src(filename.c_str(), std::ios::binary);
+    if (!src.is_open())
+        return false;
+    
+    std::string sample(static_cast<size_t>(std::min<uintmax_t>(size, hashSample)), '\0');
+    src.read(&sample[0], sample.size());
+    Fnv1a(sample.data(), static_cast<size_t>(src.gcount()), key.m_hash);
+    
+    if (size > hashSample)
+    {
+        src.seekg(static_cast<std::streamoff>(size - sample.size()));
+        src.read(&sample[0], sample.size());
+        Fnv1a(sample.data(), static_cast<size_t>(src.gcount()), key.m_hash);
+    }
+    return !src.bad();
+}
+
+std::string TabIndex::SidecarFilename(const std::string& filename)
+{
+    return filename + ".tabidx";
+}
+
+} // namespace luteconv
@@ -0,0 +1,116 @@
+#ifndef _TABINDEX_H_
+#define _TABINDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace luteconv
+{
+
+/**
+ * A section of a Tab file, sections are separated by "p" lines
+ */
+struct TabSection
+{
+    size_t m_offset{0};     // byte offset of the first line
+    size_t m_size{0};       // bytes, excluding the line break before the next "p"
+    int m_lineNo{0};        // number of lines before the section
+};
+
+/**
+ * Byte offsets of the sections of a Tab file, optionally cached
+ * in a sidecar file
+ */
+class TabIndex
+{
+public:
+    
+    /**
+     * Identifies the version of a file that an index was built from
+     */
+    struct Key
+    {
+        uint64_t m_size{0};
+        int64_t m_mtime{0};
+        uint64_t m_hash{0};     // FNV-1a of the first and last 4KiB
+        
+        bool operator==(const Key& rhs) const;
+    };
+
+    /**
+     * Constructor
+     */
+    TabIndex() = default;
+
+    /**
+     * Destructor
+     */
+    ~TabIndex() = default;
+    
+    /**
+     * Build the index from a Tab file image
+     * 
+     * @param[in] text
+     */
+    void Build(std::string_view text);
+    
+    /**
+     * Get a section
+     * 
+     * @param[in] index counting from 0
+     * @param[out] section
+     * @return true <=> section exists
+     */
+    bool Find(int index, TabSection& section) const;
+    
+    /**
+     * Number of sections
+     * 
+     * @return number of sections
+     */
+    size_t Size() const;
+    
+    /**
+     * Load the index from a sidecar file
+     * 
+     * @param[in] filename sidecar
+     * @param[in] key of the Tab file
+     * @return true <=> loaded, false <=> missing, corrupt or stale
+     */
+    bool Load(const std::string& filename, const Key& key);
+    
+    /**
+     * Save the index to a sidecar file
+     * 
+     * @param[in] filename sidecar
+     * @param[in] key of the Tab file
+     * @return true <=> saved
+     */
+    bool Save(const std::string& filename, const Key& key) const;
+    
+    /**
+     * Get the key of a file
+     * 
+     * @param[in] filename
+     * @param[out] key
+     * @return true <=> success
+     */
+    static bool GetKey(const std::string& filename, Key& key);
+    
+    /**
+     * Sidecar filename for a Tab file
+     * 
+     * @param[in] filename Tab file
+     * @return sidecar filename
+     */
+    static std::string SidecarFilename(const std::string& filename);
+    
+private:
+    std::vector<TabSection> m_sections;
+};
+
+} // namespace luteconv
+
+#endif // _TABINDEX_H_
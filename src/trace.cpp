@@ -0,0 +1,145 @@
+#include "trace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "json.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+struct Event
+{
+    const char* m_name;
+    std::string m_detail;
+    std::chrono::steady_clock::time_point m_begin;
+    std::chrono::steady_clock::time_point m_end;
+};
+
+// Spans of one thread, owned by the registry so they outlive the thread
+struct Track
+{
+    int m_tid{0};
+    std::mutex m_mutex;     // uncontended but for Write
+    std::vector<Event> m_events;
+};
+
+struct Registry
+{
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Track>> m_tracks;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+Track& GetTrack()
+{
+    thread_local Track* track{nullptr};
+    if (track == nullptr)
+    {
+        Registry& registry = GetRegistry();
+        const std::lock_guard<std::mutex> lock(registry.m_mutex);
+        registry.m_tracks.push_back(std::make_unique<Track>());
+        track = registry.m_tracks.back().get();
+        track->m_tid = static_cast<int>(registry.m_tracks.size());
+    }
+    return *track;
+}
+
+int Pid()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return 1;
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+double Microseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // namespace
+
+namespace luteconv
+{
+
+std::atomic<bool> Trace::m_enabled{false};
+
+void Trace::Start()
+{
+    GetTrack();     // the calling thread is the first track
+    Registry& registry = GetRegistry();
+    const std::lock_guard<std::mutex> lock(registry.m_mutex);
+    for (auto & track : registry.m_tracks)
+    {
+        const std::lock_guard<std::mutex> trackLock(track->m_mutex);
+        track->m_events.clear();
+    }
+    registry.m_start = std::chrono::steady_clock::now();
+    m_enabled = true;
+}
+
+void Trace::Record(const char* name, std::string detail,
+        std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+    Track& track = GetTrack();
+    const std::lock_guard<std::mutex> lock(track.m_mutex);
+    track.m_events.push_back(Event{name, std::move(detail), begin, end});
+}
+
+void Trace::Write(const std::string& filename)
+{
+    m_enabled = false;
+
+    std::ofstream s(filename.c_str(), std::ofstream::out | std::ofstream::trunc);
+    if (!s.is_open())
+        throw std::runtime_error(std::string("Error: Can't open ") + filename);
+
+    const int pid = Pid();
+    Registry& registry = GetRegistry();
+    const std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+    s << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl
+      << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": 0, \"args\": {\"name\": \"luteconv\"}}";
+
+    s << std::fixed << std::setprecision(3);
+    for (auto & track : registry.m_tracks)
+    {
+        const std::lock_guard<std::mutex> trackLock(track->m_mutex);
+        if (track->m_events.empty())
+            continue;
+
+        s << "," << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << track->m_tid
+          << ", \"args\": {\"name\": \"thread " << track->m_tid << "\"}}";
+
+        for (const auto & event : track->m_events)
+        {
+            s << "," << std::endl << "{\"name\": " << Json::String(event.m_name) << ", \"ph\": \"X\", \"pid\": " << pid
+              << ", \"tid\": " << track->m_tid
+              << ", \"ts\": " << Microseconds(event.m_begin - registry.m_start)
+              << ", \"dur\": " << Microseconds(event.m_end - event.m_begin);
+            if (!event.m_detail.empty())
+                s << ", \"args\": {\"detail\": " << Json::String(event.m_detail) << "}";
+            s << "}";
+        }
+        track->m_events.clear();
+    }
+    s << std::endl << "]}" << std::endl;
+}
+
+} // namespace luteconv
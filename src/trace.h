@@ -0,0 +1,132 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace luteconv
+{
+
+// Time the rest of the enclosing scope as a span of the trace, see option --trace.
+// Without LUTECONV_TRACE, cmake -DTRACE=OFF, spans are compiled out.
+#ifdef LUTECONV_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(...) luteconv::TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+#else
+#define TRACE_SPAN(...)
+#endif
+
+/**
+ * Record spans from every thread and write them as a Chrome trace,
+ * viewable in chrome://tracing or https://ui.perfetto.dev
+ */
+class Trace
+{
+public:
+
+    /**
+     * Start recording, discarding any earlier spans
+     */
+    static void Start();
+
+    /**
+     * Stop recording and write the spans, one track per thread
+     *
+     * @param[in] filename
+     */
+    static void Write(const std::string& filename);
+
+    /**
+     * Is recording
+     *
+     * @return true <=> recording
+     */
+    static bool Enabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Are spans compiled in
+     *
+     * @return true <=> compiled in
+     */
+    static constexpr bool Compiled()
+    {
+#ifdef LUTECONV_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Record a span of the calling thread
+     *
+     * @param[in] name static string
+     * @param[in] detail shown as the span's argument, may be empty
+     * @param[in] begin
+     * @param[in] end
+     */
+    static void Record(const char* name, std::string detail,
+            std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+private:
+    static std::atomic<bool> m_enabled;
+};
+
+/**
+ * A span from construction to destruction, use TRACE_SPAN
+ */
+class TraceSpan
+{
+public:
+
+    /**
+     * Constructor
+     *
+     * @param[in] name static string
+     */
+    explicit TraceSpan(const char* name)
+    : m_name{Trace::Enabled() ? name : nullptr}
+    {
+        if (m_name != nullptr)
+            m_begin = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Constructor
+     *
+     * @param[in] name static string
+     * @param[in] detail
+     */
+    TraceSpan(const char* name, const std::string& detail)
+    : TraceSpan(name)
+    {
+        if (m_name != nullptr)
+            m_detail = detail;
+    }
+
+    /**
+     * Destructor, records the span
+     */
+    ~TraceSpan()
+    {
+        if (m_name != nullptr)
+            Trace::Record(m_name, std::move(m_detail), m_begin, std::chrono::steady_clock::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* const m_name;
+    std::string m_detail;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+} // namespace luteconv
+
+#endif // _TRACE_H_
@@ -4,34 +4,98 @@
 #include <sstream>
 #include <stdexcept>
 
+#include <sys/stat.h>
 #include <zip.h>
 
+#include "cancel.h"
 #include "logger.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace luteconv
 {
 
-void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std::string& zipFilename)
+namespace
 {
+
+// Open an archive from memory, the archive owns the source once opened
+zip* OpenImage(const std::vector<char>& zipImage, zip_error_t& error)
+{
+    zip_source_t* source = zip_source_buffer_create(zipImage.data(), zipImage.size(), 0, &error);
+    if (source == nullptr)
+        return nullptr;
+    
+    zip* zipArchive = zip_open_from_source(source, ZIP_RDONLY, &error);
+    if (zipArchive == nullptr)
+        zip_source_free(source);
+    return zipArchive;
+}
+
+} // namespace
+
+void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std::string& zipFilename,
+        const InputLimits& limits)
+{
+    Unzip(filename, nullptr, &image, nullptr, zipFilename, limits);
+}
+
+void Unzipper::Unzip(const std::string& filename, std::ostream& dst, std::string& zipFilename,
+        const InputLimits& limits)
+{
+    Unzip(filename, nullptr, nullptr, &dst, zipFilename, limits);
+}
+
+void Unzipper::Unzip(const std::string& filename, const std::vector<char>& zipImage, std::vector<char>& image,
+        std::string& zipFilename, const InputLimits& limits)
+{
+    Unzip(filename, &zipImage, &image, nullptr, zipFilename, limits);
+}
+
+void Unzipper::Unzip(const std::string& filename, const std::vector<char>& zipImage, std::ostream& dst,
+        std::string& zipFilename, const InputLimits& limits)
+{
+    Unzip(filename, &zipImage, nullptr, &dst, zipFilename, limits);
+}
+
+void Unzipper::Unzip(const std::string& filename, const std::vector<char>* zipImage, std::vector<char>* image,
+        std::ostream* dst, std::string& zipFilename, const InputLimits& limits)
+{
+    StatsScope statsScope("unzip");
+    TRACE_SPAN("Unzipper::Unzip");
     int err{0};
+    zip_error_t error;
+    zip_error_init(&error);
     zip_file* zipFile{nullptr};
-    zip* zipArchive = zip_open(filename.c_str(), 0, &err);
+    zip* zipArchive = zipImage != nullptr ? OpenImage(*zipImage, error) : zip_open(filename.c_str(), 0, &err);
         
     try
     {
         if (zipArchive == nullptr)
         {
-            char buf[100];
-            zip_error_to_str(buf, sizeof(buf), err, errno);
-            
             std::ostringstream ss;
-            ss << "Error: Can't open zip archive " << filename << " " << buf;
+            ss << "Error: Can't open zip archive " << filename << " ";
+            if (zipImage != nullptr)
+            {
+                ss << zip_error_strerror(&error);
+            }
+            else
+            {
+                char buf[100];
+                zip_error_to_str(buf, sizeof(buf), err, errno);
+                ss << buf;
+            }
             throw std::runtime_error(ss.str());
         }
     
 
+        struct stat st;
+        const uint64_t compressed = zipImage != nullptr ? zipImage->size()
+                : stat(filename.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+        const zip_int64_t entries = zip_get_num_entries(zipArchive, 0);
+        limits.CheckZipEntries(filename, entries > 0 ? static_cast<uint64_t>(entries) : 0);
+
         std::vector<std::pair<std::string, zip_uint64_t>> index;
-        for (int i = 0; i < zip_get_num_entries(zipArchive, 0); i++)
+        for (zip_int64_t i = 0; i < entries; i++)
         {
             struct zip_stat sb;
     
@@ -42,14 +106,18 @@ void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std:
             }
         }
                  
+        if (index.empty())
+            throw std::runtime_error("Error: Empty zip archive " + filename);
+
         // zip files are archives, find our particular file
         size_t entry = 0;
         if (index.size() > 1)
         {
-            // look for our candidate
+            // look for our candidate, not the mimetype, META-INF or a directory
             for (size_t i = 0; i < index.size(); ++i)
             {
-                if (index[i].first != "mimetype" && index[i].first != "META-INF/container.xml")
+                const std::string& name = index[i].first;
+                if (name != "mimetype" && name.compare(0, 9, "META-INF/") != 0 && name.back() != '/')
                 {
                     entry = i;
                     break;
@@ -58,7 +126,7 @@ void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std:
         }
 
         zipFilename = index[entry].first;
-        zip_file* zipFile = zip_fopen_index(zipArchive, entry, 0);
+        zipFile = zip_fopen_index(zipArchive, entry, 0);
         if (!zipFile)
         {
             std::ostringstream ss;
@@ -66,16 +134,21 @@ void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std:
             throw std::runtime_error(ss.str());
         }
         
-        // decompress and read all the file into memory
-        const zip_uint64_t blockInc = 4096;
-        zip_uint64_t blockSize = index[0].second + blockInc;
+        // decompress and read all the file into memory, or a block at a time to
+        // the stream, the declared size may be false
+        limits.CheckInflated(filename, compressed, index[entry].second);
+        const zip_uint64_t blockInc = dst != nullptr ? 65536 : 4096;
+        zip_uint64_t blockSize = dst != nullptr ? blockInc : index[entry].second + blockInc;
 
+        std::vector<char> block;
+        std::vector<char>& buffer = dst != nullptr ? block : *image;
         zip_uint64_t imageSize{0};
-        image.resize(static_cast<size_t>(blockSize));
+        buffer.resize(static_cast<size_t>(blockSize));
         
         for (;;)
         {
-            const zip_int64_t nRead = zip_fread(zipFile, image.data() + imageSize, blockSize);
+            const zip_uint64_t offset = dst != nullptr ? 0 : imageSize;
+            const zip_int64_t nRead = zip_fread(zipFile, buffer.data() + offset, blockSize);
             if (nRead < 0)
             {
                 std::ostringstream ss;
@@ -83,15 +156,21 @@ void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std:
                 throw std::runtime_error(ss.str());
             }
             
-            imageSize += static_cast<unsigned int>(nRead);
-            if (nRead < static_cast<int>(blockSize))
+            imageSize += static_cast<zip_uint64_t>(nRead);
+            limits.CheckInflated(filename, compressed, imageSize);
+            Cancel::Check();
+            if (dst != nullptr && !dst->write(buffer.data(), static_cast<std::streamsize>(nRead)))
+                throw std::runtime_error(std::string("Error: Writing ") + zipFilename);
+            if (nRead < static_cast<zip_int64_t>(blockSize))
                 break;
         
             blockSize = blockInc;
-            image.resize(static_cast<size_t>(imageSize + blockSize));
+            if (dst == nullptr)
+                buffer.resize(static_cast<size_t>(imageSize + blockSize));
         }
         
-        image.resize(static_cast<size_t>(imageSize));
+        if (dst == nullptr)
+            buffer.resize(static_cast<size_t>(imageSize));
     }
     catch (...)
     {
@@ -99,6 +178,7 @@ void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std:
             zip_fclose(zipFile);
         if (zipArchive)
             zip_close(zipArchive);
+        zip_error_fini(&error);
         throw;
     }
     
@@ -106,6 +186,7 @@ void Unzipper::Unzip(const std::string& filename, std::vector<char>& image, std:
         zip_fclose(zipFile);
     if (zipArchive)
         zip_close(zipArchive);
+    zip_error_fini(&error);
 }
 
 } // namespace luteconv
@@ -1,9 +1,12 @@
 #ifndef _UNZIPPER_H_
 #define _UNZIPPER_H_
 
+#include <iosfwd>
 #include <vector>
 #include <string>
 
+#include "inputlimits.h"
+
 namespace luteconv
 {
 
@@ -30,8 +33,49 @@ public:
      * @param[in] filename
      * @param[out] image
      * @param[out] zipFilename - filename extracted from archive
+     * @param[in] limits on the archive and its decompressed size
+     */
+    static void Unzip(const std::string& filename, std::vector<char>& image, std::string& zipFilename,
+            const InputLimits& limits = InputLimits());
+    
+    /**
+     * Unzip a file to a stream, a block at a time
+     * 
+     * @param[in] filename
+     * @param[out] dst
+     * @param[out] zipFilename - filename extracted from archive
+     * @param[in] limits on the archive and its decompressed size
      */
-    static void Unzip(const std::string& filename, std::vector<char>& image, std::string& zipFilename);
+    static void Unzip(const std::string& filename, std::ostream& dst, std::string& zipFilename,
+            const InputLimits& limits = InputLimits());
+    
+    /**
+     * Unzip a memory image of an archive into a memory image
+     * 
+     * @param[in] filename of the archive, for messages
+     * @param[in] zipImage archive
+     * @param[out] image
+     * @param[out] zipFilename - filename extracted from archive
+     * @param[in] limits on the archive and its decompressed size
+     */
+    static void Unzip(const std::string& filename, const std::vector<char>& zipImage, std::vector<char>& image,
+            std::string& zipFilename, const InputLimits& limits = InputLimits());
+    
+    /**
+     * Unzip a memory image of an archive to a stream, a block at a time
+     * 
+     * @param[in] filename of the archive, for messages
+     * @param[in] zipImage archive
+     * @param[out] dst
+     * @param[out] zipFilename - filename extracted from archive
+     * @param[in] limits on the archive and its decompressed size
+     */
+    static void Unzip(const std::string& filename, const std::vector<char>& zipImage, std::ostream& dst,
+            std::string& zipFilename, const InputLimits& limits = InputLimits());
+
+private:
+    static void Unzip(const std::string& filename, const std::vector<char>* zipImage, std::vector<char>* image,
+            std::ostream* dst, std::string& zipFilename, const InputLimits& limits);
 };
 
 } // namespace luteconv
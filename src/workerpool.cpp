@@ -0,0 +1,513 @@
+#include "workerpool.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+
+#include "converter.h"
+#include "logger.h"
+#include "parallel.h"
+#include "trace.h"
+
+namespace
+{
+
+// a worker that has not stopped itself this long after its file's deadline is killed
+constexpr double killGrace{2.0}; // seconds
+
+constexpr int pollPeriod{100}; // ms
+
+// workers that die before their job is sent are restarted, at most this many times in a row
+constexpr int maxRestarts{3};
+
+bool WriteAll(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ReadAll(int fd, void* data, size_t size)
+{
+    char* p = static_cast<char*>(data);
+    while (size > 0)
+    {
+        const ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * A worker's result, as sent to the supervisor: fixed size fields in native
+ * byte order, strings length prefixed.  Both ends are the same executable.
+ */
+class Message
+{
+public:
+    template <typename T>
+    void Put(const T& value)
+    {
+        m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void Put(const std::string& value)
+    {
+        Put(static_cast<uint32_t>(value.size()));
+        m_buffer.append(value);
+    }
+
+    template <typename T>
+    void Get(T& value)
+    {
+        Need(sizeof(value));
+        std::memcpy(&value, m_buffer.data() + m_pos, sizeof(value));
+        m_pos += sizeof(value);
+    }
+
+    void Get(std::string& value)
+    {
+        uint32_t size{0};
+        Get(size);
+        Need(size);
+        value.assign(m_buffer, m_pos, size);
+        m_pos += size;
+    }
+
+    void PutStats(const luteconv::Stats& stats)
+    {
+        Put(stats.m_srcFilename);
+        Put(stats.m_dstFilename);
+        Put(stats.m_wall);
+        Put(stats.m_cpu);
+        Put(stats.m_bytesIn);
+        Put(stats.m_bytesOut);
+        Put(stats.m_bars);
+        Put(stats.m_chords);
+        Put(stats.m_notes);
+        Put(stats.m_allocations);
+        Put(stats.m_allocatedBytes);
+        Put(stats.m_peakBytes);
+        Put(stats.m_peakRss);
+        Put(static_cast<uint32_t>(stats.m_stages.size()));
+        for (const auto & stage : stats.m_stages)
+        {
+            Put(stage.m_name);
+            Put(stage.m_depth);
+            Put(stage.m_wall);
+            Put(stage.m_cpu);
+            Put(stage.m_allocations);
+            Put(stage.m_allocatedBytes);
+            Put(stage.m_peakBytes);
+        }
+    }
+
+    void GetStats(luteconv::Stats& stats)
+    {
+        Get(stats.m_srcFilename);
+        Get(stats.m_dstFilename);
+        Get(stats.m_wall);
+        Get(stats.m_cpu);
+        Get(stats.m_bytesIn);
+        Get(stats.m_bytesOut);
+        Get(stats.m_bars);
+        Get(stats.m_chords);
+        Get(stats.m_notes);
+        Get(stats.m_allocations);
+        Get(stats.m_allocatedBytes);
+        Get(stats.m_peakBytes);
+        Get(stats.m_peakRss);
+        uint32_t stages{0};
+        Get(stages);
+        stats.m_stages.clear();
+        for (uint32_t i = 0; i < stages; ++i)
+        {
+            luteconv::Stats::Stage stage;
+            Get(stage.m_name);
+            Get(stage.m_depth);
+            Get(stage.m_wall);
+            Get(stage.m_cpu);
+            Get(stage.m_allocations);
+            Get(stage.m_allocatedBytes);
+            Get(stage.m_peakBytes);
+            stats.m_stages.push_back(stage);
+        }
+    }
+
+    bool Send(int fd) const
+    {
+        const uint32_t size = static_cast<uint32_t>(m_buffer.size());
+        return WriteAll(fd, &size, sizeof(size)) && WriteAll(fd, m_buffer.data(), m_buffer.size());
+    }
+
+    bool Receive(int fd)
+    {
+        uint32_t size{0};
+        if (!ReadAll(fd, &size, sizeof(size)))
+            return false;
+        m_buffer.resize(size);
+        m_pos = 0;
+        return ReadAll(fd, &m_buffer[0], size);
+    }
+
+private:
+    void Need(size_t size) const
+    {
+        if (m_buffer.size() - m_pos < size)
+            throw std::runtime_error(std::string("Error: Worker result truncated"));
+    }
+
+    std::string m_buffer;
+    size_t m_pos{0};
+};
+
+std::string TimedOut(double timeout)
+{
+    std::ostringstream ss;
+    ss << "Error: Timed out after " << timeout << " seconds";
+    return ss.str();
+}
+
+} // namespace
+
+namespace luteconv
+{
+
+WorkerPool::WorkerPool(int jobs, double timeout, const Work& work)
+: m_jobs{Parallel::Threads(jobs)}, m_timeout{timeout}, m_work{work}
+{
+}
+
+void WorkerPool::Add(const Options& options)
+{
+    m_jobList.push_back(Job{options});
+    m_jobList.back().m_cost = Scheduler::Cost(options);
+    m_jobList.back().m_cancel = std::make_unique<Cancel>();
+}
+
+void WorkerPool::Run(bool stats)
+{
+    TRACE_SPAN("WorkerPool::Run");
+    if (m_jobList.empty())
+        return;
+
+    // largest first, as Scheduler
+    std::vector<size_t> order(m_jobList.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs)
+        {
+            return m_jobList[lhs].m_cost > m_jobList[rhs].m_cost;
+        });
+
+    m_workers = std::vector<Worker>(std::min(m_jobList.size(), static_cast<size_t>(m_jobs)));
+    LOGGER << "WorkerPool " << m_jobList.size() << " jobs on " << m_workers.size() << " workers";
+
+    // a worker that dies is found by its closed pipe, not by a signal
+    struct sigaction ignore;
+    std::memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    struct sigaction savedPipe;
+    sigaction(SIGPIPE, &ignore, &savedPipe);
+
+    // the log writer thread is not forked, flush before forking
+    Logger::Flush();
+
+    size_t next{0};
+    int started{0};
+    int restarts{0};
+    std::string startError;
+    for (;;)
+    {
+        // hand out jobs to idle workers, starting any not running
+        for (size_t i = 0; i < m_workers.size() && next < order.size() && restarts <= maxRestarts; ++i)
+        {
+            Worker& worker = m_workers[i];
+            if (worker.m_job >= 0)
+                continue;
+            try
+            {
+                if (worker.m_pid < 0)
+                    Start(i, stats);
+            }
+            catch (const std::exception& e)
+            {
+                startError = e.what();
+                ++restarts;
+                continue;
+            }
+
+            if (!Send(worker, order[next]))
+            {
+                // died idle, not the job's fault, restarted on the next pass
+                LOGGER_WARNING << "WorkerPool worker " << worker.m_pid << " exited idle";
+                Stop(worker);
+                startError = "Error: Worker exited before its job was sent";
+                ++restarts;
+                continue;
+            }
+            restarts = 0;
+            m_jobList[order[next]].m_order = started++;
+            ++next;
+        }
+
+        // the workers can't be restarted, the files not sent fail
+        if (restarts > maxRestarts)
+        {
+            for (; next < order.size(); ++next)
+                m_jobList[order[next]].m_error = startError;
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<size_t> busy;
+        for (size_t i = 0; i < m_workers.size(); ++i)
+        {
+            if (m_workers[i].m_job >= 0)
+            {
+                fds.push_back(pollfd{m_workers[i].m_fromWorker, POLLIN, 0});
+                busy.push_back(i);
+            }
+        }
+        if (fds.empty())
+        {
+            if (next == order.size())
+                break;
+            continue;
+        }
+
+        if (poll(fds.data(), fds.size(), pollPeriod) < 0 && errno != EINTR)
+            throw std::runtime_error(std::string("Error: poll ") + std::strerror(errno));
+
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < fds.size(); ++i)
+        {
+            Worker& worker = m_workers[busy[i]];
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0)
+            {
+                if (!Receive(worker))
+                    Crashed(worker, "", false);
+            }
+            else if (m_timeout > 0.0 &&
+                std::chrono::duration<double>(now - worker.m_started).count() > m_timeout + killGrace)
+            {
+                kill(worker.m_pid, SIGKILL);
+                Crashed(worker, TimedOut(m_timeout), true);
+            }
+        }
+    }
+
+    for (auto & worker : m_workers)
+        Stop(worker);
+    sigaction(SIGPIPE, &savedPipe, nullptr);
+}
+
+const std::vector<WorkerPool::Job>& WorkerPool::Jobs() const
+{
+    return m_jobList;
+}
+
+void WorkerPool::Start(size_t worker, bool stats)
+{
+    int toWorker[2];
+    int fromWorker[2];
+    if (pipe(toWorker) != 0)
+        throw std::runtime_error(std::string("Error: pipe ") + std::strerror(errno));
+    if (pipe(fromWorker) != 0)
+    {
+        close(toWorker[0]);
+        close(toWorker[1]);
+        throw std::runtime_error(std::string("Error: pipe ") + std::strerror(errno));
+    }
+
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        for (const int fd : {toWorker[0], toWorker[1], fromWorker[0], fromWorker[1]})
+            close(fd);
+        throw std::runtime_error(std::string("Error: fork ") + std::strerror(errno));
+    }
+
+    if (pid == 0)
+    {
+        // the other workers' pipes are the supervisor's, their ends must close
+        // when the supervisor's do
+        for (const auto & other : m_workers)
+        {
+            if (other.m_pid >= 0)
+            {
+                close(other.m_toWorker);
+                close(other.m_fromWorker);
+            }
+        }
+        close(toWorker[1]);
+        close(fromWorker[0]);
+        Serve(toWorker[0], fromWorker[1], stats);
+    }
+
+    close(toWorker[0]);
+    close(fromWorker[1]);
+    m_workers[worker].m_pid = pid;
+    m_workers[worker].m_toWorker = toWorker[1];
+    m_workers[worker].m_fromWorker = fromWorker[0];
+    m_workers[worker].m_job = -1;
+    LOGGER_DEBUG << "WorkerPool started worker " << pid;
+}
+
+void WorkerPool::Stop(Worker& worker)
+{
+    if (worker.m_pid < 0)
+        return;
+
+    // a worker exits when its job pipe closes
+    close(worker.m_toWorker);
+    close(worker.m_fromWorker);
+    int status{0};
+    while (waitpid(worker.m_pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    worker = Worker();
+}
+
+bool WorkerPool::Send(Worker& worker, size_t job)
+{
+    const uint32_t index = static_cast<uint32_t>(job);
+    if (!WriteAll(worker.m_toWorker, &index, sizeof(index)))
+        return false;
+    worker.m_job = static_cast<int>(job);
+    worker.m_started = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool WorkerPool::Receive(Worker& worker)
+{
+    Message message;
+    if (!message.Receive(worker.m_fromWorker))
+        return false;
+
+    Job& job = m_jobList[static_cast<size_t>(worker.m_job)];
+    try
+    {
+        uint8_t timedOut{0};
+        uint8_t hasStats{0};
+        message.Get(timedOut);
+        message.Get(job.m_error);
+        message.Get(hasStats);
+        if (hasStats != 0)
+            message.GetStats(job.m_stats);
+        job.m_timedOut = timedOut != 0;
+    }
+    catch (const std::exception& e)
+    {
+        job.m_error = e.what();
+    }
+    worker.m_job = -1;
+    return true;
+}
+
+void WorkerPool::Crashed(Worker& worker, const std::string& error, bool timedOut)
+{
+    Job& job = m_jobList[static_cast<size_t>(worker.m_job)];
+    close(worker.m_toWorker);
+    close(worker.m_fromWorker);
+    int status{0};
+    while (waitpid(worker.m_pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+
+    job.m_timedOut = timedOut;
+    job.m_crashed = !timedOut;
+    job.m_error = error;
+    if (job.m_error.empty())
+    {
+        std::ostringstream ss;
+        if (WIFSIGNALED(status))
+            ss << "Error: Worker crashed, signal " << WTERMSIG(status);
+        else
+            ss << "Error: Worker exited, status " << WEXITSTATUS(status);
+        job.m_error = ss.str();
+    }
+    LOGGER_WARNING << "WorkerPool worker " << worker.m_pid << " " << job.m_options.m_srcFilename << ": " << job.m_error;
+
+    // restarted when next given a job
+    worker = Worker();
+}
+
+void WorkerPool::Serve(int fromSupervisor, int toSupervisor, bool stats)
+{
+    // the log writer thread is not forked, start the child's own
+    Logger::AfterFork();
+
+    uint32_t index{0};
+    while (ReadAll(fromSupervisor, &index, sizeof(index)))
+    {
+        Job& job = m_jobList.at(index);
+        Convert(job, stats);
+        
+        // written before the result, and before the next file can crash the worker
+        Logger::Flush();
+
+        Message message;
+        message.Put(static_cast<uint8_t>(job.m_timedOut));
+        message.Put(job.m_error);
+        message.Put(static_cast<uint8_t>(stats));
+        if (stats)
+            message.PutStats(job.m_stats);
+        if (!message.Send(toSupervisor))
+            break;
+    }
+
+    // skip the supervisor's atexit handlers and static destructors
+    _exit(0);
+}
+
+void WorkerPool::Convert(Job& job, bool stats)
+{
+    job.m_cancel->SetTimeout(m_timeout);
+    CancelScope cancelScope(job.m_cancel.get());
+    try
+    {
+        if (m_work)
+        {
+            m_work(job, stats);
+        }
+        else
+        {
+            Converter converter;
+            if (stats)
+                converter.Convert(job.m_options, job.m_stats);
+            else
+                converter.Convert(job.m_options);
+        }
+    }
+    catch (const Cancelled& e)
+    {
+        job.m_timedOut = e.m_timedOut;
+        job.m_error = e.m_timedOut ? TimedOut(m_timeout) : e.what();
+    }
+    catch (const std::exception& e)
+    {
+        job.m_error = e.what();
+    }
+}
+
+} // namespace luteconv
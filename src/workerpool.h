@@ -0,0 +1,109 @@
+#ifndef _WORKERPOOL_H_
+#define _WORKERPOOL_H_
+
+#include "options.h"
+#include "scheduler.h"
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace luteconv
+{
+
+/**
+ * Convert a batch of files in worker processes, see options --batch --isolate.
+ *
+ * The supervisor forks --jobs workers, which stay running and convert a file
+ * at a time, largest first as Scheduler, each job sent and its result
+ * returned over pipes.  A file that crashes its worker fails with the signal
+ * and the batch continues on a restarted worker.  A worker that passes the
+ * deadline of its file without stopping itself is killed.
+ *
+ * POSIX only.
+ */
+class WorkerPool
+{
+public:
+
+    using Job = Scheduler::Job;
+
+    /**
+     * Converts a job in a worker, replacing Converter for testing
+     *
+     * @param[in,out] job
+     * @param[in] stats true => collect statistics
+     */
+    using Work = std::function<void(Job& job, bool stats)>;
+
+    /**
+     * Constructor
+     *
+     * @param[in] jobs number of worker processes, 0 => one per hardware thread
+     * @param[in] timeout seconds per file, 0 => no limit
+     * @param[in] work conversion, empty => Converter
+     */
+    WorkerPool(int jobs, double timeout, const Work& work = Work());
+
+    /**
+     * Destructor
+     */
+    ~WorkerPool() = default;
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Add a file to convert, before Run
+     *
+     * @param[in] options
+     */
+    void Add(const Options& options);
+
+    /**
+     * Convert all the files, returns when all have converted or failed and
+     * the workers have exited
+     *
+     * @param[in] stats true => collect statistics of each file
+     */
+    void Run(bool stats);
+
+    /**
+     * The files, in the order added
+     *
+     * @return jobs
+     */
+    const std::vector<Job>& Jobs() const;
+
+private:
+    // A worker process, from the supervisor
+    struct Worker
+    {
+        pid_t m_pid{-1};                    // -1 => not running
+        int m_toWorker{-1};                 // jobs
+        int m_fromWorker{-1};               // results
+        int m_job{-1};                      // -1 => idle
+        std::chrono::steady_clock::time_point m_started;
+    };
+
+    void Start(size_t worker, bool stats);
+    void Stop(Worker& worker);
+    bool Send(Worker& worker, size_t job);
+    bool Receive(Worker& worker);
+    void Crashed(Worker& worker, const std::string& error, bool timedOut);
+    [[noreturn]] void Serve(int fromSupervisor, int toSupervisor, bool stats);
+    void Convert(Job& job, bool stats);
+
+    const int m_jobs;
+    const double m_timeout;
+    const Work m_work;
+    std::vector<Job> m_jobList;
+    std::vector<Worker> m_workers;
+};
+
+} // namespace luteconv
+
+#endif // _WORKERPOOL_H_
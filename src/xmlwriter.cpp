@@ -1,5 +1,9 @@
 #include "xmlwriter.h"
 
+#include <utility>
+
+#include "trace.h"
+
 namespace luteconv
 {
 
@@ -53,6 +57,19 @@ void XMLComment::Print(std::ostream& s, int level) const
     s << std::string(XMLWriter::indent * level, ' ') << "<!-- " << m_comment << " -->";
 }
 
+// class XMLFragment
+
+XMLFragment::XMLFragment(std::string text)
+: m_text{std::move(text)}
+{
+    
+}
+
+void XMLFragment::Print(std::ostream& s, int /*level*/) const
+{
+    s << m_text;
+}
+
 // class XMLElement
 
 XMLElement::XMLElement(const char* name)
@@ -204,6 +221,7 @@ std::string XMLWriter::Escape(const char* text)
 
 std::ostream& operator<<(std::ostream& s, const XMLWriter& xmlwriter)
 {
+    TRACE_SPAN("XMLWriter print");
     s << R"(<?xml version="1.0" standalone="no"?>)" << std::endl;
 
     if (!xmlwriter.m_doctype.empty())
@@ -162,6 +162,37 @@ private:
     std::string m_comment;
 };
 
+/**
+ * Pre-rendered XML, e.g. elements rendered concurrently.  Printed as is,
+ * so must be rendered at the indentation level at which it is printed.
+ */
+class XMLFragment: public XMLObject
+{
+public:
+    /**
+     * Constructor
+     * 
+     * @param[in] text - rendered XML, without a final line break
+     */
+    explicit XMLFragment(std::string text);
+    
+    /**
+     * Destructor
+     */
+    ~XMLFragment() = default;
+    
+    /**
+     * Print
+     * 
+     * @param[in] s - stream
+     * @param[in] level - indendation level, ignored
+     */
+    void Print(std::ostream& s, int level) const override;
+
+private:
+    std::string m_text;
+};
+
 /**
  * An element
  */
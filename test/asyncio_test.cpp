@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include <asyncio.h>
+#include <parserft3.h>
+
+#include <zlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Write a file, return its filename
+    std::string WriteFile(const std::string& name, const std::string& contents) const
+    {
+        const std::string filename = m_binaryDir + "/" + name;
+        std::ofstream dst(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        dst << contents;
+        return filename;
+    }
+
+    static std::string ReadFile(const std::string& filename)
+    {
+        std::ifstream src(filename.c_str(), std::ios::in | std::ios::binary);
+        std::ostringstream ss;
+        ss << src.rdbuf();
+        return ss.str();
+    }
+
+    static std::vector<char> ReadImage(const std::string& filename)
+    {
+        const std::string contents = ReadFile(filename);
+        return std::vector<char>(contents.cbegin(), contents.cend());
+    }
+
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Prefetch)
+{
+    using namespace luteconv;
+
+    std::vector<std::string> filenames;
+    for (int i = 0; i < 8; ++i)
+        filenames.push_back(WriteFile("asyncio_test" + std::to_string(i) + ".txt", std::string(1000 * i, 'a' + i)));
+    const std::string missing = m_binaryDir + "/asyncio_test_missing.txt";
+    filenames.push_back(missing);
+
+    // all read ahead, taken out of order
+    AsyncIO io(2, filenames.size(), 0);
+    io.Prefetch(filenames);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    std::vector<char> image;
+    for (const int i : {1, 0, 2, 7, 3, 4, 5, 6})
+    {
+        ASSERT_TRUE(io.Take(filenames[i], image)) << i;
+        EXPECT_EQ(std::string(1000 * i, 'a' + i), std::string(image.cbegin(), image.cend()));
+    }
+    EXPECT_FALSE(io.Take(missing, image));
+    EXPECT_FALSE(io.Take(filenames[0], image));
+    io.Finish();
+}
+
+TEST_F(LuteConvFixture, Window)
+{
+    using namespace luteconv;
+
+    std::vector<std::string> filenames;
+    for (int i = 0; i < 8; ++i)
+        filenames.push_back(WriteFile("asyncio_test" + std::to_string(i) + ".txt", std::string(1000 * i, 'a' + i)));
+
+    // a file is either read ahead, or not and left to the caller
+    AsyncIO io(2, 1, 0);
+    io.Prefetch(filenames);
+    std::vector<char> image;
+    for (int i = 7; i >= 0; --i)
+    {
+        if (io.Take(filenames[i], image))
+        {
+            EXPECT_EQ(std::string(1000 * i, 'a' + i), std::string(image.cbegin(), image.cend()));
+        }
+    }
+}
+
+TEST_F(LuteConvFixture, MaxBytes)
+{
+    using namespace luteconv;
+
+    const std::string filename = WriteFile("asyncio_test_big.txt", std::string(1001, 'x'));
+    AsyncIO io(1, 4, 1000);
+    io.Prefetch({filename});
+    std::vector<char> image;
+    EXPECT_FALSE(io.Take(filename, image));
+}
+
+TEST_F(LuteConvFixture, WriteBehind)
+{
+    using namespace luteconv;
+
+    const std::string filename = m_binaryDir + "/asyncio_test_write.txt";
+    const std::string unwritable = m_binaryDir + "/asyncio_test_no_such_dir/write.txt";
+    std::string error{"not called"};
+    std::string unwritableError;
+    {
+        AsyncIO io(2, 2, 0);
+        io.Write(filename, std::string(100000, 'w'), [&error](const std::string& e) { error = e; });
+        io.Write(unwritable, "w", [&unwritableError](const std::string& e) { unwritableError = e; });
+    }
+    EXPECT_EQ("", error);
+    EXPECT_EQ(std::string(100000, 'w'), ReadFile(filename));
+    EXPECT_EQ("Error: Can't write " + unwritable, unwritableError);
+}
+
+TEST_F(LuteConvFixture, WriteWindow)
+{
+    using namespace luteconv;
+
+    const std::string filename = m_binaryDir + "/asyncio_test_write.txt";
+    std::mutex mutex;
+    std::condition_variable released;
+    bool release{false};
+    std::atomic<int> written{0};
+    const auto done = [&](const std::string& /*error*/)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [&release]() { return release; });
+            ++written;
+        };
+
+    // the only I/O thread is held in the first write's done, the second is
+    // queued and fills the window, the third waits
+    AsyncIO io(1, 1, 0);
+    io.Write(filename, "1", done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    io.Write(filename, "2", done);
+    std::atomic<bool> queued{false};
+    std::thread writer([&io, &filename, &done, &queued]()
+        {
+            io.Write(filename, "3", done);
+            queued = true;
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_FALSE(queued);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    released.notify_all();
+    writer.join();
+    EXPECT_TRUE(queued);
+    io.Finish();
+    EXPECT_EQ(3, written);
+    EXPECT_EQ("3", ReadFile(filename));
+}
+
+TEST_F(LuteConvFixture, Gunzip)
+{
+    using namespace luteconv;
+
+    // as gunzipping the file
+    const std::string ft3 = m_sourceDir + "/examples/original/02_forlorne_hope_8C.ft3";
+    std::vector<uint8_t> expected;
+    ParserFt3::Gunzip(ft3, expected);
+    std::vector<uint8_t> actual;
+    ParserFt3::Gunzip(ft3, ReadImage(ft3), actual);
+    EXPECT_EQ(expected, actual);
+
+    // not gzipped
+    const std::string plain = WriteFile("asyncio_test_plain.ft3", "CPiece plain");
+    ParserFt3::Gunzip(plain, expected);
+    ParserFt3::Gunzip(plain, ReadImage(plain), actual);
+    EXPECT_EQ(expected, actual);
+    EXPECT_EQ(12U, actual.size());
+
+    // concatenated gzip members
+    const std::string members = m_binaryDir + "/asyncio_test_members.gz";
+    for (const char* mode : {"wb", "ab"})
+    {
+        gzFile file = gzopen(members.c_str(), mode);
+        const std::string text(100000, mode[0]);
+        gzwrite(file, text.data(), static_cast<unsigned int>(text.size()));
+        gzclose(file);
+    }
+    InputLimits limits;
+    limits.m_maxRatio = 0;
+    ParserFt3::Gunzip(members, expected, limits);
+    ParserFt3::Gunzip(members, ReadImage(members), actual, limits);
+    EXPECT_EQ(200000U, expected.size());
+    EXPECT_EQ(expected, actual);
+    EXPECT_THROW(ParserFt3::Gunzip(members, ReadImage(members), actual), std::runtime_error);
+
+    // truncated
+    std::vector<char> truncated = ReadImage(members);
+    truncated.resize(truncated.size() / 4);
+    EXPECT_THROW(ParserFt3::Gunzip(members, truncated, actual, limits), std::runtime_error);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,237 @@
+#include <benchmark/benchmark.h>
+#include <stats.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Times, in ns, and allocations of a previous run saved with --benchmark_out=file.json
+class Baseline
+{
+public:
+    explicit Baseline(const std::string& filename);
+
+    bool Find(const std::string& name, double& cpuTime) const;
+    bool FindAllocations(const std::string& name, double& allocsPerIter) const;
+
+private:
+    std::map<std::string, double> m_cpuTimes;
+    std::map<std::string, double> m_allocsPerIter;
+};
+
+Baseline::Baseline(const std::string& filename)
+{
+    if (filename.empty())
+        return;
+
+    std::ifstream s(filename);
+    if (!s.is_open())
+    {
+        std::cerr << "Error: Can't open " << filename << std::endl;
+        exit(1);
+    }
+    std::ostringstream ss;
+    ss << s.rdbuf();
+    const std::string json = ss.str();
+
+    // Just enough JSON to read the flat benchmark objects written by google benchmark
+    const auto stringValue = [&json](size_t begin, size_t end, const char* key, std::string& value)
+    {
+        const size_t pos = json.find(key, begin);
+        if (pos >= end)
+            return false;
+        const size_t first = json.find('"', pos + std::strlen(key)) + 1;
+        value = json.substr(first, json.find('"', first) - first);
+        return true;
+    };
+
+    const char* const unitNames[] = {"ns", "us", "ms", "s"};
+    const double unitScales[] = {1.0, 1e3, 1e6, 1e9};
+
+    size_t pos = json.find("\"benchmarks\"");
+    while (pos != std::string::npos)
+    {
+        const size_t begin = json.find('{', pos);
+        if (begin == std::string::npos)
+            break;
+        const size_t end = json.find('}', begin);
+        pos = end;
+
+        std::string name;
+        std::string timeUnit;
+        std::string runType;
+        const size_t cpuTime = json.find("\"cpu_time\":", begin);
+        if (!stringValue(begin, end, "\"name\":", name) || cpuTime >= end)
+            continue;
+        if (stringValue(begin, end, "\"run_type\":", runType) && runType != "iteration")
+            continue;
+
+        double scale{1.0};
+        if (stringValue(begin, end, "\"time_unit\":", timeUnit))
+        {
+            for (size_t i = 0; i < sizeof(unitNames) / sizeof(unitNames[0]); ++i)
+                if (timeUnit == unitNames[i])
+                    scale = unitScales[i];
+        }
+        m_cpuTimes[name] = std::strtod(json.c_str() + cpuTime + std::strlen("\"cpu_time\":"), nullptr) * scale;
+
+        const size_t allocsPerIter = json.find("\"allocs_per_iter\":", begin);
+        if (allocsPerIter < end)
+            m_allocsPerIter[name] = std::strtod(json.c_str() + allocsPerIter + std::strlen("\"allocs_per_iter\":"), nullptr);
+    }
+}
+
+bool Baseline::Find(const std::string& name, double& cpuTime) const
+{
+    const auto it = m_cpuTimes.find(name);
+    if (it == m_cpuTimes.end())
+        return false;
+    cpuTime = it->second;
+    return true;
+}
+
+bool Baseline::FindAllocations(const std::string& name, double& allocsPerIter) const
+{
+    const auto it = m_allocsPerIter.find(name);
+    if (it == m_allocsPerIter.end())
+        return false;
+    allocsPerIter = it->second;
+    return true;
+}
+
+// Allocations of a benchmark run, an accounting build also has the peak live bytes
+class AllocationManager: public benchmark::MemoryManager
+{
+public:
+    void Start() override
+    {
+        m_stats.Start("", "");
+    }
+
+    void Stop(Result* result) override
+    {
+        m_stats.Stop();
+        result->num_allocs = static_cast<int64_t>(m_stats.m_allocations);
+        result->total_allocated_bytes = static_cast<int64_t>(m_stats.m_allocatedBytes);
+        result->max_bytes_used = static_cast<int64_t>(m_stats.m_peakBytes);
+    }
+
+private:
+    luteconv::Stats m_stats;
+};
+
+// Console output followed by the change in CPU time from the baseline
+class BaselineReporter: public benchmark::ConsoleReporter
+{
+public:
+    BaselineReporter(const Baseline& baseline, double threshold)
+    : m_baseline{baseline}, m_threshold{threshold}
+    {
+    }
+
+    void ReportRuns(const std::vector<Run>& reports) override
+    {
+        ConsoleReporter::ReportRuns(reports);
+        for (const auto & run : reports)
+        {
+            double baseline{0.0};
+            if (run.run_type != Run::RT_Iteration || run.error_occurred || !m_baseline.Find(run.benchmark_name(), baseline) || baseline <= 0.0)
+                continue;
+
+            const double cpuTime = run.GetAdjustedCPUTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+            const double change = 100.0 * (cpuTime - baseline) / baseline;
+            const bool regression = change > m_threshold;
+            GetOutputStream() << "    baseline " << std::showpos << std::fixed << std::setprecision(1) << change
+                              << std::noshowpos << "%" << (regression ? " REGRESSION" : "") << std::endl;
+            if (regression)
+                m_regressions.push_back(run.benchmark_name());
+
+            ReportAllocations(run);
+        }
+    }
+
+    const std::vector<std::string>& Regressions() const
+    {
+        return m_regressions;
+    }
+
+private:
+    // More allocations than the baseline is a regression whatever the hardware
+    void ReportAllocations(const Run& run)
+    {
+        double baseline{0.0};
+        if (run.memory_result == nullptr || !m_baseline.FindAllocations(run.benchmark_name(), baseline))
+            return;
+
+        const double change = baseline > 0.0 ? 100.0 * (run.allocs_per_iter - baseline) / baseline : (run.allocs_per_iter > 0.0 ? 100.0 : 0.0);
+        const bool regression = change > m_threshold;
+        GetOutputStream() << "    allocs/iter " << std::fixed << std::setprecision(1) << run.allocs_per_iter
+                          << ", peak " << run.memory_result->max_bytes_used << " bytes, baseline " << std::showpos << change
+                          << std::noshowpos << "%" << (regression ? " REGRESSION" : "") << std::endl;
+        if (regression)
+            m_regressions.push_back(run.benchmark_name() + " allocations");
+    }
+
+    const Baseline& m_baseline;
+    const double m_threshold;
+    std::vector<std::string> m_regressions;
+};
+
+} // namespace
+
+/**
+ * luteconv_bench, google benchmark flags and
+ *   --baseline=<file.json> compare CPU times with a run saved by --benchmark_out=<file.json>
+ *   --baseline_threshold=<percent> slowdown reported as a regression, default 10
+ * An allocation accounting build, cmake -DALLOC_STATS=ON, also reports and compares allocations
+ *
+ * @retval 0 => OK
+ * @retval 1 => error or regression
+ */
+int main(int argc, char** argv)
+{
+    std::string baselineFilename;
+    double threshold{10.0};
+    int kept{1};
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg{argv[i]};
+        if (arg.rfind("--baseline=", 0) == 0)
+            baselineFilename = arg.substr(std::strlen("--baseline="));
+        else if (arg.rfind("--baseline_threshold=", 0) == 0)
+            threshold = std::strtod(arg.c_str() + std::strlen("--baseline_threshold="), nullptr);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+#ifdef LUTECONV_ALLOC_STATS
+    AllocationManager allocationManager;
+    benchmark::RegisterMemoryManager(&allocationManager);
+#endif
+
+    const Baseline baseline(baselineFilename);
+    BaselineReporter reporter(baseline, threshold);
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    if (!reporter.Regressions().empty())
+    {
+        std::cerr << reporter.Regressions().size() << " regressions against " << baselineFilename << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <chordcache.h>
+
+#include <string>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    // Render that counts calls
+    std::string Render(const std::string& text)
+    {
+        ++m_renders;
+        return text;
+    }
+    
+    int m_renders{0};
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, HitMiss)
+{
+    using namespace luteconv;
+    
+    std::vector<Note> notes(2);
+    notes[0].m_string = 1;
+    notes[0].m_fret = 2;
+    notes[1].m_string = 3;
+    notes[1].m_fret = 0;
+    
+    ChordTable chords;
+    Chord chord;
+    chord.m_noteType = NoteTypeEighth;
+    chord.m_shape = chords.Intern(notes);
+    
+    ChordCache cache;
+    EXPECT_EQ("a", cache.Get(chord, "", [&](){ return Render("a"); }));
+    EXPECT_EQ("a", cache.Get(chord, "", [&](){ return Render("b"); }));
+    EXPECT_EQ(1, m_renders);
+    
+    // same chord, different context
+    EXPECT_EQ("c", cache.Get(chord, "#", [&](){ return Render("c"); }));
+    EXPECT_EQ(2, m_renders);
+    
+    // each rendering relevant field is part of the key
+    Chord other{chord};
+    other.m_dotted = true;
+    EXPECT_EQ("d", cache.Get(other, "", [&](){ return Render("d"); }));
+    other = chord;
+    other.m_grid = GridStart;
+    EXPECT_EQ("e", cache.Get(other, "", [&](){ return Render("e"); }));
+    other = chord;
+    other.m_shape = chords.Intern({notes[0]});
+    EXPECT_EQ("f", cache.Get(other, "", [&](){ return Render("f"); }));
+    EXPECT_EQ(5, m_renders);
+    
+    EXPECT_EQ(1U, cache.Hits());
+    EXPECT_EQ(5U, cache.Misses());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
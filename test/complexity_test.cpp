@@ -0,0 +1,362 @@
+#include <gtest/gtest.h>
+#include <piecesynth.h>
+#include <genmei.h>
+#include <genmusicxml.h>
+#include <gentab.h>
+#include <gentabcode.h>
+#include <parserft3.h>
+#include <parsermei.h>
+#include <parsermusicxml.h>
+#include <parsertab.h>
+#include <parsertabcode.h>
+#include <rtf.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Each test times work at sizes N, 2N, 4N and 8N and fits the growth of the time
+// with size, time ~ size^slope.  Linear work has slope 1, quadratic 2; the limit
+// allows for timing noise.  N is doubled until the smallest size takes long enough
+// that noise is small next to it.  The timings need the machine to themselves, so
+// the test runs serially and is labelled "timing", ctest -LE timing skips it.
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Work of a given size, returns the work to time
+    using MakeWork = std::function<std::function<void()>(size_t)>;
+
+    // Expect work that grows no faster than n log n
+    static void ExpectLinear(const std::string& name, size_t n, const MakeWork& makeWork)
+    {
+        std::vector<double> sizes;
+        std::vector<double> times;
+        std::ostringstream ss;
+        while (Time(makeWork(n), 1) < minSeconds)
+            n *= 2;
+        for (size_t size = n; size <= 8 * n; size *= 2)
+        {
+            const std::function<void()> work = makeWork(size);
+            sizes.push_back(static_cast<double>(size));
+            times.push_back(Time(work, repeats));
+            ss << " " << size << ":" << times.back() * 1000.0 << "ms";
+        }
+        EXPECT_LT(Slope(sizes, times), maxSlope) << name << ss.str();
+    }
+
+    // Least squares slope of log(time) against log(size)
+    static double Slope(const std::vector<double>& sizes, const std::vector<double>& times)
+    {
+        double sumX{0.0};
+        double sumY{0.0};
+        double sumXX{0.0};
+        double sumXY{0.0};
+        for (size_t i = 0; i < sizes.size(); ++i)
+        {
+            const double x = std::log(sizes[i]);
+            const double y = std::log(std::max(times[i], 1e-9));
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+        const double count = static_cast<double>(sizes.size());
+        return (count * sumXY - sumX * sumY) / (count * sumXX - sumX * sumX);
+    }
+
+    // Fastest of runs, in seconds
+    static double Time(const std::function<void()>& work, int runs)
+    {
+        double best{0.0};
+        for (int run = 0; run < runs; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            work();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = run == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    // A synthetic piece, generated in format
+    static std::string Synthesize(luteconv::Format format, int bars, int chordsPerBar)
+    {
+        using namespace luteconv;
+
+        PieceSynth synth;
+        synth.m_bars = bars;
+        synth.m_chordsPerBar = chordsPerBar;
+        synth.m_courses = 10;
+        Piece piece;
+        synth.Build(piece);
+        std::ostringstream ss;
+        Generate(format, piece, ss);
+        return ss.str();
+    }
+
+    static void Generate(luteconv::Format format, const luteconv::Piece& piece, std::ostream& dst)
+    {
+        using namespace luteconv;
+
+        const Options options;
+        switch (format)
+        {
+        case FormatMei:
+            GenMei().Generate(options, piece, dst);
+            break;
+        case FormatMusicxml:
+            GenMusicXml().Generate(options, piece, dst);
+            break;
+        case FormatTab:
+            GenTab().Generate(options, piece, dst);
+            break;
+        case FormatTabCode:
+            GenTabCode().Generate(options, piece, dst);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Parse in memory, the xml parsers parse in place so work on a copy
+    static void Parse(luteconv::Format format, const std::string& image, luteconv::Piece& piece)
+    {
+        using namespace luteconv;
+
+        const Options options;
+        std::string scratch;
+        switch (format)
+        {
+        case FormatMei:
+            scratch = image;
+            ParserMei().Parse("complexity_test.mei", scratch.data(), scratch.size(), options, piece);
+            break;
+        case FormatMusicxml:
+            scratch = image;
+            ParserMusicXml().Parse("complexity_test.musicxml", scratch.data(), scratch.size(), options, piece);
+            break;
+        case FormatTab:
+            ParserTab().Parse(std::string_view(image), options, piece);
+            break;
+        case FormatTabCode:
+            ParserTabCode().Parse(std::string_view(image), options, piece);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // The example ft3 split into its header, up to and including "CBar", and body
+    void LoadFt3(std::vector<uint8_t>& header, std::vector<uint8_t>& body) const
+    {
+        std::vector<uint8_t> ft3Image;
+        luteconv::ParserFt3::Gunzip(m_sourceDir + "/examples/original/02_forlorne_hope_8C.ft3", ft3Image);
+        const std::string cbar{"CBar"};
+        const auto bodyBegin = std::search(ft3Image.cbegin(), ft3Image.cend(), cbar.cbegin(), cbar.cend()) + cbar.size();
+        header.assign(ft3Image.cbegin(), bodyBegin);
+        body.assign(bodyBegin, ft3Image.cend());
+    }
+
+    const std::vector<std::pair<std::string, luteconv::Format>> m_formats{{"tab", luteconv::FormatTab},
+        {"tc", luteconv::FormatTabCode}, {"musicxml", luteconv::FormatMusicxml}, {"mei", luteconv::FormatMei}};
+    static constexpr double maxSlope{1.6};
+    static constexpr double minSeconds{0.1};
+    static constexpr int repeats{3};
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Parse)
+{
+    using namespace luteconv;
+
+    for (const auto & named : m_formats)
+    {
+        const Format format = named.second;
+        ExpectLinear("parse bars " + named.first, 500, [format](size_t size)
+        {
+            const std::string image = Synthesize(format, static_cast<int>(size), 4);
+            return [format, image]()
+            {
+                Piece piece;
+                Parse(format, image, piece);
+            };
+        });
+    }
+}
+
+TEST_F(LuteConvFixture, Generate)
+{
+    using namespace luteconv;
+
+    for (const auto & named : m_formats)
+    {
+        const Format format = named.second;
+        ExpectLinear("generate bars " + named.first, 500, [format](size_t size)
+        {
+            PieceSynth synth;
+            synth.m_bars = static_cast<int>(size);
+            synth.m_courses = 10;
+            auto piece = std::make_shared<Piece>();
+            synth.Build(*piece);
+            return [format, piece]()
+            {
+                std::ostringstream ss;
+                Generate(format, *piece, ss);
+            };
+        });
+    }
+}
+
+// All the chords in one bar, per chord work must not depend on the chord's position
+TEST_F(LuteConvFixture, LongBar)
+{
+    using namespace luteconv;
+
+    for (const auto & named : m_formats)
+    {
+        const Format format = named.second;
+        ExpectLinear("generate long bar " + named.first, 2000, [format](size_t size)
+        {
+            PieceSynth synth;
+            synth.m_bars = 1;
+            synth.m_chordsPerBar = static_cast<int>(size);
+            auto piece = std::make_shared<Piece>();
+            synth.Build(*piece);
+            return [format, piece]()
+            {
+                std::ostringstream ss;
+                Generate(format, *piece, ss);
+            };
+        });
+
+        ExpectLinear("parse long bar " + named.first, 2000, [format](size_t size)
+        {
+            const std::string image = Synthesize(format, 1, static_cast<int>(size));
+            return [format, image]()
+            {
+                Piece piece;
+                Parse(format, image, piece);
+            };
+        });
+    }
+}
+
+TEST_F(LuteConvFixture, Ft3)
+{
+    using namespace luteconv;
+
+    std::vector<uint8_t> header;
+    std::vector<uint8_t> body;
+    LoadFt3(header, body);
+
+    // the example's bars repeated
+    ExpectLinear("parse ft3 bars", 50, [&header, &body](size_t size)
+    {
+        std::vector<uint8_t> ft3Image{header};
+        for (size_t i = 0; i < size; ++i)
+        {
+            ft3Image.insert(ft3Image.end(), body.cbegin(), body.cend());
+            ft3Image.insert(ft3Image.end(), {0x03, 0x80});
+        }
+        return [ft3Image]()
+        {
+            Piece piece;
+            ParserFt3().Parse(ft3Image, Options(), piece);
+        };
+    });
+
+    // a bar with a long run of bytes that are not notes
+    ExpectLinear("parse ft3 no notes", 1 << 20, [&header](size_t size)
+    {
+        std::vector<uint8_t> ft3Image{header};
+        ft3Image.resize(ft3Image.size() + 32 + size, 0x01);
+        return [ft3Image]()
+        {
+            Piece piece;
+            ParserFt3().Parse(ft3Image, Options(), piece);
+        };
+    });
+}
+
+TEST_F(LuteConvFixture, Gunzip)
+{
+    using namespace luteconv;
+
+    const std::string filename = m_binaryDir + "/complexity_test.gz";
+    ExpectLinear("gunzip", 1 << 21, [&filename](size_t size)
+    {
+        static const std::string tabcode = Synthesize(FormatTabCode, 2000, 4);
+        std::string text;
+        while (text.size() < size)
+            text += tabcode;
+        text.resize(size);
+        gzFile file = gzopen(filename.c_str(), "wb");
+        gzwrite(file, text.data(), static_cast<unsigned int>(text.size()));
+        gzclose(file);
+        return [filename, size]()
+        {
+            std::vector<uint8_t> image;
+            ParserFt3::Gunzip(filename, image);
+            ASSERT_EQ(size, image.size());
+        };
+    });
+}
+
+TEST_F(LuteConvFixture, Rtf)
+{
+    using namespace luteconv;
+
+    const std::vector<std::pair<std::string, std::string>> patterns{
+        {"text", "Lachrimae "},
+        {"control words", "\\f0\\fs22"},
+        {"groups", "{"},
+        {"destinations", "{\\fonttbl "},
+        {"hex escapes", "\\'e9\\'"},
+        {"unicode", "\\u8216?"},
+    };
+
+    for (const auto & pattern : patterns)
+    {
+        ExpectLinear("rtf " + pattern.first, 1 << 18, [&pattern](size_t size)
+        {
+            std::string rtf{"{\\rtf1\\ansi "};
+            while (rtf.size() < size)
+                rtf += pattern.second;
+            rtf += "}";
+            return [rtf]()
+            {
+                const std::string text = Rtf::ExtractText(rtf.data(), rtf.size());
+                ASSERT_LE(text.size(), rtf.size());
+            };
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,404 @@
+#include <benchmark/benchmark.h>
+#include <converter.h>
+#include <genmei.h>
+#include <genmusicxml.h>
+#include <genmxl.h>
+#include <gentab.h>
+#include <gentabcode.h>
+#include <parserft3.h>
+#include <parserjtxml.h>
+#include <parsermei.h>
+#include <parsermusicxml.h>
+#include <parsertab.h>
+#include <parsertabcode.h>
+#include <unzipper.h>
+#include <xmlwriter.h>
+
+#include <sys/stat.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace luteconv;
+
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+const std::string sourceDir{XSTRINGIFY(SOURCE_DIR)};
+const std::string binaryDir{XSTRINGIFY(BINARY_DIR)};
+#undef STRINGIFY
+#undef XSTRINGIFY
+
+// examples/original, one file per source format
+const std::vector<std::string> examples{
+    "02_forlorne_hope_8C.ft3",
+    "2674.tc",
+    "F_Cutting_galliard.mxl",
+    "Kapsberger-Gagliarda5a.tab",
+    "Trumbull_18.jtz",
+    "da_crema-1546_10-no_6.mei",
+};
+
+// destination formats by file type
+const std::vector<std::string> dstTypes{"tab", "tc", "musicxml", "mei", "mxl"};
+
+// An uncompressed source held in memory
+struct Source
+{
+    Format m_format{FormatUnknown};
+    std::string m_image;
+    std::vector<uint8_t> m_ft3Image;
+    size_t m_bars{0};
+};
+
+std::string Original(const std::string& filename)
+{
+    return sourceDir + "/examples/original/" + filename;
+}
+
+std::string ReadFile(const std::string& filename)
+{
+    std::ifstream s(filename, std::ifstream::binary);
+    std::ostringstream ss;
+    ss << s.rdbuf();
+    return ss.str();
+}
+
+// Options for filename, formats from the file types
+Options MakeOptions(const std::string& srcFilename, const std::string& dstFilename)
+{
+    Options options;
+    options.m_srcFilename = srcFilename;
+    options.m_dstFilename = dstFilename;
+    options.SetFormatFilename();
+    return options;
+}
+
+// Parse an in memory source, the xml parsers parse in place so work on a copy
+void Parse(const Source& source, const Options& options, std::string& scratch, Piece& piece)
+{
+    switch (source.m_format)
+    {
+    case FormatFt3:
+        ParserFt3().Parse(source.m_ft3Image, options, piece);
+        break;
+    case FormatJtxml:
+        scratch = source.m_image;
+        ParserJtxml().Parse(options.m_srcFilename, scratch.data(), scratch.size(), options, piece);
+        break;
+    case FormatMei:
+        scratch = source.m_image;
+        ParserMei().Parse(options.m_srcFilename, scratch.data(), scratch.size(), options, piece);
+        break;
+    case FormatMusicxml:
+        scratch = source.m_image;
+        ParserMusicXml().Parse(options.m_srcFilename, scratch.data(), scratch.size(), options, piece);
+        break;
+    case FormatTab:
+        ParserTab().Parse(std::string_view(source.m_image), options, piece);
+        break;
+    case FormatTabCode:
+        ParserTabCode().Parse(std::string_view(source.m_image), options, piece);
+        break;
+    default:
+        break;
+    }
+}
+
+// Generate into memory
+void Generate(Format format, const Options& options, const Piece& piece, std::ostream& dst)
+{
+    switch (format)
+    {
+    case FormatMei:
+        GenMei().Generate(options, piece, dst);
+        break;
+    case FormatMusicxml:
+        GenMusicXml().Generate(options, piece, dst);
+        break;
+    case FormatTab:
+        GenTab().Generate(options, piece, dst);
+        break;
+    case FormatTabCode:
+        GenTabCode().Generate(options, piece, dst);
+        break;
+    default:
+        break;
+    }
+}
+
+// Load an example, unzipped, once
+const Source& LoadExample(const std::string& filename)
+{
+    static std::map<std::string, Source> sources;
+    auto it = sources.find(filename);
+    if (it != sources.end())
+        return it->second;
+
+    const Options options = MakeOptions(Original(filename), "dummy.tab");
+    Source source;
+    source.m_format = options.m_srcFormat;
+    if (source.m_format == FormatFt3)
+    {
+        ParserFt3::Gunzip(options.m_srcFilename, source.m_ft3Image);
+    }
+    else if (source.m_format == FormatMxl || source.m_format == FormatJtz)
+    {
+        std::vector<char> image;
+        std::string zipFilename;
+        Unzipper::Unzip(options.m_srcFilename, image, zipFilename);
+        source.m_image.assign(image.begin(), image.end());
+        source.m_format = source.m_format == FormatMxl ? FormatMusicxml : FormatJtxml;
+    }
+    else
+    {
+        source.m_image = ReadFile(options.m_srcFilename);
+    }
+
+    Piece piece;
+    std::string scratch;
+    Parse(source, options, scratch, piece);
+    source.m_bars = piece.m_bars.size();
+    return sources.emplace(filename, std::move(source)).first->second;
+}
+
+// 2674.tc repeated, then generated in format
+const Source& LoadScaled(Format format, int repeat)
+{
+    static std::map<std::pair<Format, int>, Source> sources;
+    auto it = sources.find({format, repeat});
+    if (it != sources.end())
+        return it->second;
+
+    const std::string tc = ReadFile(Original("2674.tc"));
+    std::string text;
+    for (int i = 0; i < repeat; ++i)
+        text += tc;
+
+    Options options;
+    Piece piece;
+    ParserTabCode().Parse(std::string_view(text), options, piece);
+
+    Source source;
+    source.m_format = format;
+    source.m_bars = piece.m_bars.size();
+    if (format == FormatTabCode)
+    {
+        source.m_image = std::move(text);
+    }
+    else
+    {
+        std::ostringstream ss;
+        Generate(format, options, piece, ss);
+        source.m_image = ss.str();
+    }
+    return sources.emplace(std::make_pair(format, repeat), std::move(source)).first->second;
+}
+
+void SetThroughput(benchmark::State& state, size_t bytes, size_t bars)
+{
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["bars"] = benchmark::Counter(static_cast<double>(bars), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_Parse(benchmark::State& state, const std::string& filename)
+{
+    const Source& source = LoadExample(filename);
+    const Options options = MakeOptions(Original(filename), "dummy.tab");
+    std::string scratch;
+    for (auto _ : state)
+    {
+        Piece piece;
+        Parse(source, options, scratch, piece);
+        benchmark::DoNotOptimize(piece.m_bars.data());
+    }
+    SetThroughput(state, source.m_format == FormatFt3 ? source.m_ft3Image.size() : source.m_image.size(), source.m_bars);
+}
+
+void BM_Generate(benchmark::State& state, const std::string& filename, const std::string& dstType)
+{
+    const Source& source = LoadExample(filename);
+    const Options options = MakeOptions(Original(filename), binaryDir + "/luteconv_bench." + dstType);
+    std::string scratch;
+    Piece piece;
+    Parse(source, options, scratch, piece);
+
+    size_t bytes{0};
+    for (auto _ : state)
+    {
+        if (options.m_dstFormat == FormatMxl)
+        {
+            GenMxl().Generate(options, piece);
+        }
+        else
+        {
+            std::ostringstream ss;
+            Generate(options.m_dstFormat, options, piece, ss);
+            bytes = ss.tellp();
+        }
+    }
+    SetThroughput(state, bytes, source.m_bars);
+}
+
+void BM_ParseScaled(benchmark::State& state, Format format)
+{
+    const Source& source = LoadScaled(format, static_cast<int>(state.range(0)));
+    Options options;
+    std::string scratch;
+    for (auto _ : state)
+    {
+        Piece piece;
+        Parse(source, options, scratch, piece);
+        benchmark::DoNotOptimize(piece.m_bars.data());
+    }
+    SetThroughput(state, source.m_image.size(), source.m_bars);
+}
+
+void BM_GenerateScaled(benchmark::State& state, Format format)
+{
+    const Source& source = LoadScaled(FormatTabCode, static_cast<int>(state.range(0)));
+    Options options;
+    std::string scratch;
+    Piece piece;
+    Parse(source, options, scratch, piece);
+
+    size_t bytes{0};
+    for (auto _ : state)
+    {
+        std::ostringstream ss;
+        Generate(format, options, piece, ss);
+        bytes = ss.tellp();
+    }
+    SetThroughput(state, bytes, source.m_bars);
+}
+
+// Complete conversion, file to file
+void BM_Convert(benchmark::State& state, const std::string& filename, const std::string& dstType)
+{
+    const Options options = MakeOptions(Original(filename), binaryDir + "/luteconv_bench." + dstType);
+    const size_t bytes = ReadFile(options.m_srcFilename).size();
+    for (auto _ : state)
+    {
+        Converter converter;
+        converter.Convert(options);
+    }
+    SetThroughput(state, bytes, LoadExample(filename).m_bars);
+}
+
+// The most used pairs, parsed and generated in memory
+void BM_Pair(benchmark::State& state, const Source& source, Format dstFormat)
+{
+    Options options;
+    options.m_dstFormat = dstFormat;
+    std::string scratch;
+    size_t bytes{0};
+    for (auto _ : state)
+    {
+        Piece piece;
+        Parse(source, options, scratch, piece);
+        std::ostringstream ss;
+        Generate(dstFormat, options, piece, ss);
+        bytes = ss.tellp();
+    }
+    SetThroughput(state, bytes, source.m_bars);
+}
+
+void BM_Gunzip(benchmark::State& state, const std::string& filename)
+{
+    std::vector<uint8_t> ft3Image;
+    for (auto _ : state)
+        ParserFt3::Gunzip(Original(filename), ft3Image);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * ft3Image.size()));
+}
+
+void BM_Unzip(benchmark::State& state, const std::string& filename)
+{
+    std::vector<char> image;
+    std::string zipFilename;
+    for (auto _ : state)
+        Unzipper::Unzip(Original(filename), image, zipFilename);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.size()));
+}
+
+// Print a MusicXML like tree of n measures
+void BM_XMLWriterPrint(benchmark::State& state)
+{
+    XMLWriter xmlwriter;
+    XMLElement* xmlscore = new XMLElement("score-partwise");
+    xmlwriter.SetRoot(xmlscore);
+    XMLElement* xmlpart = new XMLElement("part");
+    xmlpart->AddAttrib("id", "P1");
+    xmlscore->Add(xmlpart);
+    for (int i = 0; i < state.range(0); ++i)
+    {
+        XMLElement* xmlmeasure = new XMLElement("measure");
+        xmlmeasure->AddAttrib("number", i + 1);
+        xmlpart->Add(xmlmeasure);
+        for (int j = 0; j < 4; ++j)
+        {
+            XMLElement* xmlnote = new XMLElement("note");
+            xmlmeasure->Add(xmlnote);
+            xmlnote->Add(new XMLElement("duration", 1));
+            xmlnote->Add(new XMLElement("type", "quarter"));
+            XMLElement* xmltechnical = new XMLElement("technical");
+            xmlnote->Add(xmltechnical);
+            xmltechnical->Add(new XMLElement("string", j + 1));
+            xmltechnical->Add(new XMLElement("fret", j));
+        }
+    }
+
+    size_t bytes{0};
+    for (auto _ : state)
+    {
+        std::ostringstream ss;
+        ss << xmlwriter;
+        bytes = ss.tellp();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+BENCHMARK(BM_XMLWriterPrint)->RangeMultiplier(8)->Range(64, 32768);
+
+bool RegisterBenchmarks()
+{
+    const std::vector<std::pair<const char*, Format>> scaledFormats{
+        {"tab", FormatTab}, {"tc", FormatTabCode}, {"musicxml", FormatMusicxml}, {"mei", FormatMei}};
+
+    for (const auto & example : examples)
+        benchmark::RegisterBenchmark(("BM_Parse/" + example).c_str(), BM_Parse, example);
+
+    for (const auto & example : examples)
+        for (const auto & dstType : dstTypes)
+            benchmark::RegisterBenchmark(("BM_Generate/" + dstType + "/" + example).c_str(), BM_Generate, example, dstType);
+
+    // scaled by repeating 2674.tc
+    for (const auto & scaled : scaledFormats)
+    {
+        benchmark::RegisterBenchmark((std::string("BM_ParseScaled/") + scaled.first).c_str(), BM_ParseScaled, scaled.second)
+            ->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark((std::string("BM_GenerateScaled/") + scaled.first).c_str(), BM_GenerateScaled, scaled.second)
+            ->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond);
+    }
+
+    for (const auto & example : examples)
+        for (const auto & dstType : dstTypes)
+            benchmark::RegisterBenchmark(("BM_Convert/" + example + "/" + dstType).c_str(), BM_Convert, example, dstType);
+
+    benchmark::RegisterBenchmark("BM_Pair/tab_musicxml", BM_Pair, LoadScaled(FormatTab, 16), FormatMusicxml)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("BM_Pair/tc_mei", BM_Pair, LoadScaled(FormatTabCode, 16), FormatMei)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("BM_Pair/ft3_tab", BM_Pair, LoadExample("02_forlorne_hope_8C.ft3"), FormatTab);
+
+    benchmark::RegisterBenchmark("BM_Gunzip/02_forlorne_hope_8C.ft3", BM_Gunzip, "02_forlorne_hope_8C.ft3");
+    benchmark::RegisterBenchmark("BM_Unzip/F_Cutting_galliard.mxl", BM_Unzip, "F_Cutting_galliard.mxl");
+    benchmark::RegisterBenchmark("BM_Unzip/Trumbull_18.jtz", BM_Unzip, "Trumbull_18.jtz");
+    return true;
+}
+
+const bool registered = RegisterBenchmarks();
+
+} // namespace
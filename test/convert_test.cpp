@@ -1,10 +1,14 @@
 #include <gtest/gtest.h>
 #include <converter.h>
+#include <pieceinfo.h>
+#include <scheduler.h>
+#include <unzipper.h>
 
 #include <dirent.h>
 #include <sys/stat.h>
 #include <fstream>
 #include <regex>
+#include <sstream>
 
 class LuteConvFixture: public ::testing::Test
 {
@@ -22,11 +26,21 @@ public:
         std::cout << "SOURCE_DIRECTORY=" << m_sourceDir << std::endl;
     }
     
+    void ConvertAllTest(const std::string& dstSubdir, int jobs);
+
     void ConvertOneTest(const std::string& originalDir, const std::string& dstDir,
-            const std::string& convertedDir, const std::string& filename);
+            const std::string& convertedDir, const std::string& filename, int jobs);
 
     void Diff(const std::string& lhs, const std::string& rhs);
     
+    static std::string ReadFile(const std::string& filename)
+    {
+        std::ifstream src(filename.c_str(), std::ios::in | std::ios::binary);
+        std::ostringstream ss;
+        ss << src.rdbuf();
+        return ss.str();
+    }
+    
     std::string m_binaryDir;
     std::string m_sourceDir;
 };
@@ -37,10 +51,188 @@ TEST_F(LuteConvFixture, FixtureTest)
 }
 
 TEST_F(LuteConvFixture, ConvertTest)
+{
+    ConvertAllTest("/converter_test", 1);
+}
+
+TEST_F(LuteConvFixture, ParallelConvertTest)
+{
+    // multi-threaded conversion must give the same results
+    ConvertAllTest("/parallel_converter_test", 4);
+}
+
+TEST_F(LuteConvFixture, BatchConvertTest)
+{
+    // read ahead, converted in memory and written behind must give the same results
+    using namespace luteconv;
+    
+    const std::string originalDir = m_sourceDir + "/examples/original";
+    const std::string convertedDir = m_sourceDir + "/examples/converted";
+    const std::string dstDir = m_binaryDir + "/batch_converter_test";
+    
+    mkdir(dstDir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    
+    Scheduler scheduler(4, 0.0);
+    struct dirent* entry{nullptr};
+    DIR* dir = opendir(originalDir.c_str());
+    EXPECT_NE(nullptr, dir);
+    
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_type != DT_REG)
+            continue;
+        
+        for (auto filetype : {".mei", ".musicxml", ".tab", ".tc"})
+        {
+            Options options;
+            options.m_srcFilename = originalDir + "/" + entry->d_name;
+            options.m_dstFilename = dstDir + "/" + entry->d_name + filetype;
+            options.SetFormatFilename();
+            scheduler.Add(options);
+        }
+    }
+    closedir(dir);
+    
+    scheduler.Run(false);
+    for (const auto & job : scheduler.Jobs())
+    {
+        EXPECT_EQ("", job.m_error) << job.m_options.m_srcFilename;
+        const std::string filename = job.m_options.m_dstFilename.substr(dstDir.size());
+        Diff(convertedDir + filename, job.m_options.m_dstFilename);
+    }
+}
+
+TEST_F(LuteConvFixture, InfoTest)
+{
+    // the skimmed metadata is that of the full conversion
+    using namespace luteconv;
+    
+    const std::string originalDir = m_sourceDir + "/examples/original";
+    DIR* dir = opendir(originalDir.c_str());
+    ASSERT_NE(nullptr, dir);
+    for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        const std::string filename = entry->d_name;
+        if (filename[0] == '.')
+            continue;
+        
+        Options options;
+        options.m_srcFilename = originalDir + "/" + filename;
+        options.m_dstFilename = m_binaryDir + "/info_test.tab";
+        options.SetFormatFilename();
+        
+        PieceInfo info;
+        Converter converter;
+        converter.Info(options, info);
+        Stats stats;
+        converter.Convert(options, stats);
+        EXPECT_EQ(options.m_srcFilename, info.m_srcFilename);
+        EXPECT_EQ(stats.m_bars, info.m_bars) << filename;
+        EXPECT_LE(6U, info.m_tuning.size()) << filename;
+    }
+    closedir(dir);
+    
+    // tuning from the highest course used
+    Options options;
+    options.m_srcFilename = originalDir + "/02_forlorne_hope_8C.ft3";
+    options.SetFormatFilename();
+    PieceInfo info;
+    Converter().Info(options, info);
+    EXPECT_EQ("2. Forlorn hope fancy", info.m_title);
+    EXPECT_EQ("John Dowland", info.m_composer);
+    EXPECT_EQ("G4D4A3F3C3G2F2D2", Pitch::GetTuning(info.m_tuning));
+    EXPECT_EQ(TimeSyCut, info.m_timeSig.m_timeSymbol);
+    EXPECT_EQ(36U, info.m_bars);
+    
+    std::ostringstream json;
+    PieceInfo::Print(json, {info}, true);
+    EXPECT_NE(std::string::npos, json.str().find("\"tuning\": \"G4 D4 A3 F3 C3 G2 F2 D2\""));
+    
+    Options missing;
+    missing.m_srcFilename = m_binaryDir + "/info_test_missing.tab";
+    missing.SetFormatFilename();
+    EXPECT_THROW(Converter().Info(missing, info), std::runtime_error);
+}
+
+TEST_F(LuteConvFixture, PassthroughTest)
+{
+    // container only conversions copy the contents byte for byte
+    using namespace luteconv;
+    
+    const std::string originalDir = m_sourceDir + "/examples/original";
+    for (const std::string filename : {"F_Cutting_galliard.mxl", "Trumbull_18.jtz"})
+    {
+        Options options;
+        options.m_srcFilename = originalDir + "/" + filename;
+        options.m_dstFilename = m_binaryDir + "/passthrough_test" + (filename.back() == 'l' ? ".musicxml" : ".jtxml");
+        options.SetFormatFilename();
+        EXPECT_TRUE(options.Passthrough());
+        Converter converter;
+        converter.Convert(options);
+        
+        std::vector<char> image;
+        std::string zipFilename;
+        Unzipper::Unzip(options.m_srcFilename, image, zipFilename);
+        EXPECT_EQ(std::string(image.cbegin(), image.cend()), ReadFile(options.m_dstFilename)) << filename;
+        
+        // a read ahead archive is unzipped from memory, not read again
+        const std::string zipImage = ReadFile(options.m_srcFilename);
+        std::vector<char> srcImage(zipImage.cbegin(), zipImage.cend());
+        std::string dstImage;
+        options.m_srcFilename = m_binaryDir + "/passthrough_test_missing" + filename.substr(filename.find('.'));
+        EXPECT_TRUE(converter.Convert(options, srcImage, dstImage, nullptr));
+        EXPECT_EQ(std::string(image.cbegin(), image.cend()), dstImage) << filename;
+        
+        options.m_dstFormat = FormatTab;
+        ASSERT_FALSE(options.Passthrough());
+        EXPECT_TRUE(converter.Convert(options, srcImage, dstImage, nullptr));
+        EXPECT_NE(std::string::npos, dstImage.find("e\n")) << filename;
+    }
+    
+    // the parse and generate path, an explicit destination tab type turns off the copy
+    Options parse;
+    parse.m_srcFilename = originalDir + "/F_Cutting_galliard.mxl";
+    parse.m_dstFilename = m_binaryDir + "/passthrough_test_parsed.musicxml";
+    parse.m_dstTabTypeSet = true;
+    parse.SetFormatFilename();
+    ASSERT_FALSE(parse.Passthrough());
+    Converter().Convert(parse);
+    Diff(m_sourceDir + "/examples/converted/parsed/F_Cutting_galliard.mxl.musicxml", parse.m_dstFilename);
+    
+    // musicxml => mxl => musicxml
+    const std::string musicxml = m_binaryDir + "/passthrough_test.musicxml";
+    Options zip;
+    zip.m_srcFilename = musicxml;
+    zip.m_dstFilename = m_binaryDir + "/passthrough_test.mxl";
+    zip.SetFormatFilename();
+    EXPECT_TRUE(zip.Passthrough());
+    Converter().Convert(zip);
+    
+    Options unzip;
+    unzip.m_srcFilename = zip.m_dstFilename;
+    unzip.m_dstFilename = m_binaryDir + "/passthrough_test2.musicxml";
+    unzip.SetFormatFilename();
+    Converter().Convert(unzip);
+    EXPECT_EQ(ReadFile(musicxml), ReadFile(unzip.m_dstFilename));
+    
+    // options that change the content parse and generate
+    unzip.m_flags = 1;
+    EXPECT_FALSE(unzip.Passthrough());
+    Converter().Convert(unzip);
+    EXPECT_NE(ReadFile(musicxml), ReadFile(unzip.m_dstFilename));
+    unzip.m_flags = 0;
+    unzip.m_dstTabTypeSet = true;
+    EXPECT_FALSE(unzip.Passthrough());
+    unzip.m_dstTabTypeSet = false;
+    unzip.m_tuning.resize(1);
+    EXPECT_FALSE(unzip.Passthrough());
+}
+
+void LuteConvFixture::ConvertAllTest(const std::string& dstSubdir, int jobs)
 {
     const std::string originalDir = m_sourceDir + "/examples/original";
     const std::string convertedDir = m_sourceDir + "/examples/converted";
-    const std::string dstDir = m_binaryDir + "/converter_test";
+    const std::string dstDir = m_binaryDir + dstSubdir;
     
     mkdir(dstDir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
     
@@ -51,13 +243,13 @@ TEST_F(LuteConvFixture, ConvertTest)
     while ((entry = readdir(dir)) != nullptr)
     {
         if (entry->d_type == DT_REG)
-            ConvertOneTest(originalDir, dstDir, convertedDir, entry->d_name);
+            ConvertOneTest(originalDir, dstDir, convertedDir, entry->d_name, jobs);
     }
     closedir(dir);
 }
 
 void LuteConvFixture::ConvertOneTest(const std::string& originalDir, const std::string& dstDir,
-        const std::string& convertedDir, const std::string& filename)
+        const std::string& convertedDir, const std::string& filename, int jobs)
 {
     using namespace luteconv;
     
@@ -66,6 +258,7 @@ void LuteConvFixture::ConvertOneTest(const std::string& originalDir, const std::
         Options options;
         options.m_srcFilename = originalDir + "/" + filename;
         options.m_dstFilename = dstDir + "/" + filename + filetype;
+        options.m_jobs = jobs;
         options.SetFormatFilename();
         
         // convert original into dstDir
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <lexer.h>
+#include <parsertab.h>
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    // lines as std::getline would give them
+    static std::vector<std::string> GetlineLines(const std::string& text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream src(text);
+        while (!src.eof())
+        {
+            std::string line;
+            getline(src, line);
+            lines.push_back(line);
+        }
+        return lines;
+    }
+    
+    static std::vector<std::string> LexerLines(const std::string& text)
+    {
+        std::vector<std::string> lines;
+        luteconv::LineLexer lexer{text};
+        std::string_view line;
+        while (lexer.Next(line))
+        {
+            lines.emplace_back(line);
+            EXPECT_EQ(static_cast<int>(lines.size()), lexer.LineNo());
+        }
+        return lines;
+    }
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+    
+}
+
+TEST_F(LuteConvFixture, SameAsGetline)
+{
+    for (const std::string text : {"", "\n", "b", "b\n", "b\n\n", "0 a\r\nb\r\n", "\n\nW a\nb\ne"})
+    {
+        EXPECT_EQ(GetlineLines(text), LexerLines(text));
+    }
+}
+
+TEST_F(LuteConvFixture, TrimRight)
+{
+    using luteconv::LineLexer;
+    EXPECT_EQ("", LineLexer::TrimRight(""));
+    EXPECT_EQ("", LineLexer::TrimRight(" \t\r"));
+    EXPECT_EQ("  a b", LineLexer::TrimRight("  a b \r"));
+}
+
+TEST_F(LuteConvFixture, Read)
+{
+    const std::string text{"{Title}\n0 a\nb\ne\n"};
+    std::istringstream src(text);
+    EXPECT_EQ(text, luteconv::LineLexer::Read(src));
+}
+
+TEST_F(LuteConvFixture, TabCodeTokens)
+{
+    using luteconv::TabCodeLexer;
+    
+    // comment spanning lines, comment adjacent to tabwords, CRLF, trailing white space
+    const std::string text{"{<rules>\n<tuning/>\n</rules>}\r\nQa1 b2{>}{^}\r\n|  \n\tM(C/){end"};
+    const std::vector<std::tuple<std::string, TabCodeLexer::TokenType, int>> expected{
+        {"{<rules>\n<tuning/>\n</rules>}", TabCodeLexer::TokenComment, 1},
+        {"Qa1", TabCodeLexer::TokenTabword, 4},
+        {"b2", TabCodeLexer::TokenTabword, 4},
+        {"{>}", TabCodeLexer::TokenComment, 4},
+        {"{^}", TabCodeLexer::TokenComment, 4},
+        {"|", TabCodeLexer::TokenTabword, 5},
+        {"M(C/)", TabCodeLexer::TokenTabword, 6},
+        {"{end", TabCodeLexer::TokenComment, 6},
+    };
+    
+    TabCodeLexer lexer{text};
+    std::string_view token;
+    TabCodeLexer::TokenType type{TabCodeLexer::TokenTabword};
+    std::vector<std::tuple<std::string, TabCodeLexer::TokenType, int>> actual;
+    while (lexer.Next(token, type))
+        actual.emplace_back(std::string(token), type, lexer.LineNo());
+    
+    EXPECT_EQ(expected, actual);
+}
+
+// Tab lines that end part way through a chord, each the last line of a buffer
+// with nothing after it, so reading past the end of the line is caught by ASan
+TEST_F(LuteConvFixture, TabLineEnds)
+{
+    using namespace luteconv;
+
+    for (const std::string text : {"x", "#", "1#", "1      \\", "1      /", "1 \\1\"", "1 N1", "1 !", "1 \\", "1 a&"})
+    {
+        std::unique_ptr<char[]> buffer{new char[text.size()]};
+        std::memcpy(buffer.get(), text.data(), text.size());
+        Piece piece;
+        ParserTab().Parse(std::string_view(buffer.get(), text.size()), Options(), piece);
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <converter.h>
+#include <parserft3.h>
+#include <unzipper.h>
+
+#include <zlib.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Write a gzip file of size zeros
+    std::string Zeros(size_t size) const
+    {
+        const std::string filename = m_binaryDir + "/limits_test.gz";
+        const std::vector<char> zeros(size, 0);
+        gzFile file = gzopen(filename.c_str(), "wb9");
+        gzwrite(file, zeros.data(), static_cast<unsigned int>(zeros.size()));
+        gzclose(file);
+        return filename;
+    }
+
+    // Convert, return the error message, empty if none
+    std::string Convert(const std::string& src, const luteconv::InputLimits& limits) const
+    {
+        luteconv::Options options;
+        options.m_srcFilename = m_sourceDir + "/examples/original/" + src;
+        options.m_dstFilename = m_binaryDir + "/limits_test.tc";
+        options.SetFormatFilename();
+        options.m_limits = limits;
+        try
+        {
+            luteconv::Converter converter;
+            converter.Convert(options);
+        }
+        catch (const std::exception& e)
+        {
+            return e.what();
+        }
+        return "";
+    }
+
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Ratio)
+{
+    using namespace luteconv;
+
+    const std::string filename = Zeros(16 * 1024 * 1024);
+    std::vector<uint8_t> image;
+    try
+    {
+        ParserFt3::Gunzip(filename, image, InputLimits());
+        FAIL() << "expected an exception";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("compression ratio is more than 200")) << e.what();
+    }
+
+    // small files may have a high ratio
+    ParserFt3::Gunzip(Zeros(1024), image, InputLimits());
+    EXPECT_EQ(1024U, image.size());
+
+    InputLimits unlimited;
+    unlimited.m_maxRatio = 0;
+    ParserFt3::Gunzip(Zeros(16 * 1024 * 1024), image, unlimited);
+    EXPECT_EQ(16U * 1024 * 1024, image.size());
+}
+
+TEST_F(LuteConvFixture, Inflated)
+{
+    using namespace luteconv;
+
+    InputLimits limits;
+    limits.m_maxRatio = 0;
+    limits.m_maxInflatedBytes = 100000;
+    std::vector<uint8_t> image;
+    EXPECT_THROW(ParserFt3::Gunzip(Zeros(100001), image, limits), std::runtime_error);
+    ParserFt3::Gunzip(Zeros(100000), image, limits);
+    EXPECT_EQ(100000U, image.size());
+
+    limits.m_maxInflatedBytes = 1000;
+    std::vector<char> zipImage;
+    std::string zipFilename;
+    EXPECT_THROW(Unzipper::Unzip(m_sourceDir + "/examples/original/F_Cutting_galliard.mxl", zipImage, zipFilename,
+            limits), std::runtime_error);
+}
+
+TEST_F(LuteConvFixture, Entries)
+{
+    using namespace luteconv;
+
+    InputLimits limits;
+    EXPECT_EQ("", Convert("F_Cutting_galliard.mxl", limits));
+    limits.m_maxZipEntries = 1;
+    EXPECT_NE(std::string::npos, Convert("F_Cutting_galliard.mxl", limits).find("has more than 1 zip entries"));
+}
+
+TEST_F(LuteConvFixture, Bars)
+{
+    using namespace luteconv;
+
+    InputLimits limits;
+    limits.m_maxBars = 5;
+    for (const char* src : {"Kapsberger-Gagliarda5a.tab", "2674.tc", "02_forlorne_hope_8C.ft3",
+            "F_Cutting_galliard.mxl", "Trumbull_18.jtz", "da_crema-1546_10-no_6.mei"})
+    {
+        EXPECT_EQ("Error: More than 5 bars", Convert(src, limits)) << src;
+    }
+}
+
+TEST_F(LuteConvFixture, Notes)
+{
+    using namespace luteconv;
+
+    InputLimits limits;
+    limits.m_maxNotes = 10;
+    EXPECT_EQ("Error: More than 10 notes", Convert("Kapsberger-Gagliarda5a.tab", limits));
+}
+
+TEST_F(LuteConvFixture, Input)
+{
+    using namespace luteconv;
+
+    InputLimits limits;
+    limits.m_maxInputBytes = 100;
+    EXPECT_NE(std::string::npos, Convert("2674.tc", limits).find("is larger than 100 bytes"));
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <logger.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_logFile = std::string(XSTRINGIFY(BINARY_DIR)) + "/logger_test.log";
+#undef STRINGIFY
+#undef XSTRINGIFY
+        std::remove(m_logFile.c_str());
+        luteconv::Logger::SetFile(m_logFile);
+    }
+
+    void TearDown() override
+    {
+        luteconv::Logger::SetFile("");
+        std::remove(m_logFile.c_str());
+    }
+
+    // Flush the log and read its records
+    std::vector<std::string> Records()
+    {
+        luteconv::Logger::Flush();
+        std::vector<std::string> records;
+        std::ifstream s(m_logFile);
+        std::string line;
+        while (std::getline(s, line))
+            records.push_back(line);
+        return records;
+    }
+
+    std::string m_logFile;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Level)
+{
+    using namespace luteconv;
+
+    {
+        LoggerScope loggerScope(LogWarning, "");
+        LOGGER_WARNING << "one";
+        LOGGER << "two";
+        LOGGER_DEBUG << "three";
+    }
+    LOGGER_WARNING << "four";
+
+    const std::vector<std::string> records = Records();
+    ASSERT_EQ(1U, records.size());
+    EXPECT_NE(std::string::npos, records[0].find(" WARNING logger_test: one"));
+
+    EXPECT_EQ(LogDebug, Logger::GetLevel("debug"));
+    EXPECT_THROW(Logger::GetLevel("loud"), std::runtime_error);
+}
+
+TEST_F(LuteConvFixture, Filter)
+{
+    using namespace luteconv;
+
+    {
+        LoggerScope loggerScope(LogDebug, "parsertab,logger_test");
+        LOGGER << "one";
+    }
+    {
+        LoggerScope loggerScope(LogDebug, "parsertab");
+        LOGGER << "two";
+    }
+
+    const std::vector<std::string> records = Records();
+    ASSERT_EQ(1U, records.size());
+    EXPECT_NE(std::string::npos, records[0].find(" INFO logger_test: one"));
+}
+
+TEST_F(LuteConvFixture, Threads)
+{
+    using namespace luteconv;
+
+    // more records than the ring holds, from several threads
+    const int threads = 4;
+    const int perThread = 5000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t]()
+        {
+            LoggerScope loggerScope(LogInfo, "");
+            for (int i = 0; i < perThread; ++i)
+                LOGGER << t << " " << i;
+        });
+    }
+    for (auto & worker : workers)
+        worker.join();
+
+    const std::vector<std::string> records = Records();
+    ASSERT_EQ(static_cast<size_t>(threads * perThread), records.size());
+
+    // records from each thread are in order
+    std::vector<int> next(threads, 0);
+    for (const auto & record : records)
+    {
+        const size_t colon = record.find(": ");
+        ASSERT_NE(std::string::npos, colon);
+        const int t = std::stoi(record.substr(colon + 2));
+        const int i = std::stoi(record.substr(record.find(' ', colon + 2)));
+        ASSERT_EQ(next[t], i);
+        ++next[t];
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+#include <piecesynth.h>
+#include <genmei.h>
+#include <genmusicxml.h>
+#include <genmxl.h>
+#include <gentab.h>
+#include <gentabcode.h>
+
+#include <popl/include/popl.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+using namespace luteconv;
+
+// Write piece to filename, the format from the file type
+void Write(const Options& synthOptions, const std::string& filename, const Piece& piece)
+{
+    Options options{synthOptions};
+    options.m_dstFilename = filename;
+    options.m_dstFormat = FormatUnknown;
+    options.SetFormatFilename();
+
+    switch (options.m_dstFormat)
+    {
+    case FormatMei:
+        GenMei().Generate(options, piece);
+        break;
+    case FormatMusicxml:
+        GenMusicXml().Generate(options, piece);
+        break;
+    case FormatMxl:
+        GenMxl().Generate(options, piece);
+        break;
+    case FormatTab:
+        GenTab().Generate(options, piece);
+        break;
+    case FormatTabCode:
+        GenTabCode().Generate(options, piece);
+        break;
+    default:
+        throw std::runtime_error(std::string("Error: destination file format not supported: ") + filename);
+    }
+}
+
+} // namespace
+
+/**
+ * luteconv_synth, write a random piece to stem.tab, stem.tc, stem.musicxml, stem.mei and stem.mxl
+ *
+ * @param[in] argc number of arguments
+ * @param[in] argv arguments.
+ * @retval 0 => OK
+ * @retval 1 => error
+ */
+int main(int argc, char** argv)
+{
+    try
+    {
+        using namespace popl;
+
+        PieceSynth synth;
+        Options options;
+        std::string types;
+        OptionParser op("Allowed options");
+        auto helpOption = op.add<Switch>("h", "help", "Show help");
+        op.add<Value<uint64_t>>("s", "seed", "Set random seed", synth.m_seed, &synth.m_seed);
+        op.add<Value<int>>("b", "bars", "Set number of bars", synth.m_bars, &synth.m_bars);
+        op.add<Value<int>>("c", "chords", "Set chords per bar", synth.m_chordsPerBar, &synth.m_chordsPerBar);
+        op.add<Value<int>>("C", "courses", "Set number of courses, 6...14", synth.m_courses, &synth.m_courses);
+        op.add<Value<double>>("", "fingering", "Set probability a note is fingered", synth.m_fingering, &synth.m_fingering);
+        op.add<Value<double>>("", "ornaments", "Set probability a note has an ornament", synth.m_ornaments, &synth.m_ornaments);
+        op.add<Value<double>>("", "repeats", "Set probability a bar has a repeat", synth.m_repeats, &synth.m_repeats);
+        op.add<Value<double>>("", "timechanges", "Set probability a bar changes time signature", synth.m_timeChanges, &synth.m_timeChanges);
+        op.add<Value<std::string>>("t", "types", "Set file types to write", "tab,tc,musicxml,mei,mxl", &types);
+        op.add<Value<int>>("j", "jobs", "Set number of threads", 1, &options.m_jobs);
+        op.parse(argc, argv);
+
+        if (helpOption->is_set() || op.non_option_args().size() != 1)
+        {
+            std::cout << "Usage: luteconv_synth [options ...] stem" << std::endl << op;
+            return helpOption->is_set() ? 0 : 1;
+        }
+
+        if (!op.unknown_options().empty())
+            throw std::runtime_error("Error: unknown option " + op.unknown_options()[0]);
+
+        Piece piece;
+        synth.Build(piece);
+
+        const std::string stem{op.non_option_args()[0]};
+        std::istringstream ss(types);
+        std::string type;
+        while (std::getline(ss, type, ','))
+        {
+            Write(options, stem + "." + type, piece);
+            std::cout << stem << "." << type << std::endl;
+        }
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -23,11 +23,14 @@ TEST_F(LuteConvFixture, ProcessArgs)
             "-d", "mxl",
             "-7", "D2",
             "-i", "5",
+            "-j", "4",
+            "-V",
+            "--tabindex",
             "src",
             nullptr};
     
     Options options;
-    options.ProcessArgs(16, const_cast<char**>(argv));
+    options.ProcessArgs(20, const_cast<char**>(argv));
     
     EXPECT_EQ("dest", options.m_dstFilename);
     EXPECT_EQ(TabSpanish, options.m_dstTabType);
@@ -37,9 +40,55 @@ TEST_F(LuteConvFixture, ProcessArgs)
     EXPECT_EQ(1, options.m_7tuning.size());
     EXPECT_EQ(Pitch('D', 0, 2), options.m_7tuning[0]);
     EXPECT_EQ("5", options.m_index);
+    EXPECT_EQ(4, options.m_jobs);
+    EXPECT_EQ(LogInfo, options.m_logLevel);
+    EXPECT_TRUE(options.m_tabIndexCache);
     EXPECT_EQ("src", options.m_srcFilename);
 }
 
+TEST_F(LuteConvFixture, Info)
+{
+    using namespace luteconv;
+    
+    const char* argv[] = {"luteconv", "--info=json", "-j", "4", "one.tab", "dir/two.ft3", nullptr};
+    
+    Options options;
+    options.ProcessArgs(6, const_cast<char**>(argv));
+    
+    EXPECT_EQ("json", options.m_info);
+    ASSERT_EQ(2U, options.m_srcFilenames.size());
+    
+    const Options file = options.InfoOptions(options.m_srcFilenames[1]);
+    EXPECT_EQ("dir/two.ft3", file.m_srcFilename);
+    EXPECT_EQ(FormatFt3, file.m_srcFormat);
+    EXPECT_EQ(1, file.m_jobs);
+    EXPECT_TRUE(file.m_srcFilenames.empty());
+    
+    const char* exclusive[] = {"luteconv", "--info", "-o", "dest", "src", nullptr};
+    EXPECT_THROW(Options().ProcessArgs(5, const_cast<char**>(exclusive)), std::runtime_error);
+}
+
+TEST_F(LuteConvFixture, Batch)
+{
+    using namespace luteconv;
+    
+    const char* argv[] = {"luteconv", "--batch", "out", "-d", "mei", "one.tab", "dir/two.ft3", nullptr};
+    
+    Options options;
+    options.ProcessArgs(7, const_cast<char**>(argv));
+    
+    ASSERT_EQ(2U, options.m_srcFilenames.size());
+    const Options file = options.BatchOptions(options.m_srcFilenames[1]);
+    EXPECT_EQ("dir/two.ft3", file.m_srcFilename);
+    EXPECT_EQ("out/two.mei", file.m_dstFilename);
+    EXPECT_EQ(FormatFt3, file.m_srcFormat);
+    EXPECT_EQ(1, file.m_jobs);
+    
+    // sources with the same stem would write the same destination
+    const char* duplicate[] = {"luteconv", "--batch", "out", "-d", "mei", "one.tab", "dir/one.tc", nullptr};
+    EXPECT_THROW(Options().ProcessArgs(7, const_cast<char**>(duplicate)), std::runtime_error);
+}
+
 int main(int argc, char **argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <piece.h>
+
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    static luteconv::Note MakeNote(int string, int fret)
+    {
+        luteconv::Note note;
+        note.m_string = string;
+        note.m_fret = fret;
+        return note;
+    }
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Intern)
+{
+    using namespace luteconv;
+    
+    ChordTable chords;
+    EXPECT_EQ(1U, chords.Size());
+    EXPECT_EQ(0U, chords.Intern({}));
+    EXPECT_TRUE(chords.Notes(0).empty());
+    
+    const ShapeId a = chords.Intern({MakeNote(1, 2), MakeNote(3, 0)});
+    const ShapeId b = chords.Intern({MakeNote(1, 2)});
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, chords.Intern({MakeNote(1, 2), MakeNote(3, 0)}));
+    EXPECT_EQ(3U, chords.Size());
+    ASSERT_EQ(2U, chords.Notes(a).size());
+    EXPECT_EQ(3, chords.Notes(a)[1].m_string);
+    
+    // every field of a note distinguishes shapes
+    std::vector<Note> notes{MakeNote(1, 2)};
+    notes[0].m_rightFingering = FingerThumb;
+    EXPECT_NE(b, chords.Intern(notes));
+    EXPECT_NE(b, chords.Intern({MakeNote(1, 2 + 256)}));
+    EXPECT_NE(b, chords.Intern({MakeNote(1 + 256, 2)}));
+}
+
+TEST_F(LuteConvFixture, Merge)
+{
+    using namespace luteconv;
+    
+    Piece piece;
+    const ShapeId a = piece.m_chords.Intern({MakeNote(1, 2)});
+    
+    // a bar parsed with its own table
+    ChordTable other;
+    Bar bar;
+    bar.m_chords.resize(3);
+    bar.m_chords[0].m_shape = other.Intern({MakeNote(4, 4)});
+    bar.m_chords[1].m_shape = other.Intern({MakeNote(1, 2)});
+    
+    bar.Remap(piece.m_chords.Merge(other));
+    EXPECT_EQ(3U, piece.m_chords.Size());
+    EXPECT_EQ(4, piece.Notes(bar.m_chords[0])[0].m_fret);
+    EXPECT_EQ(a, bar.m_chords[1].m_shape);
+    EXPECT_EQ(0U, bar.m_chords[2].m_shape);
+    
+    // equal chords are equal shapes and flags
+    Chord chord;
+    chord.m_shape = a;
+    EXPECT_EQ(chord, bar.m_chords[1]);
+    chord.m_fermata = true;
+    EXPECT_NE(chord, bar.m_chords[1]);
+}
+
+TEST_F(LuteConvFixture, Skim)
+{
+    using namespace luteconv;
+    
+    // a skimmed table keeps only the highest course
+    ChordTable skim(true);
+    EXPECT_TRUE(skim.Skim());
+    EXPECT_EQ(0U, skim.Intern({MakeNote(1, 2), MakeNote(8, 0)}));
+    EXPECT_EQ(0U, skim.Intern({MakeNote(3, 1)}));
+    EXPECT_EQ(1U, skim.Size());
+    EXPECT_EQ(8, skim.Courses());
+    
+    ChordTable chords;
+    EXPECT_FALSE(chords.Skim());
+    EXPECT_EQ(0, chords.Courses());
+    chords.Intern({MakeNote(7, 2)});
+    EXPECT_EQ(7, chords.Courses());
+    chords.Merge(skim);
+    EXPECT_EQ(8, chords.Courses());
+    
+    // the tuning has the highest course of the chords
+    Piece piece;
+    piece.m_chords = skim;
+    piece.SetTuning(Options());
+    EXPECT_EQ(8U, piece.m_tuning.size());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <piecesynth.h>
+#include <genmei.h>
+#include <gentabcode.h>
+#include <parsermei.h>
+#include <parsertabcode.h>
+
+#include <sstream>
+#include <string>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    // Number of chords in piece
+    static size_t Chords(const luteconv::Piece& piece)
+    {
+        size_t chords{0};
+        for (const auto & bar : piece.m_bars)
+            chords += bar.m_chords.size();
+        return chords;
+    }
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Build)
+{
+    using namespace luteconv;
+
+    PieceSynth synth;
+    synth.m_bars = 500;
+    synth.m_chordsPerBar = 3;
+    synth.m_courses = 14;
+
+    Piece piece;
+    synth.Build(piece);
+    ASSERT_EQ(500U, piece.m_bars.size());
+    EXPECT_EQ(1500U, Chords(piece));
+    EXPECT_EQ(14U, piece.m_tuning.size());
+    EXPECT_NE(TimeSyNone, piece.m_bars.front().m_timeSig.m_timeSymbol);
+
+    int maxCourse{0};
+    for (const auto & bar : piece.m_bars)
+        for (const auto & chord : bar.m_chords)
+            for (const auto & note : piece.Notes(chord))
+                maxCourse = std::max(maxCourse, note.m_string);
+    EXPECT_GT(maxCourse, 6);
+    EXPECT_LE(maxCourse, 14);
+
+    synth.m_courses = 15;
+    EXPECT_THROW(synth.Build(piece), std::runtime_error);
+}
+
+TEST_F(LuteConvFixture, Deterministic)
+{
+    using namespace luteconv;
+
+    PieceSynth synth;
+    synth.m_bars = 200;
+    synth.m_seed = 42;
+
+    Piece lhs;
+    Piece rhs;
+    synth.Build(lhs);
+    synth.Build(rhs);
+
+    Options options;
+    std::ostringstream lhsText;
+    std::ostringstream rhsText;
+    GenTabCode().Generate(options, lhs, lhsText);
+    GenTabCode().Generate(options, rhs, rhsText);
+    EXPECT_EQ(lhsText.str(), rhsText.str());
+
+    // a different seed builds a different piece
+    synth.m_seed = 43;
+    Piece other;
+    synth.Build(other);
+    std::ostringstream otherText;
+    GenTabCode().Generate(options, other, otherText);
+    EXPECT_NE(lhsText.str(), otherText.str());
+}
+
+TEST_F(LuteConvFixture, RoundTrip)
+{
+    using namespace luteconv;
+
+    PieceSynth synth;
+    synth.m_bars = 300;
+    synth.m_courses = 10;
+    synth.m_repeats = 0.1;
+    synth.m_timeChanges = 0.1;
+
+    Piece piece;
+    synth.Build(piece);
+
+    Options options;
+    {
+        std::ostringstream ss;
+        GenTabCode().Generate(options, piece, ss);
+        Piece parsed;
+        ParserTabCode().Parse(std::string_view(ss.str()), options, parsed);
+        EXPECT_EQ(Chords(piece), Chords(parsed));
+    }
+    {
+        std::ostringstream ss;
+        GenMei().Generate(options, piece, ss);
+        std::string mei = ss.str();
+        Piece parsed;
+        ParserMei().Parse("synth.mei", mei.data(), mei.size(), options, parsed);
+        EXPECT_EQ(piece.m_bars.size(), parsed.m_bars.size());
+        EXPECT_EQ(Chords(piece), Chords(parsed));
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <rtf.h>
+
+#include <algorithm>
+#include <regex>
+#include <string>
+
+namespace
+{
+
+// A Fronimo .ft3 title
+const std::string ft3Rtf{"{\\rtf1\\ansi\\ansicpg1252\\deff0\\deflang1033{\\fonttbl{\\f0\\fnil\\fcharset0 MS Shell\r\nDlg;}}\r\n"
+                         "\\viewkind4\\uc1\\pard\\f0\\fs-22 2. Forlorn hope fancy\\par\r\n}\r\n"};
+
+// The regex RTF extractor previously used by ParserFt3
+std::string RegexExtract(const char* rtfBegin, int strLen)
+{
+    std::string rtf{rtfBegin, rtfBegin + strLen};
+    rtf.erase(std::remove(rtf.begin(), rtf.end(), '\n'), rtf.end());
+    rtf.erase(std::remove(rtf.begin(), rtf.end(), '\r'), rtf.end());
+
+    const std::regex re{R"(\{(\\[\w\-;]+|\{[^\}\{]*|\}|[\r\n]*)*\s*([^\\\{]*)(\\[\w\-;]+|\{[^\}\{]*|\}|[\r\n]*)*\})"};
+    std::cmatch results;
+    if (std::regex_match(rtf.c_str(), results, re))
+        return results[2];
+
+    return rtf;
+}
+
+// RTF with n formatting control words before the text
+std::string LongRtf(int n)
+{
+    std::string rtf{"{\\rtf1\\ansi{\\fonttbl{\\f0\\fnil Arial;}}\\pard"};
+    for (int i = 0; i < n; ++i)
+        rtf += "\\f0\\fs22";
+    rtf += " Lachrimae\\par}";
+    return rtf;
+}
+
+} // namespace
+
+static void BM_RtfRegexFt3(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(RegexExtract(ft3Rtf.data(), ft3Rtf.size()));
+    state.SetBytesProcessed(state.iterations() * ft3Rtf.size());
+}
+BENCHMARK(BM_RtfRegexFt3);
+
+static void BM_RtfTokenizerFt3(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(luteconv::Rtf::ExtractText(ft3Rtf.data(), ft3Rtf.size()));
+    state.SetBytesProcessed(state.iterations() * ft3Rtf.size());
+}
+BENCHMARK(BM_RtfTokenizerFt3);
+
+static void BM_RtfRegexLong(benchmark::State& state)
+{
+    const std::string rtf = LongRtf(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(RegexExtract(rtf.data(), rtf.size()));
+    state.SetBytesProcessed(state.iterations() * rtf.size());
+}
+BENCHMARK(BM_RtfRegexLong)->Range(8, 512);
+
+static void BM_RtfTokenizerLong(benchmark::State& state)
+{
+    const std::string rtf = LongRtf(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(luteconv::Rtf::ExtractText(rtf.data(), rtf.size()));
+    state.SetBytesProcessed(state.iterations() * rtf.size());
+}
+BENCHMARK(BM_RtfTokenizerLong)->Range(8, 512);
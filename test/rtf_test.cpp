@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <rtf.h>
+
+#include <zlib.h>
+
+#include <dirent.h>
+#include <algorithm>
+#include <regex>
+#include <string>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // The regex RTF extractor previously used by ParserFt3, as a reference
+    static std::string RegexExtract(const char* rtfBegin, int strLen);
+
+    // The RTF strings in a Fronimo .ft3 header: title, author, composer
+    static std::vector<std::string> Ft3HeaderStrings(const std::string& filename);
+
+    std::string m_sourceDir;
+};
+
+std::string LuteConvFixture::RegexExtract(const char* rtfBegin, int strLen)
+{
+    std::string rtf{rtfBegin, rtfBegin + strLen};
+    rtf.erase(std::remove(rtf.begin(), rtf.end(), '\n'), rtf.end());
+    rtf.erase(std::remove(rtf.begin(), rtf.end(), '\r'), rtf.end());
+
+    const std::regex re{R"(\{(\\[\w\-;]+|\{[^\}\{]*|\}|[\r\n]*)*\s*([^\\\{]*)(\\[\w\-;]+|\{[^\}\{]*|\}|[\r\n]*)*\})"};
+    std::cmatch results;
+    if (std::regex_match(rtf.c_str(), results, re))
+        return results[2];
+
+    return rtf;
+}
+
+std::vector<std::string> LuteConvFixture::Ft3HeaderStrings(const std::string& filename)
+{
+    std::vector<std::string> result;
+    std::string image;
+
+    gzFile ft3File = gzopen(filename.c_str(), "rb");
+    if (!ft3File)
+        return result;
+
+    char buffer[4096];
+    int nRead{0};
+    while ((nRead = gzread(ft3File, buffer, sizeof(buffer))) > 0)
+        image.append(buffer, nRead);
+    gzclose(ft3File);
+
+    size_t pos = image.find("CPiece");
+    if (pos == std::string::npos)
+        return result;
+
+    pos += 14;
+    for (int i = 0; i < 3 && pos < image.size(); ++i)
+    {
+        const size_t strLen = static_cast<unsigned char>(image[pos++]);
+        result.push_back(image.substr(pos, strLen));
+        pos += strLen;
+    }
+    return result;
+}
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, CompareRegexFt3)
+{
+    const std::string originalDir = m_sourceDir + "/examples/original";
+    int count{0};
+
+    struct dirent* entry{nullptr};
+    DIR* dir = opendir(originalDir.c_str());
+    ASSERT_NE(nullptr, dir);
+
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        const std::string filename{entry->d_name};
+        if (entry->d_type != DT_REG || filename.size() < 4 || filename.substr(filename.size() - 4) != ".ft3")
+            continue;
+
+        for (const auto & rtf : Ft3HeaderStrings(originalDir + "/" + filename))
+        {
+            EXPECT_EQ(RegexExtract(rtf.data(), rtf.size()), luteconv::Rtf::ExtractText(rtf.data(), rtf.size())) << filename;
+            ++count;
+        }
+    }
+    closedir(dir);
+
+    EXPECT_LT(0, count);
+}
+
+TEST_F(LuteConvFixture, CompareRegexSimple)
+{
+    for (const std::string rtf : {
+        R"({\rtf1\ansi\deff0{\fonttbl{\f0\fnil Arial;}}\pard\f0\fs20 Lachrimae\par})",
+        "{\\rtf1\\ansi\\ansicpg1252\\deff0\\deflang1033{\\fonttbl{\\f0\\fnil\\fcharset0 MS Shell\r\nDlg;}}\r\n"
+            "\\viewkind4\\uc1\\pard\\f0\\fs-22 John Dowland\\par\r\n}\r\n",
+        R"({\rtf1\ansi\pard \par})",
+        "Not RTF\r\n"})
+    {
+        EXPECT_EQ(RegexExtract(rtf.data(), rtf.size()), luteconv::Rtf::ExtractText(rtf.data(), rtf.size())) << rtf;
+    }
+}
+
+TEST_F(LuteConvFixture, HexEscape)
+{
+    const std::string rtf{R"({\rtf1\ansi\ansicpg1252 Fran\'e7ois Dufaut \'96 Pr\'e9lude\par})"};
+    EXPECT_EQ("Fran\xc3\xa7ois Dufaut \xe2\x80\x93 Pr\xc3\xa9lude", luteconv::Rtf::ExtractText(rtf.data(), rtf.size()));
+}
+
+TEST_F(LuteConvFixture, UnicodeEscape)
+{
+    // \uc1 one fallback character, \uc0 none, negative values are signed 16 bit
+    const std::string rtf{R"({\rtf1\ansi\uc1 Gr\u252?n {\uc0\u8364} \u-4064?\par})"};
+    EXPECT_EQ("Gr\xc3\xbcn \xe2\x82\xac \xef\x80\xa0", luteconv::Rtf::ExtractText(rtf.data(), rtf.size()));
+
+    // surrogate pair U+1D11E G clef
+    const std::string surrogate{R"({\rtf1\ansi\uc1 \u-10188?\u-8930?})"};
+    EXPECT_EQ("\xf0\x9d\x84\x9e", luteconv::Rtf::ExtractText(surrogate.data(), surrogate.size()));
+}
+
+TEST_F(LuteConvFixture, SkipGroups)
+{
+    const std::string rtf{R"({\rtf1\ansi{\fonttbl{\f0 Times;}}{\colortbl;\red0\green0\blue0;})"
+                          R"({\*\generator Riched20;}{\info{\title Hidden}}\pard {\b Galliard} in {\i G}\par})"};
+    EXPECT_EQ("Galliard in G", luteconv::Rtf::ExtractText(rtf.data(), rtf.size()));
+}
+
+TEST_F(LuteConvFixture, ControlSymbols)
+{
+    const std::string rtf{R"({\rtf1\ansi A\~B\_C\-D \{E\} \\F\line G})"};
+    EXPECT_EQ("A B-CD {E} \\F G", luteconv::Rtf::ExtractText(rtf.data(), rtf.size()));
+}
+
+TEST_F(LuteConvFixture, Truncated)
+{
+    // must not read beyond the end of the buffer
+    const std::string rtf{R"({\rtf1\ansi Fantasia\'e)"};
+    EXPECT_EQ("Fantasia", luteconv::Rtf::ExtractText(rtf.data(), rtf.size()));
+
+    const std::string backslash{"{\\rtf1 Pavan\\"};
+    EXPECT_EQ("Pavan", luteconv::Rtf::ExtractText(backslash.data(), backslash.size()));
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
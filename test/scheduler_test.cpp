@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <gentabcode.h>
+#include <parallel.h>
+#include <piecesynth.h>
+#include <scheduler.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Write a synthetic TabCode file, return its filename
+    std::string Synthesize(const std::string& stem, int bars) const
+    {
+        using namespace luteconv;
+
+        PieceSynth synth;
+        synth.m_bars = bars;
+        Piece piece;
+        synth.Build(piece);
+        const std::string filename = m_binaryDir + "/" + stem + ".tc";
+        std::ofstream dst(filename.c_str());
+        GenTabCode().Generate(Options(), piece, dst);
+        return filename;
+    }
+
+    // Options to convert a file of the batch to musicxml
+    luteconv::Options BatchOptions(const std::string& srcFilename) const
+    {
+        luteconv::Options options;
+        options.m_batchDir = m_binaryDir;
+        options.m_dstFormat = luteconv::FormatMusicxml;
+        return options.BatchOptions(srcFilename);
+    }
+
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, BatchOptions)
+{
+    using namespace luteconv;
+
+    Options options;
+    options.m_batchDir = "out";
+    options.m_dstFormat = FormatMei;
+    options.m_jobs = 4;
+    const Options batch = options.BatchOptions("in/piece.v2.tab");
+    EXPECT_EQ("in/piece.v2.tab", batch.m_srcFilename);
+    EXPECT_EQ("out/piece.v2.mei", batch.m_dstFilename);
+    EXPECT_EQ(FormatTab, batch.m_srcFormat);
+    EXPECT_EQ(FormatMei, batch.m_dstFormat);
+    EXPECT_EQ(1, batch.m_jobs);
+}
+
+TEST_F(LuteConvFixture, LargestFirst)
+{
+    using namespace luteconv;
+
+    Scheduler scheduler(1, 0.0);
+    scheduler.Add(BatchOptions(Synthesize("scheduler_small", 10)));
+    scheduler.Add(BatchOptions(Synthesize("scheduler_large", 1000)));
+    scheduler.Add(BatchOptions(Synthesize("scheduler_medium", 100)));
+    scheduler.Add(BatchOptions(m_binaryDir + "/scheduler_missing.tc"));
+    scheduler.Run(true);
+
+    const auto & jobs = scheduler.Jobs();
+    ASSERT_EQ(4U, jobs.size());
+    EXPECT_EQ(2, jobs[0].m_order);
+    EXPECT_EQ(0, jobs[1].m_order);
+    EXPECT_EQ(1, jobs[2].m_order);
+    EXPECT_EQ(3, jobs[3].m_order);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ("", jobs[i].m_error);
+        EXPECT_LT(0U, jobs[i].m_stats.m_bars);
+        EXPECT_TRUE(std::ifstream(jobs[i].m_options.m_dstFilename.c_str()).good());
+    }
+    EXPECT_NE("", jobs[3].m_error);
+    EXPECT_EQ(0U, Scheduler::Cost(jobs[3].m_options));
+}
+
+TEST_F(LuteConvFixture, Stealing)
+{
+    using namespace luteconv;
+
+    // one large job, the other threads steal the small ones
+    Scheduler scheduler(4, 0.0);
+    scheduler.Add(BatchOptions(Synthesize("scheduler_large", 1000)));
+    for (int i = 0; i < 12; ++i)
+        scheduler.Add(BatchOptions(Synthesize("scheduler_small" + std::to_string(i), 10 + i)));
+    scheduler.Run(false);
+
+    EXPECT_GT(4, scheduler.Jobs().front().m_order);
+    for (const auto & job : scheduler.Jobs())
+    {
+        EXPECT_EQ("", job.m_error) << job.m_options.m_srcFilename;
+        EXPECT_LE(0, job.m_order);
+    }
+}
+
+TEST_F(LuteConvFixture, Timeout)
+{
+    using namespace luteconv;
+
+    Scheduler scheduler(2, 0.05);
+    scheduler.Add(BatchOptions(Synthesize("scheduler_huge", 50000)));
+    scheduler.Add(BatchOptions(Synthesize("scheduler_small", 10)));
+    scheduler.Run(false);
+
+    const auto & jobs = scheduler.Jobs();
+    EXPECT_TRUE(jobs[0].m_timedOut);
+    EXPECT_EQ("Error: Timed out after 0.05 seconds", jobs[0].m_error);
+    EXPECT_FALSE(jobs[1].m_timedOut);
+    EXPECT_EQ("", jobs[1].m_error);
+}
+
+TEST_F(LuteConvFixture, CancelAll)
+{
+    using namespace luteconv;
+
+    Scheduler scheduler(1, 0.0);
+    scheduler.Add(BatchOptions(Synthesize("scheduler_huge", 50000)));
+    scheduler.Add(BatchOptions(Synthesize("scheduler_small", 10)));
+    std::thread canceller([&scheduler]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            scheduler.CancelAll();
+        });
+    scheduler.Run(false);
+    canceller.join();
+
+    for (const auto & job : scheduler.Jobs())
+    {
+        EXPECT_EQ("Error: Cancelled", job.m_error);
+        EXPECT_FALSE(job.m_timedOut);
+    }
+}
+
+TEST_F(LuteConvFixture, Parallel)
+{
+    using namespace luteconv;
+
+    // workers are cancelled with the calling thread
+    Cancel cancel;
+    cancel.Request();
+    CancelScope cancelScope(&cancel);
+    EXPECT_THROW(Parallel::For(4, 4, [](size_t, size_t)
+        {
+            Cancel::Check();
+        }), Cancelled);
+
+    Cancel deadline;
+    deadline.SetTimeout(1e-9);
+    CancelScope deadlineScope(&deadline);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    try
+    {
+        Cancel::Check();
+        FAIL() << "expected an exception";
+    }
+    catch (const Cancelled& e)
+    {
+        EXPECT_TRUE(e.m_timedOut);
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
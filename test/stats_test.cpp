@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <converter.h>
+#include <parallel.h>
+#include <stats.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Convert with statistics
+    luteconv::Stats Convert(const std::string& src, const std::string& dst) const
+    {
+        luteconv::Options options;
+        options.m_srcFilename = m_sourceDir + "/examples/original/" + src;
+        options.m_dstFilename = m_binaryDir + "/" + dst;
+        options.SetFormatFilename();
+
+        luteconv::Stats stats;
+        luteconv::Converter converter;
+        converter.Convert(options, stats);
+        return stats;
+    }
+
+    static bool HasStage(const luteconv::Stats& stats, const std::string& name)
+    {
+        return std::any_of(stats.m_stages.begin(), stats.m_stages.end(),
+                [&name](const luteconv::Stats::Stage& stage){ return stage.m_name == name; });
+    }
+
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Stages)
+{
+    using namespace luteconv;
+
+    const Stats stats = Convert("F_Cutting_galliard.mxl", "stats_test.mei");
+    EXPECT_TRUE(HasStage(stats, "parse"));
+    EXPECT_TRUE(HasStage(stats, "unzip"));
+    EXPECT_TRUE(HasStage(stats, "xml"));
+    EXPECT_TRUE(HasStage(stats, "tuning"));
+    EXPECT_TRUE(HasStage(stats, "generate"));
+    EXPECT_TRUE(HasStage(stats, "write"));
+    EXPECT_FALSE(HasStage(stats, "gunzip"));
+
+    EXPECT_GT(stats.m_bytesIn, 0U);
+    EXPECT_GT(stats.m_bytesOut, stats.m_bytesIn);
+    EXPECT_EQ(48U, stats.m_bars);
+    EXPECT_GT(stats.m_chords, stats.m_bars);
+    EXPECT_GT(stats.m_notes, stats.m_chords);
+    EXPECT_EQ(Stats::Accounting(), stats.m_allocations > 0);
+    EXPECT_GT(stats.m_peakRss, 0U);
+    EXPECT_EQ(nullptr, Stats::Current());
+}
+
+TEST_F(LuteConvFixture, Print)
+{
+    using namespace luteconv;
+
+    std::vector<Stats> stats;
+    stats.push_back(Convert("02_forlorne_hope_8C.ft3", "stats_test.tab"));
+    stats.push_back(Convert("2674.tc", "stats_test.tc"));
+
+    std::ostringstream json;
+    Stats::Print(json, stats, true);
+    EXPECT_EQ(0U, json.str().find("{\"files\": [{\"source\": "));
+    EXPECT_NE(std::string::npos, json.str().find("\"name\": \"gunzip\""));
+    EXPECT_NE(std::string::npos, json.str().find("\"total\": {\"wall_ms\": "));
+    EXPECT_NE(std::string::npos, json.str().find("\"bars\": " + std::to_string(stats[0].m_bars + stats[1].m_bars)));
+
+    std::ostringstream text;
+    Stats::Print(text, stats, false);
+    EXPECT_NE(std::string::npos, text.str().find("\ntotal\n"));
+}
+
+TEST_F(LuteConvFixture, Accounting)
+{
+    using namespace luteconv;
+
+    const Stats stats = Convert("Kapsberger-Gagliarda5a.tab", "stats_test.musicxml");
+    std::ostringstream json;
+    Stats::Print(json, {stats}, true);
+    if (!Stats::Accounting())
+    {
+        EXPECT_EQ(0U, stats.m_peakBytes);
+        EXPECT_EQ(std::string::npos, json.str().find("\"peak_bytes\""));
+        EXPECT_EQ(std::string::npos, json.str().find("\"allocations\""));
+        return;
+    }
+
+    // the output is built in memory before it is written
+    EXPECT_GT(stats.m_peakBytes, stats.m_bytesOut);
+    EXPECT_LE(stats.m_peakBytes, stats.m_allocatedBytes);
+    uint64_t stageAllocations{0};
+    for (const auto & stage : stats.m_stages)
+    {
+        EXPECT_LE(stage.m_allocations, stats.m_allocations) << stage.m_name;
+        EXPECT_LE(stage.m_peakBytes, stats.m_peakBytes) << stage.m_name;
+        if (stage.m_depth == 0)
+            stageAllocations += stage.m_allocations;
+    }
+    EXPECT_GT(stageAllocations, 0U);
+    EXPECT_LE(stageAllocations, stats.m_allocations);
+    EXPECT_NE(std::string::npos, json.str().find("\"peak_bytes\": " + std::to_string(stats.m_peakBytes)));
+}
+
+TEST_F(LuteConvFixture, Threads)
+{
+    using namespace luteconv;
+
+    // allocate count ints on the calling thread
+    const auto allocate = [](size_t count)
+        {
+            std::vector<std::unique_ptr<int>> ints;
+            ints.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+                ints.emplace_back(new int(static_cast<int>(i)));
+            return ints.size();
+        };
+
+    Stats process;
+    process.StartProcess();
+    Stats stats;
+    stats.Start("", "");
+
+    // another conversion's allocations are not counted, the workers' are
+    Stats other;
+    std::thread thread([&other, &allocate]
+        {
+            other.Start("", "");
+            allocate(100000);
+            other.Stop();
+        });
+    thread.join();
+    Parallel::For(4, 4, [&allocate](size_t begin, size_t end) { allocate(1000 * (end - begin)); });
+
+    stats.Stop();
+    process.StopProcess();
+    EXPECT_EQ(nullptr, Stats::Current());
+    if (!Stats::Accounting())
+    {
+        EXPECT_EQ(0U, process.m_allocations);
+        return;
+    }
+
+    EXPECT_GE(other.m_allocations, 100000U);
+    EXPECT_GE(stats.m_allocations, 4000U);
+    EXPECT_LT(stats.m_allocations, 100000U);
+    EXPECT_GE(process.m_allocations, stats.m_allocations + other.m_allocations);
+
+    // the total is the process's, not the sum
+    std::ostringstream json;
+    Stats::Print(json, {stats, other}, true, &process);
+    EXPECT_NE(std::string::npos, json.str().find("\"allocations\": " + std::to_string(process.m_allocations) + ","));
+}
+
+TEST_F(LuteConvFixture, AlignedNew)
+{
+    using namespace luteconv;
+
+    struct alignas(64) Line
+    {
+        char m_bytes[64];
+    };
+
+    Stats stats;
+    stats.Start("", "");
+    {
+        std::vector<Line> lines(10);
+        auto line = std::make_unique<Line>();
+        EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(lines.data()) % alignof(Line));
+        EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(line.get()) % alignof(Line));
+    }
+    stats.Stop();
+    if (!Stats::Accounting())
+        return;
+
+    EXPECT_EQ(2U, stats.m_allocations);
+    EXPECT_EQ(11 * sizeof(Line), stats.m_allocatedBytes);
+    EXPECT_EQ(11 * sizeof(Line), stats.m_peakBytes);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
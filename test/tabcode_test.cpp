@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <parsertabcode.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+    
+    // Parse text serially and in chunks, expect the same bars. Returns false if chunking failed
+    static bool CompareChunked(const std::string& text, int chunkCount);
+    
+    std::string m_sourceDir;
+};
+
+bool LuteConvFixture::CompareChunked(const std::string& text, int chunkCount)
+{
+    using namespace luteconv;
+    
+    Options options;
+    Piece expected;
+    ParserTabCode().Parse(text, options, expected);
+    
+    Piece actual;
+    if (!ParserTabCode().ParseChunked(text, chunkCount, 4, actual))
+    {
+        // speculation failed, a split was in a comment
+        EXPECT_TRUE(actual.m_bars.empty());
+        return false;
+    }
+    
+    EXPECT_EQ(expected.m_bars.size(), actual.m_bars.size()) << chunkCount;
+    if (expected.m_bars.size() != actual.m_bars.size())
+        return true;
+
+    for (size_t i = 0; i < expected.m_bars.size(); ++i)
+    {
+        const Bar& lhs = expected.m_bars[i];
+        const Bar& rhs = actual.m_bars[i];
+        EXPECT_EQ(lhs.m_barStyle, rhs.m_barStyle) << "bar " << i;
+        EXPECT_EQ(lhs.m_repeat, rhs.m_repeat) << "bar " << i;
+        EXPECT_EQ(lhs.m_eol, rhs.m_eol) << "bar " << i;
+        EXPECT_EQ(lhs.m_timeSig.m_timeSymbol, rhs.m_timeSig.m_timeSymbol) << "bar " << i;
+        EXPECT_EQ(lhs.m_timeSig.m_beats, rhs.m_timeSig.m_beats) << "bar " << i;
+        EXPECT_EQ(lhs.m_chords.size(), rhs.m_chords.size()) << "bar " << i;
+        if (lhs.m_chords.size() != rhs.m_chords.size())
+            continue;
+        for (size_t j = 0; j < lhs.m_chords.size(); ++j)
+        {
+            EXPECT_EQ(lhs.m_chords[j].m_noteType, rhs.m_chords[j].m_noteType) << "bar " << i << " chord " << j;
+            EXPECT_EQ(lhs.m_chords[j].m_dotted, rhs.m_chords[j].m_dotted) << "bar " << i << " chord " << j;
+            EXPECT_EQ(lhs.m_chords[j].m_noFlag, rhs.m_chords[j].m_noFlag) << "bar " << i << " chord " << j;
+            EXPECT_EQ(lhs.m_chords[j].m_fermata, rhs.m_chords[j].m_fermata) << "bar " << i << " chord " << j;
+            const std::vector<Note>& lhsNotes = expected.Notes(lhs.m_chords[j]);
+            const std::vector<Note>& rhsNotes = actual.Notes(rhs.m_chords[j]);
+            EXPECT_EQ(lhsNotes.size(), rhsNotes.size()) << "bar " << i << " chord " << j;
+            for (size_t k = 0; k < std::min(lhsNotes.size(), rhsNotes.size()); ++k)
+            {
+                EXPECT_EQ(lhsNotes[k].m_string, rhsNotes[k].m_string);
+                EXPECT_EQ(lhsNotes[k].m_fret, rhsNotes[k].m_fret);
+            }
+        }
+    }
+    return true;
+}
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, ChunkedExample)
+{
+    std::ifstream src(m_sourceDir + "/examples/original/2674.tc");
+    std::ostringstream ss;
+    ss << src.rdbuf();
+    ASSERT_FALSE(ss.str().empty());
+    
+    std::string text;
+    for (int i = 0; i < 10; ++i)
+        text += ss.str();
+    
+    for (int chunkCount : {1, 2, 3, 7, 16, 100})
+        EXPECT_TRUE(CompareChunked(text, chunkCount));
+}
+
+TEST_F(LuteConvFixture, ChunkedRandom)
+{
+    // bar lines in every combination, rhythm signs omitted, {^} and comments containing bar lines
+    const std::vector<std::string> tokens{
+        "|", "||", "|:", ":|", ":||:", "|=", "|X", "{^}", "{>}", "{a |\n| b}", "{^}{>}",
+        "Qa1", "a1b2", "Eb2", "E.c3", "F", "Fa1", "Q", "Xa/", "c1(Fl1:7)", "M(3)", "M(C/)"};
+    const std::vector<std::string> separators{" ", "\n", "\t", "\r\n", "  "};
+    
+    std::mt19937 random(2674);
+    int chunked{0};
+    for (int trial = 0; trial < 200; ++trial)
+    {
+        std::string text;
+        const int count = 1 + random() % 120;
+        for (int i = 0; i < count; ++i)
+        {
+            text += tokens[random() % tokens.size()];
+            text += separators[random() % separators.size()];
+        }
+        
+        for (int chunkCount : {2, 3, 5, 9, 40})
+        {
+            if (CompareChunked(text, chunkCount))
+                ++chunked;
+        }
+    }
+    
+    // most splits are outside comments
+    EXPECT_LT(500, chunked);
+}
+
+TEST_F(LuteConvFixture, SplitInComment)
+{
+    using namespace luteconv;
+    
+    // every split falls in the comment
+    const std::string text{"Qa1 | {x | | | | | | | | | | | | | | | | | | | |} b1 |"};
+    Piece piece;
+    EXPECT_FALSE(ParserTabCode().ParseChunked(text, 4, 4, piece));
+    EXPECT_TRUE(piece.m_bars.empty());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
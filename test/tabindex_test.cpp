@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <tabindex.h>
+#include <parsertab.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+    
+    // Three sections, the second with trailing spaces on its "p", the third empty
+    static const std::string m_tab;
+    
+    std::string m_binaryDir;
+};
+
+const std::string LuteConvFixture::m_tab{
+    "-s\n{Galliard}\nb\n2 a\nx b\np\n"
+    "{Pavan}\n3 c\n\nb\np  \r\n"
+    "p\n"
+    "1 d\ne\n"};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Build)
+{
+    using namespace luteconv;
+    
+    TabIndex index;
+    index.Build(m_tab);
+    ASSERT_EQ(4U, index.Size());
+    
+    TabSection section;
+    ASSERT_TRUE(index.Find(0, section));
+    EXPECT_EQ("-s\n{Galliard}\nb\n2 a\nx b", m_tab.substr(section.m_offset, section.m_size));
+    EXPECT_EQ(0, section.m_lineNo);
+    
+    ASSERT_TRUE(index.Find(1, section));
+    EXPECT_EQ("{Pavan}\n3 c\n\nb", m_tab.substr(section.m_offset, section.m_size));
+    EXPECT_EQ(6, section.m_lineNo);
+    
+    ASSERT_TRUE(index.Find(2, section));
+    EXPECT_EQ(0U, section.m_size);
+    
+    ASSERT_TRUE(index.Find(3, section));
+    EXPECT_EQ("1 d\ne\n", m_tab.substr(section.m_offset, section.m_size));
+    EXPECT_EQ(12, section.m_lineNo);
+    
+    EXPECT_FALSE(index.Find(4, section));
+    EXPECT_FALSE(index.Find(-1, section));
+}
+
+TEST_F(LuteConvFixture, Sidecar)
+{
+    using namespace luteconv;
+    
+    const std::string filename = m_binaryDir + "/tabindex_test.tab";
+    const std::string sidecar = TabIndex::SidecarFilename(filename);
+    {
+        std::ofstream dst(filename.c_str(), std::ios::binary);
+        dst << m_tab;
+    }
+    std::remove(sidecar.c_str());
+    
+    TabIndex::Key key;
+    ASSERT_TRUE(TabIndex::GetKey(filename, key));
+    EXPECT_EQ(m_tab.size(), key.m_size);
+    
+    TabIndex index;
+    EXPECT_FALSE(index.Load(sidecar, key));
+    index.Build(m_tab);
+    ASSERT_TRUE(index.Save(sidecar, key));
+    
+    TabIndex loaded;
+    ASSERT_TRUE(loaded.Load(sidecar, key));
+    ASSERT_EQ(index.Size(), loaded.Size());
+    for (int i = 0; i < static_cast<int>(index.Size()); ++i)
+    {
+        TabSection lhs;
+        TabSection rhs;
+        index.Find(i, lhs);
+        loaded.Find(i, rhs);
+        EXPECT_EQ(lhs.m_offset, rhs.m_offset);
+        EXPECT_EQ(lhs.m_size, rhs.m_size);
+        EXPECT_EQ(lhs.m_lineNo, rhs.m_lineNo);
+    }
+    
+    // a different file is stale
+    TabIndex::Key changed = key;
+    ++changed.m_hash;
+    EXPECT_FALSE(loaded.Load(sidecar, changed));
+    
+    // a corrupt count of sections is rejected, not allocated
+    for (const char* count : {"4000000000000000000", "0"})
+    {
+        const std::string corrupt = m_binaryDir + "/tabindex_test_corrupt.tabidx";
+        {
+            std::ofstream dst(corrupt.c_str());
+            dst << "luteconv-tabindex 1\n" << key.m_size << " " << key.m_mtime << " " << key.m_hash << " " << count << "\n";
+        }
+        EXPECT_FALSE(loaded.Load(corrupt, key)) << count;
+        EXPECT_EQ(0U, loaded.Size());
+    }
+    
+    // parse via the sidecar gives the same piece
+    for (const char* section : {"0", "1", "2", "3", "4"})
+    {
+        Options options;
+        options.m_srcFilename = filename;
+        options.m_index = section;
+        
+        Piece expected;
+        ParserTab().Parse(m_tab, options, expected);
+        
+        options.m_tabIndexCache = true;
+        Piece actual;
+        ParserTab().Parse(options, actual);
+        
+        EXPECT_EQ(expected.m_credits.size(), actual.m_credits.size()) << section;
+        ASSERT_EQ(expected.m_bars.size(), actual.m_bars.size()) << section;
+        for (size_t i = 0; i < expected.m_bars.size(); ++i)
+            EXPECT_EQ(expected.m_bars[i].m_chords.size(), actual.m_bars[i].m_chords.size()) << section;
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
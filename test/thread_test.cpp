@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <converter.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+    
+    // Returns first differing line, empty if same
+    std::string Diff(const std::string& lhs, const std::string& rhs) const;
+    
+    // allow dates and our version number to differ, compiled before the threads start
+    const std::regex m_ignore{R"((2\d\d\d|luteconv))"};
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+std::string LuteConvFixture::Diff(const std::string& lhs, const std::string& rhs) const
+{
+    std::fstream lhsStream(lhs.c_str(), std::fstream::in);
+    std::fstream rhsStream(rhs.c_str(), std::fstream::in);
+    
+    std::string lhsLine;
+    std::string rhsLine;
+    
+    while (!lhsStream.eof() && !rhsStream.eof())
+    {
+        getline(lhsStream, lhsLine);
+        getline(rhsStream, rhsLine);
+        
+        if (lhsLine != rhsLine && !std::regex_search(lhsLine, m_ignore))
+            return "Compare " + lhs + " with " + rhs + ": " + lhsLine + " != " + rhsLine;
+    }
+    
+    if (lhsStream.eof() != rhsStream.eof())
+        return "Compare " + lhs + " with " + rhs + ": length differs";
+    
+    return "";
+}
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, ConcurrentConvertTest)
+{
+    using namespace luteconv;
+    
+    const std::string originalDir = m_sourceDir + "/examples/original";
+    const std::string convertedDir = m_sourceDir + "/examples/converted";
+    const std::string dstDir = m_binaryDir + "/thread_test";
+    
+    mkdir(dstDir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    
+    std::vector<std::string> filenames;
+    struct dirent* entry{nullptr};
+    DIR* dir = opendir(originalDir.c_str());
+    ASSERT_NE(nullptr, dir);
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_type == DT_REG)
+            filenames.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+    
+    // every file to every format, several times over, on concurrent threads
+    // each conversion writes its own destination file
+    struct Job
+    {
+        std::string m_filename;
+        std::string m_filetype;
+        int m_copy;
+    };
+    std::vector<Job> jobs;
+    const int copies = 3;
+    for (int copy = 0; copy < copies; ++copy)
+        for (const auto & filename : filenames)
+            for (auto filetype : {".mei", ".musicxml", ".tab", ".tc"})
+                jobs.push_back({filename, filetype, copy});
+    
+    std::vector<std::string> failures(jobs.size());
+    std::atomic<size_t> next{0};
+    
+    const auto worker = [&]()
+    {
+        for (size_t i = next++; i < jobs.size(); i = next++)
+        {
+            const Job& job = jobs[i];
+            Options options;
+            options.m_srcFilename = originalDir + "/" + job.m_filename;
+            options.m_dstFilename = dstDir + "/" + std::to_string(job.m_copy) + "_" + job.m_filename + job.m_filetype;
+            options.SetFormatFilename();
+            
+            try
+            {
+                Converter converter;
+                converter.Convert(options);
+                failures[i] = Diff(convertedDir + "/" + job.m_filename + job.m_filetype, options.m_dstFilename);
+            }
+            catch (std::exception& e)
+            {
+                failures[i] = options.m_srcFilename + ": " + e.what();
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+        threads.emplace_back(worker);
+    for (auto & thread : threads)
+        thread.join();
+    
+    for (const auto & failure : failures)
+        EXPECT_EQ("", failure);
+}
+
+TEST_F(LuteConvFixture, ParallelGenerateTest)
+{
+    using namespace luteconv;
+    
+    const std::string originalDir = m_sourceDir + "/examples/original";
+    const std::string dstDir = m_binaryDir + "/thread_test";
+    
+    mkdir(dstDir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    
+    // a longer piece, so that every job renders many bars
+    const std::string longFilename = dstDir + "/long.tc";
+    {
+        std::ifstream src(originalDir + "/2674.tc");
+        std::stringstream ss;
+        ss << src.rdbuf();
+        std::ofstream dst(longFilename);
+        for (int i = 0; i < 20; ++i)
+            dst << ss.str();
+    }
+    
+    for (const auto & srcFilename : {originalDir + "/2674.tc", originalDir + "/da_crema-1546_10-no_6.mei",
+                                     originalDir + "/F_Cutting_galliard.mxl", longFilename})
+    {
+        for (auto filetype : {".mei", ".musicxml", ".tab", ".tc"})
+        {
+            // measures rendered on 4 threads must match the serial rendering
+            std::string dstFilenames[2];
+            for (int jobs : {1, 4})
+            {
+                Options options;
+                options.m_srcFilename = srcFilename;
+                options.m_dstFilename = dstDir + "/jobs" + std::to_string(jobs) + filetype;
+                options.m_jobs = jobs;
+                options.m_wrapThreshold = 4; // plenty of stave breaks, some at janus repeats
+                options.SetFormatFilename();
+                Converter().Convert(options);
+                dstFilenames[jobs == 1 ? 0 : 1] = options.m_dstFilename;
+            }
+            EXPECT_EQ("", Diff(dstFilenames[0], dstFilenames[1])) << srcFilename;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <converter.h>
+#include <trace.h>
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Write the trace and read it back
+    std::string Write() const
+    {
+        const std::string filename = m_binaryDir + "/trace_test.json";
+        luteconv::Trace::Write(filename);
+        std::ifstream s(filename.c_str());
+        std::ostringstream ss;
+        ss << s.rdbuf();
+        return ss.str();
+    }
+
+    // Thread ids of the spans with this name
+    static std::set<std::string> Tids(const std::string& trace, const std::string& name)
+    {
+        std::set<std::string> tids;
+        std::istringstream ss(trace);
+        std::string line;
+        while (std::getline(ss, line))
+        {
+            if (line.find("\"name\": \"" + name + "\", \"ph\": \"X\"") == std::string::npos)
+                continue;
+            const size_t tid = line.find("\"tid\": ") + 7;
+            tids.insert(line.substr(tid, line.find(',', tid) - tid));
+        }
+        return tids;
+    }
+
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+#ifdef LUTECONV_TRACE
+
+TEST_F(LuteConvFixture, Threads)
+{
+    using namespace luteconv;
+
+    {
+        TRACE_SPAN("before start");
+    }
+
+    Trace::Start();
+    {
+        TRACE_SPAN("outer", "detail \"quoted\"");
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 3; ++t)
+        {
+            workers.emplace_back([]()
+            {
+                TRACE_SPAN("worker");
+            });
+        }
+        for (auto & worker : workers)
+            worker.join();
+    }
+    const std::string trace = Write();
+
+    EXPECT_EQ(0U, trace.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["));
+    EXPECT_EQ(std::string::npos, trace.find("before start"));
+    EXPECT_NE(std::string::npos, trace.find("\"args\": {\"detail\": \"detail \\\"quoted\\\"\"}"));
+    EXPECT_EQ(1U, Tids(trace, "outer").size());
+    EXPECT_EQ(3U, Tids(trace, "worker").size());
+    EXPECT_EQ(0U, Tids(trace, "worker").count(*Tids(trace, "outer").begin()));
+    EXPECT_FALSE(Trace::Enabled());
+}
+
+TEST_F(LuteConvFixture, Convert)
+{
+    using namespace luteconv;
+
+    Options options;
+    options.m_srcFilename = m_sourceDir + "/examples/original/F_Cutting_galliard.mxl";
+    options.m_dstFilename = m_binaryDir + "/trace_test.musicxml";
+    options.m_dstTabTypeSet = true; // parse and generate, not passthrough
+    options.SetFormatFilename();
+
+    Trace::Start();
+    Converter converter;
+    converter.Convert(options);
+    const std::string trace = Write();
+
+    for (const char* name : {"Converter::Convert", "ParserMxl::Parse", "Unzipper::Unzip", "pugixml load",
+            "GenMusicXml::Generate", "GenMusicXml write", "XMLWriter print"})
+    {
+        EXPECT_EQ(1U, Tids(trace, name).size()) << name;
+    }
+}
+
+#endif // LUTECONV_TRACE
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include <gentabcode.h>
+#include <logger.h>
+#include <parserft3.h>
+#include <piecesynth.h>
+#include <workerpool.h>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+
+class LuteConvFixture: public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+#define XSTRINGIFY(s) STRINGIFY(s)
+#define STRINGIFY(s) #s
+        m_binaryDir = XSTRINGIFY(BINARY_DIR);
+        m_sourceDir = XSTRINGIFY(SOURCE_DIR);
+#undef STRINGIFY
+#undef XSTRINGIFY
+    }
+
+    // Write a synthetic TabCode file, return its filename
+    std::string Synthesize(const std::string& stem, int bars) const
+    {
+        using namespace luteconv;
+
+        PieceSynth synth;
+        synth.m_bars = bars;
+        Piece piece;
+        synth.Build(piece);
+        const std::string filename = m_binaryDir + "/" + stem + ".tc";
+        std::ofstream dst(filename.c_str());
+        GenTabCode().Generate(Options(), piece, dst);
+        return filename;
+    }
+
+    // Options to convert a file of the batch to musicxml
+    luteconv::Options BatchOptions(const std::string& srcFilename) const
+    {
+        luteconv::Options options;
+        options.m_batchDir = m_binaryDir;
+        options.m_dstFormat = luteconv::FormatMusicxml;
+        return options.BatchOptions(srcFilename);
+    }
+
+    std::string m_binaryDir;
+    std::string m_sourceDir;
+};
+
+TEST_F(LuteConvFixture, FixtureTest)
+{
+
+}
+
+TEST_F(LuteConvFixture, Convert)
+{
+    using namespace luteconv;
+
+    WorkerPool pool(2, 0.0);
+    pool.Add(BatchOptions(Synthesize("workerpool_small", 10)));
+    pool.Add(BatchOptions(Synthesize("workerpool_large", 1000)));
+    pool.Add(BatchOptions(m_sourceDir + "/examples/original/02_forlorne_hope_8C.ft3"));
+    pool.Add(BatchOptions(m_binaryDir + "/workerpool_missing.tc"));
+    pool.Run(true);
+
+    const auto & jobs = pool.Jobs();
+    ASSERT_EQ(4U, jobs.size());
+    EXPECT_EQ(0, jobs[1].m_order);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ("", jobs[i].m_error);
+        EXPECT_LT(0U, jobs[i].m_stats.m_bars);
+        EXPECT_EQ(jobs[i].m_options.m_srcFilename, jobs[i].m_stats.m_srcFilename);
+        EXPECT_FALSE(jobs[i].m_stats.m_stages.empty());
+        EXPECT_TRUE(std::ifstream(jobs[i].m_options.m_dstFilename.c_str()).good());
+    }
+    EXPECT_EQ("Error: Can't open " + jobs[3].m_options.m_srcFilename, jobs[3].m_error);
+    EXPECT_FALSE(jobs[3].m_crashed);
+}
+
+TEST_F(LuteConvFixture, Crash)
+{
+    using namespace luteconv;
+
+    // files named crash* crash their worker, the others report the worker's pid
+    WorkerPool pool(2, 0.0, [](WorkerPool::Job& job, bool)
+        {
+            if (job.m_options.m_srcFilename.find("crash") != std::string::npos)
+                raise(SIGSEGV);
+            job.m_stats.m_srcFilename = std::to_string(getpid());
+        });
+    for (int i = 0; i < 10; ++i)
+        pool.Add(BatchOptions(m_binaryDir + (i % 4 == 1 ? "/crash" : "/file") + std::to_string(i) + ".tc"));
+    pool.Run(true);
+
+    std::set<std::string> pids;
+    for (const auto & job : pool.Jobs())
+    {
+        if (job.m_options.m_srcFilename.find("crash") != std::string::npos)
+        {
+            EXPECT_TRUE(job.m_crashed);
+            EXPECT_EQ("Error: Worker crashed, signal " + std::to_string(SIGSEGV), job.m_error);
+        }
+        else
+        {
+            EXPECT_FALSE(job.m_crashed);
+            EXPECT_EQ("", job.m_error);
+            EXPECT_NE(std::to_string(getpid()), job.m_stats.m_srcFilename);
+            pids.insert(job.m_stats.m_srcFilename);
+        }
+    }
+
+    // workers are reused, two at the start and one after each crash
+    EXPECT_GE(4U, pids.size());
+}
+
+TEST_F(LuteConvFixture, Timeout)
+{
+    using namespace luteconv;
+
+    // hang* ignores its deadline and is killed, slow* stops at it
+    WorkerPool pool(2, 0.05, [](WorkerPool::Job& job, bool)
+        {
+            const std::string& filename = job.m_options.m_srcFilename;
+            if (filename.find("hang") != std::string::npos)
+                pause();
+            while (filename.find("slow") != std::string::npos)
+            {
+                Cancel::Check();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    pool.Add(BatchOptions(m_binaryDir + "/hang.tc"));
+    pool.Add(BatchOptions(m_binaryDir + "/slow.tc"));
+    pool.Add(BatchOptions(m_binaryDir + "/fast.tc"));
+    pool.Run(false);
+
+    const auto & jobs = pool.Jobs();
+    for (size_t i = 0; i < 2; ++i)
+    {
+        EXPECT_TRUE(jobs[i].m_timedOut);
+        EXPECT_FALSE(jobs[i].m_crashed);
+        EXPECT_EQ("Error: Timed out after 0.05 seconds", jobs[i].m_error);
+    }
+    EXPECT_EQ("", jobs[2].m_error);
+}
+
+TEST_F(LuteConvFixture, IdleWorkerKilled)
+{
+    using namespace luteconv;
+
+    // Linux process state: 'T' => stopped
+    const auto stopped = [](pid_t pid)
+        {
+            std::ifstream stat(("/proc/" + std::to_string(pid) + "/stat").c_str());
+            std::string field;
+            for (int i = 0; i < 3 && stat >> field; ++i)
+            {
+            }
+            return field == "T";
+        };
+
+    // The first file's worker is killed once it has returned its result and
+    // is idle, while the supervisor is stopped so that it can't send the next
+    // file first.  The one worker is restarted for the second file.
+    WorkerPool pool(1, 0.0, [&stopped](WorkerPool::Job& job, bool)
+        {
+            job.m_stats.m_srcFilename = std::to_string(getpid());
+            if (job.m_options.m_srcFilename.find("first") == std::string::npos)
+                return;
+
+            const pid_t supervisor = getppid();
+            const pid_t worker = getpid();
+            if (fork() == 0)
+            {
+                // the worker's pipes must close when it dies
+                for (int fd = 3; fd < 1024; ++fd)
+                    close(fd);
+                kill(supervisor, SIGSTOP);
+                while (!stopped(supervisor))
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                kill(worker, SIGKILL);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                kill(supervisor, SIGCONT);
+                _exit(0);
+            }
+            while (!stopped(supervisor))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+    pool.Add(BatchOptions(m_binaryDir + "/first.tc"));
+    pool.Add(BatchOptions(m_binaryDir + "/second.tc"));
+    pool.Run(true);
+
+    const auto & jobs = pool.Jobs();
+    EXPECT_EQ("", jobs[0].m_error);
+    EXPECT_EQ("", jobs[1].m_error);
+    EXPECT_EQ(0, jobs[0].m_order);
+    EXPECT_EQ(1, jobs[1].m_order);
+    EXPECT_FALSE(jobs[1].m_stats.m_srcFilename.empty());
+    EXPECT_NE(jobs[0].m_stats.m_srcFilename, jobs[1].m_stats.m_srcFilename);
+}
+
+TEST_F(LuteConvFixture, Logging)
+{
+    using namespace luteconv;
+
+    // each worker logs more records than the writer's ring holds, all are written
+    const std::string logFilename = m_binaryDir + "/workerpool_test.log";
+    std::remove(logFilename.c_str());
+    Logger::SetFile(logFilename);
+    WorkerPool pool(2, 0.0, [](WorkerPool::Job& job, bool)
+        {
+            LoggerScope loggerScope(job.m_options.m_logLevel, job.m_options.m_logFilter);
+            for (int i = 0; i < 6000; ++i)
+                LOGGER_WARNING << job.m_options.m_srcFilename << " record " << i;
+        });
+    for (int i = 0; i < 3; ++i)
+    {
+        Options options = BatchOptions(m_binaryDir + "/logging" + std::to_string(i) + ".tc");
+        options.m_logLevel = LogWarning;
+        pool.Add(options);
+    }
+    pool.Run(false);
+    Logger::SetFile("");
+
+    for (const auto & job : pool.Jobs())
+        EXPECT_EQ("", job.m_error);
+
+    std::ifstream log(logFilename.c_str());
+    std::string line;
+    size_t records{0};
+    size_t last{0};
+    while (std::getline(log, line))
+    {
+        if (line.find(" record ") != std::string::npos)
+            ++records;
+        if (line.find(" record 5999") != std::string::npos)
+            ++last;
+    }
+    EXPECT_EQ(18000U, records);
+    EXPECT_EQ(3U, last);
+}
+
+TEST_F(LuteConvFixture, Ft3Truncated)
+{
+    using namespace luteconv;
+
+    // truncations of a file parse or throw, none reads past the end: every byte
+    // of the header and first bars, then a sample
+    std::vector<uint8_t> ft3Image;
+    ParserFt3::Gunzip(m_sourceDir + "/examples/original/02_forlorne_hope_8C.ft3", ft3Image);
+    Options options;
+    for (size_t size = 0; size <= ft3Image.size(); size += size < 2048 ? 1 : 37)
+    {
+        const std::vector<uint8_t> truncated(ft3Image.cbegin(), ft3Image.cbegin() + size);
+        Piece piece;
+        try
+        {
+            ParserFt3().Parse(truncated, options, piece);
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}